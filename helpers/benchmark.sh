@@ -0,0 +1,366 @@
+#!/bin/bash
+# Launch benchmark for Protégé
+# © 2026 Damien Goutte-Gattat
+#
+# Copying and distribution of this file, with or without modification,
+# are permitted in any medium without royalty provided the copyright
+# notice and this notice are preserved.
+
+set -e
+
+runs=5
+sizes="0 1000 10000 100000"
+output=
+workdir=
+jre=
+config=
+run_timeout=300
+drop_caches=0
+protege_dir=
+
+xvfb_pid=
+protege_pid=
+
+die() {
+    echo "${0##*/}: $@" >&2
+    exit 1
+}
+
+cleanup() {
+    [ -n "$protege_pid" ] && kill -KILL $protege_pid 2>/dev/null
+    [ -n "$xvfb_pid" ] && kill $xvfb_pid 2>/dev/null
+    return 0
+}
+
+generate_ontology() {
+    # $1: number of classes
+    # $2: output file
+    # Classes form a tree with a branching factor of 8; every fourth
+    # class also has an existential restriction on one of 16 object
+    # properties, so that the reasoner-free load still has some axioms
+    # of each kind to index.
+    awk -v n=$1 'BEGIN {
+        print "Prefix(:=<http://example.org/benchmark#>)"
+        print "Prefix(rdfs:=<http://www.w3.org/2000/01/rdf-schema#>)"
+        printf "Ontology(<http://example.org/benchmark/%d>\n", n
+        for ( p = 0; p < 16; p++ ) {
+            printf "Declaration(ObjectProperty(:p%d))\n", p
+            printf "AnnotationAssertion(rdfs:label :p%d \"property %d\")\n", p, p
+        }
+        for ( i = 0; i < n; i++ ) {
+            printf "Declaration(Class(:C%d))\n", i
+            printf "AnnotationAssertion(rdfs:label :C%d \"class %d\")\n", i, i
+            if ( i > 0 )
+                printf "SubClassOf(:C%d :C%d)\n", i, int((i - 1) / 8)
+            if ( i > 0 && i % 4 == 0 )
+                printf "SubClassOf(:C%d ObjectSomeValuesFrom(:p%d :C%d))\n", i, i % 16, int(i / 3)
+        }
+        print ")"
+    }' > $2
+}
+
+start_xvfb() {
+    local n=99
+
+    while [ -e /tmp/.X$n-lock -o -e /tmp/.X11-unix/X$n ]; do
+        n=$((n + 1))
+    done
+
+    Xvfb :$n -screen 0 1920x1080x24 -nolisten tcp >/dev/null 2>&1 &
+    xvfb_pid=$!
+
+    for i in $(seq 50); do
+        [ -e /tmp/.X11-unix/X$n ] && break
+        kill -0 $xvfb_pid 2>/dev/null || die "Xvfb failed to start"
+        sleep 0.2
+    done
+    [ -e /tmp/.X11-unix/X$n ] || die "Xvfb did not start in time"
+
+    display=:$n
+}
+
+reset_state() {
+    # Start from a pristine user directory and bundle cache, as after
+    # a fresh installation.
+    rm -rf $bench_home $felix_cache
+    mkdir -p $bench_home/.Protege/conf
+    cp $workdir/jvm.conf $bench_home/.Protege/conf/jvm.conf
+
+    if [ $drop_caches -eq 1 ]; then
+        sync
+        echo 3 > /proc/sys/vm/drop_caches || die "Cannot drop the page cache"
+    fi
+}
+
+report_value() {
+    # $1: report file
+    # $2: key
+    sed -n "s/^ *\"$2\": \([0-9]*\),*$/\1/p" $1
+}
+
+run_protege() {
+    # $1: ontology file (may be empty)
+    # $2: report file
+    local elapsed=0
+
+    rm -f $2
+    env -u XDG_CACHE_HOME -u XDG_CONFIG_HOME -u XDG_DATA_HOME \
+        -u WAYLAND_DISPLAY -u XDG_SESSION_TYPE \
+        HOME=$bench_home DISPLAY=$display PROTEGE_SESSION_REPORT=$2 \
+        $app_dir/protege $1 >>$workdir/protege.log 2>&1 &
+    protege_pid=$!
+
+    # The report is written a first time as soon as Protégé is idle.
+    while ! grep -q time_to_idle_ms $2 2>/dev/null; do
+        if ! kill -0 $protege_pid 2>/dev/null; then
+            wait $protege_pid || true
+            protege_pid=
+            return 1
+        fi
+        if [ $elapsed -ge $((run_timeout * 10)) ]; then
+            kill -KILL $protege_pid 2>/dev/null
+            wait $protege_pid || true
+            protege_pid=
+            return 1
+        fi
+        sleep 0.1
+        elapsed=$((elapsed + 1))
+    done
+
+    # Let Java shut down normally, so that the final report (with the
+    # peak memory usage of the whole session) is written.
+    kill -TERM $protege_pid 2>/dev/null || true
+    wait $protege_pid || true
+    protege_pid=
+    return 0
+}
+
+record_run() {
+    # $1: size
+    # $2: phase (cold or warm)
+    # $3: run number
+    # $4: report file (absent if the run failed)
+    local key
+
+    [ -n "$first_run" ] || echo "," >> $workdir/runs.json
+    first_run=
+
+    printf '    {"size": %d, "phase": "%s", "run": %d' $1 $2 $3 >> $workdir/runs.json
+    if [ -f $4 ]; then
+        for key in time_to_jvm_ms time_to_window_ms time_to_idle_ms cpu_time_ms peak_rss_kb ; do
+            printf ', "%s": %s' $key $(report_value $4 $key | grep . || echo null) \
+                >> $workdir/runs.json
+        done
+        printf ', "ok": true}' >> $workdir/runs.json
+        printf '%d %s %s %s %s\n' $1 $2 \
+            $(report_value $4 time_to_window_ms | grep . || echo -) \
+            $(report_value $4 time_to_idle_ms | grep . || echo -) \
+            $(report_value $4 peak_rss_kb | grep . || echo -) >> $workdir/runs.txt
+    else
+        printf ', "ok": false}' >> $workdir/runs.json
+    fi
+}
+
+summarize() {
+    # Medians of the times, and largest peak memory usage, for each
+    # ontology size and phase. The load time of an ontology is the time
+    # to idle beyond that of a run without an ontology.
+    sort -k1,1n -k2,2 $workdir/runs.txt | awk '
+        function median(values, n,    i, j, t) {
+            for ( i = 2; i <= n; i++ )
+                for ( j = i; j > 1 && values[j - 1] > values[j]; j-- ) {
+                    t = values[j]; values[j] = values[j - 1]; values[j - 1] = t
+                }
+            return n % 2 ? values[(n + 1) / 2] : (values[n / 2] + values[n / 2 + 1]) / 2
+        }
+        function flush() {
+            if ( ! key ) return
+            split(key, k, " ")
+            w = nw ? median(window, nw) : "null"
+            i = ni ? median(idle, ni) : "null"
+            if ( k[1] == 0 && ni ) base[k[2]] = i
+            load = (k[1] > 0 && ni && k[2] in base) ? i - base[k[2]] : "null"
+            printf "%s    {\"size\": %d, \"phase\": \"%s\", \"runs\": %d, ", sep, k[1], k[2], n
+            printf "\"median_time_to_window_ms\": %s, \"median_time_to_idle_ms\": %s, ", w, i
+            printf "\"median_ontology_load_ms\": %s, \"max_peak_rss_kb\": %s}", load, rss ? rss : "null"
+            sep = ",\n"
+        }
+        {
+            if ( $1 " " $2 != key ) {
+                flush()
+                key = $1 " " $2; n = nw = ni = rss = 0
+                delete window; delete idle
+            }
+            n++
+            if ( $3 != "-" ) window[++nw] = $3
+            if ( $4 != "-" ) idle[++ni] = $4
+            if ( $5 != "-" && $5 > rss ) rss = $5
+        }
+        END { flush(); print "" }'
+}
+
+while [ -n "$1" ]; do
+    case "$1" in
+    -h|--help)
+        cat <<EOF
+Usage: $0 [options] <PROTEGE_DIR>
+
+Start Protégé repeatedly under a private Xvfb server, without and with
+generated ontologies of growing size, and report how long it takes to
+become usable.
+
+Options:
+  -r, --runs N        Number of cold and warm runs for each size (default: $runs).
+  -s, --sizes LIST    Ontology sizes, in classes; 0 for no ontology
+                      (default: "$sizes").
+  -j, --jre DIR       Use the JRE in DIR instead of the bundled one.
+  -c, --config FILE   Add the settings in FILE to the jvm.conf file.
+  -t, --timeout S     Give up on a run after S seconds (default: $run_timeout).
+  -d, --drop-caches   Drop the page cache before each cold run (needs root).
+  -w, --workdir DIR   Keep the working files in DIR (must not exist).
+  -o, --output FILE   Write the results to FILE (default: standard output).
+EOF
+        exit 0
+        ;;
+
+    -r|--runs)
+        [ -n "$2" ] || die "Missing argument for --runs"
+        runs=$2
+        shift 2
+        ;;
+
+    -s|--sizes)
+        [ -n "$2" ] || die "Missing argument for --sizes"
+        sizes=$2
+        shift 2
+        ;;
+
+    -j|--jre)
+        [ -n "$2" ] || die "Missing argument for --jre"
+        jre=$(realpath $2)
+        shift 2
+        ;;
+
+    -c|--config)
+        [ -n "$2" ] || die "Missing argument for --config"
+        config=$(realpath $2)
+        shift 2
+        ;;
+
+    -t|--timeout)
+        [ -n "$2" ] || die "Missing argument for --timeout"
+        run_timeout=$2
+        shift 2
+        ;;
+
+    -d|--drop-caches)
+        drop_caches=1
+        shift
+        ;;
+
+    -w|--workdir)
+        [ -n "$2" ] || die "Missing argument for --workdir"
+        workdir=$2
+        shift 2
+        ;;
+
+    -o|--output)
+        [ -n "$2" ] || die "Missing argument for --output"
+        output=$(realpath $2)
+        shift 2
+        ;;
+
+    *)
+        protege_dir=$1
+        shift
+        ;;
+    esac
+done
+
+[ -n "$protege_dir" ] || die "No Protégé directory specified"
+[ -x "$protege_dir/protege" ] || die "No protege launcher in $protege_dir"
+[ $runs -gt 0 ] 2>/dev/null || die "Invalid number of runs: $runs"
+type Xvfb >/dev/null 2>&1 || die "Xvfb is needed"
+
+if [ -n "$workdir" ]; then
+    [ ! -d "$workdir" ] || die "--workdir directory already exists!"
+    mkdir -p "$workdir"
+    workdir=$(realpath $workdir)
+    trap cleanup EXIT
+else
+    workdir=$(mktemp -d)
+    trap "cleanup; rm -rf $workdir" EXIT
+fi
+
+# Work on a copy of Protégé, so that its bundle cache can be removed
+# without touching the original installation.
+echo "Preparing Protégé..." >&2
+app_dir=$workdir/protege
+cp -a "$protege_dir" $app_dir
+bench_home=$workdir/home
+
+# The user configuration replaces the one of the installation, so start
+# from the latter. Java must use the private home directory as well.
+[ -f $app_dir/conf/jvm.conf ] && cp $app_dir/conf/jvm.conf $workdir/jvm.conf
+echo "append=-Duser.home=$bench_home" >> $workdir/jvm.conf
+[ -n "$jre" ] && echo "java_home=$jre" >> $workdir/jvm.conf
+[ -n "$config" ] && cat $config >> $workdir/jvm.conf
+
+mkdir -p $bench_home/.Protege/conf
+cp $workdir/jvm.conf $bench_home/.Protege/conf/jvm.conf
+HOME=$bench_home $app_dir/protege --diagnose --json > $workdir/environment.json \
+    || die "Cannot get the launch environment"
+felix_cache=$(sed -n '/"felix_cache": {/,/}/s/.*"path": "\(.*\)",*$/\1/p' $workdir/environment.json)
+case "$felix_cache" in
+$workdir/*)
+    ;;
+*)
+    echo "Bundle cache outside of $workdir, cold runs will not clear it" >&2
+    felix_cache=
+    ;;
+esac
+
+echo "Generating ontologies..." >&2
+mkdir -p $workdir/ontologies
+for size in $sizes ; do
+    [ $size -gt 0 ] && generate_ontology $size $workdir/ontologies/benchmark-$size.ofn
+done
+
+start_xvfb
+
+first_run=1
+: > $workdir/runs.json
+: > $workdir/runs.txt
+for size in $sizes ; do
+    ontology=
+    [ $size -gt 0 ] && ontology=$workdir/ontologies/benchmark-$size.ofn
+
+    for run in $(seq $runs); do
+        for phase in cold warm ; do
+            echo "Size $size, run $run, $phase start..." >&2
+            [ $phase = cold ] && reset_state
+            report=$workdir/report-$size-$phase-$run.json
+            run_protege "$ontology" $report || rm -f $report
+            record_run $size $phase $run $report
+        done
+    done
+done
+
+{
+    echo "{"
+    echo "  \"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\","
+    echo "  \"host\": \"$(uname -n)\","
+    echo "  \"kernel\": \"$(uname -r)\","
+    echo "  \"page_cache_dropped\": $([ $drop_caches -eq 1 ] && echo true || echo false),"
+    echo "  \"environment\":"
+    sed 's/^/  /' $workdir/environment.json
+    echo "  ,"
+    echo "  \"runs\": ["
+    cat $workdir/runs.json
+    echo ""
+    echo "  ],"
+    echo "  \"summary\": ["
+    summarize
+    echo "  ]"
+    echo "}"
+} > ${output:-/dev/stdout}
@@ -0,0 +1,684 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "diagnose.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ftw.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#if defined(PROTEGE_LINUX)
+#include <sys/vfs.h>
+#elif defined(PROTEGE_MACOS)
+#include <sys/param.h>
+#include <sys/mount.h>
+#endif
+
+#include <xmem.h>
+
+#include "util.h"
+
+#if defined(PROTEGE_LINUX)
+#include "display.h"
+#endif
+
+/*
+ * Output of the report, either as text or as JSON.
+ */
+struct report {
+    int json;
+    int sections;   /* Number of sections started so far. */
+    int fields;     /* Number of fields in the current section. */
+};
+
+/*
+ * Names of the launcher features, as in the configuration file.
+ */
+static const struct {
+    unsigned    flag;
+    const char *name;
+} features[] = {
+    { PROTEGE_FLAG_UI_AUTO_SCALING,     "ui_auto_scaling" },
+    { PROTEGE_FLAG_SUPERVISOR,          "supervisor" },
+    { PROTEGE_FLAG_HEAP_DUMPS,          "heap_dumps" },
+    { PROTEGE_FLAG_IDLE_MEMORY_RETURN,  "idle_memory_return" },
+    { PROTEGE_FLAG_PROFILE_PERF,        "profile_perf" },
+    { PROTEGE_FLAG_PIN_PERFORMANCE,     "cpu_pinning" },
+    { PROTEGE_FLAG_SCRATCH_DIR,         "scratch_dir" },
+    { PROTEGE_FLAG_PRELOAD,             "ontology_preload" },
+    { PROTEGE_FLAG_DECOMPRESS,          "ontology_decompress" },
+    { PROTEGE_FLAG_PLUGIN_SIZING,       "plugin_sizing" },
+    { PROTEGE_FLAG_PLUGIN_LIMITS,       "plugin_limits" },
+    { PROTEGE_FLAG_BUNDLE_INDEX,        "bundle_index" },
+    { PROTEGE_FLAG_FAST_EXIT,           "fast_exit" },
+    { PROTEGE_FLAG_FONT_CACHE,          "font_cache" },
+    { PROTEGE_FLAG_SESSION_REPORT,      "session_report" },
+    { 0,                                NULL }
+};
+
+static void
+print_json_string(const char *s)
+{
+    putchar('"');
+    for ( ; *s; s++ ) {
+        if ( *s == '"' || *s == '\\' )
+            printf("\\%c", *s);
+        else if ( *s == '\n' )
+            printf("\\n");
+        else if ( *s == '\t' )
+            printf("\\t");
+        else if ( (unsigned char) *s < 0x20 )
+            printf("\\u%04x", *s);
+        else
+            putchar(*s);
+    }
+    putchar('"');
+}
+
+static void
+begin_section(struct report *r, const char *key, const char *title)
+{
+    if ( r->json )
+        printf("%s  \"%s\": {", r->sections ? "\n  },\n" : "{\n", key);
+    else
+        printf("%s%s:\n", r->sections ? "\n" : "", title);
+
+    r->sections += 1;
+    r->fields = 0;
+}
+
+static void
+end_report(struct report *r)
+{
+    if ( r->json )
+        printf("%s", r->sections ? "\n  }\n}\n" : "{}\n");
+}
+
+/*
+ * Start a field; in JSON, the caller then prints the value.
+ */
+static void
+begin_field(struct report *r, const char *key, const char *label)
+{
+    if ( r->json )
+        printf("%s\n    \"%s\": ", r->fields ? "," : "", key);
+    else
+        printf("  %-24s ", label);
+
+    r->fields += 1;
+}
+
+static void
+add_string(struct report *r, const char *key, const char *label, const char *value)
+{
+    begin_field(r, key, label);
+    if ( r->json && value )
+        print_json_string(value);
+    else
+        printf("%s", value ? value : r->json ? "null" : "-");
+    if ( ! r->json )
+        putchar('\n');
+}
+
+static void
+add_number(struct report *r, const char *key, const char *label, long long value)
+{
+    begin_field(r, key, label);
+    printf(r->json ? "%lld" : "%lld\n", value);
+}
+
+static void
+add_boolean(struct report *r, const char *key, const char *label, int value)
+{
+    begin_field(r, key, label);
+    printf(r->json ? "%s" : "%s\n", value ? (r->json ? "true" : "yes") : (r->json ? "false" : "no"));
+}
+
+/*
+ * Add an amount of memory, in bytes in JSON and in megabytes in text;
+ * 0 stands for an unknown or absent amount.
+ */
+static void
+add_memory(struct report *r, const char *key, const char *label, unsigned long long value)
+{
+    begin_field(r, key, label);
+    if ( value == 0 )
+        printf(r->json ? "null" : "-\n");
+    else
+        printf(r->json ? "%llu" : "%llu MB\n", r->json ? value : value / (1024 * 1024));
+}
+
+static void
+add_list(struct report *r, const char *key, const char *label, char **values, size_t n)
+{
+    size_t i;
+
+    begin_field(r, key, label);
+    if ( r->json )
+        putchar('[');
+    for ( i = 0; i < n; i++ ) {
+        if ( r->json ) {
+            printf("%s\n      ", i ? "," : "");
+            print_json_string(values[i]);
+        }
+        else
+            printf("%s%s\n", i ? "                           " : "", values[i]);
+    }
+    if ( r->json )
+        printf(n ? "\n    ]" : "]");
+    else if ( n == 0 )
+        printf("-\n");
+}
+
+/*
+ * Find the value of an option in the final list of options.
+ */
+static const char *
+get_vm_option(char **options, const char *prefix)
+{
+    const char *value = NULL;
+    size_t n;
+
+    /* The last occurrence wins, as with the JVM. */
+    for ( n = 0; options[n]; n++ )
+        if ( strncmp(options[n], prefix, strlen(prefix)) == 0 )
+            value = options[n] + strlen(prefix);
+
+    return value;
+}
+
+/*
+ * Get the type of the filesystem a file is on.
+ *
+ * Returns a static string, or NULL if the type cannot be determined.
+ */
+static const char *
+get_filesystem_type(const char *path)
+{
+    struct statfs fs;
+#if defined(PROTEGE_LINUX)
+    static char buffer[32];
+    static const struct {
+        unsigned long   magic;
+        const char     *name;
+    } types[] = {
+        { 0xef53,       "ext4" },
+        { 0x58465342,   "xfs" },
+        { 0x9123683e,   "btrfs" },
+        { 0x2fc12fc1,   "zfs" },
+        { 0x01021994,   "tmpfs" },
+        { 0x858458f6,   "ramfs" },
+        { 0x794c7630,   "overlay" },
+        { 0x73717368,   "squashfs" },
+        { 0x6969,       "nfs" },
+        { 0xff534d42,   "cifs" },
+        { 0xfe534d42,   "smb2" },
+        { 0x517b,       "smb" },
+        { 0x65735546,   "fuse" },
+        { 0x01021997,   "9p" },
+        { 0x786f4256,   "vboxsf" },
+        { 0x5346544e,   "ntfs" },
+        { 0x4d44,       "vfat" },
+        { 0x2011bab0,   "exfat" },
+        { 0,            NULL }
+    };
+    size_t n;
+#endif
+
+    if ( statfs(path, &fs) == -1 )
+        return NULL;
+
+#if defined(PROTEGE_LINUX)
+    for ( n = 0; types[n].name; n++ )
+        if ( (unsigned long) fs.f_type == types[n].magic )
+            return types[n].name;
+
+    (void) snprintf(buffer, sizeof(buffer), "0x%lx", (unsigned long) fs.f_type);
+    return buffer;
+#else
+    return fs.f_fstypename;
+#endif
+}
+
+/*
+ * Read the first line of a file.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+read_first_line(const char *path, char *buffer, size_t len)
+{
+    FILE *f;
+    int ret = -1;
+
+    if ( (f = fopen(path, "r")) ) {
+        if ( get_line(f, buffer, len) >= 0 )
+            ret = 0;
+        fclose(f);
+    }
+
+    return ret;
+}
+
+static void
+report_launcher(struct report *r, const char *app_dir, struct option_list *list)
+{
+    char *conf, *enabled[32];
+    size_t n, count = 0;
+
+    begin_section(r, "launcher", "Launcher");
+    add_string(r, "version", "Version:", PACKAGE_VERSION);
+    add_string(r, "application_directory", "Application directory:", app_dir);
+    conf = find_configuration_file(app_dir);
+    add_string(r, "configuration_file", "Configuration file:", conf);
+    free(conf);
+
+    for ( n = 0; features[n].name; n++ )
+        if ( list->flags & features[n].flag )
+            enabled[count++] = (char *) features[n].name;
+    add_list(r, "features", "Features:", enabled, count);
+}
+
+static void
+report_java(struct report *r, const char *java_home, const struct jre_info *jre)
+{
+    char version[32];
+
+    begin_section(r, "java", "Java");
+    add_string(r, "home", "Home:", java_home);
+    if ( jre->version ) {
+        (void) snprintf(version, sizeof(version), "%u.%u.%u", jre->version / 1000000,
+                        jre->version / 1000 % 1000, jre->version % 1000);
+        add_string(r, "version", "Version:", version);
+    }
+    else
+        add_string(r, "version", "Version:", NULL);
+    add_string(r, "implementor", "Implementor:", jre->implementor);
+}
+
+static void
+report_memory(struct report *r, char **options)
+{
+    const char *value;
+#if defined(PROTEGE_LINUX)
+    char buffer[256], *start, *end;
+#endif
+
+    begin_section(r, "memory", "Memory");
+    add_memory(r, "physical", "Physical memory:", get_physical_memory());
+#if defined(PROTEGE_LINUX)
+    add_memory(r, "cgroup_limit", "Control group limit:", get_cgroup_memory_limit());
+#endif
+    value = get_vm_option(options, "-Xmx");
+    add_memory(r, "max_heap", "Maximal heap:", value ? get_memory_amount(value) : 0);
+    value = get_vm_option(options, "-Xms");
+    add_memory(r, "initial_heap", "Initial heap:", value ? get_memory_amount(value) : 0);
+
+#if defined(PROTEGE_LINUX)
+    /* The active mode is the one within brackets. */
+    if ( read_first_line("/sys/kernel/mm/transparent_hugepage/enabled", buffer, sizeof(buffer)) == 0
+            && (start = strchr(buffer, '[')) && (end = strchr(start, ']')) ) {
+        *end = '\0';
+        add_string(r, "thp_enabled", "Transparent huge pages:", start + 1);
+    }
+    else
+        add_string(r, "thp_enabled", "Transparent huge pages:", NULL);
+
+    if ( read_first_line("/sys/kernel/mm/transparent_hugepage/defrag", buffer, sizeof(buffer)) == 0
+            && (start = strchr(buffer, '[')) && (end = strchr(start, ']')) ) {
+        *end = '\0';
+        add_string(r, "thp_defrag", "Huge pages defrag:", start + 1);
+    }
+    else
+        add_string(r, "thp_defrag", "Huge pages defrag:", NULL);
+#endif
+}
+
+#if defined(PROTEGE_LINUX)
+
+#define MAX_NUMA_NODES  64
+
+/*
+ * Describe the NUMA nodes of the system: their CPUs and memory.
+ */
+static void
+report_numa(struct report *r)
+{
+    char path[256], cpus[1024], line[256], *nodes[MAX_NUMA_NODES];
+    unsigned long long memory;
+    size_t n = 0, i;
+    int node;
+    FILE *f;
+
+    for ( node = 0; node < MAX_NUMA_NODES; node++ ) {
+        (void) snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        if ( read_first_line(path, cpus, sizeof(cpus)) == -1 )
+            continue;
+
+        memory = 0;
+        (void) snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/meminfo", node);
+        if ( (f = fopen(path, "r")) ) {
+            while ( get_line(f, line, sizeof(line)) >= 0 )
+                if ( sscanf(line, "Node %*d MemTotal: %llu kB", &memory) == 1 )
+                    break;
+            fclose(f);
+        }
+
+        nodes[n] = NULL;
+        (void) xasprintf(&nodes[n++], "node%d: CPUs %s, %llu MB", node,
+                         cpus[0] ? cpus : "none", memory / 1024);
+    }
+
+    add_list(r, "numa_nodes", "NUMA nodes:", nodes, n);
+    for ( i = 0; i < n; i++ )
+        free(nodes[i]);
+}
+#endif
+
+static void
+report_cpu(struct report *r, struct option_list *list, char **options)
+{
+#if defined(PROTEGE_LINUX)
+    struct cpu_topology topology;
+    char *cpus;
+#endif
+    const char *value;
+
+    begin_section(r, "cpu", "Processors");
+    add_number(r, "online", "Online CPUs:", sysconf(_SC_NPROCESSORS_ONLN));
+#if defined(PROTEGE_LINUX)
+    add_string(r, "cpu_set", "Configured CPU set:", list->resources.cpu_set);
+    if ( get_cpu_topology(list->resources.cpu_set, &topology) == 0 ) {
+        cpus = format_cpu_list(&topology.available);
+        add_string(r, "available", "Available CPUs:", cpus);
+        free(cpus);
+        cpus = format_cpu_list(&topology.performance);
+        add_string(r, "performance", "Performance cores:", cpus);
+        free(cpus);
+        add_boolean(r, "heterogeneous", "Heterogeneous:", topology.heterogeneous);
+    }
+    report_numa(r);
+#else
+    (void) list;
+#endif
+    value = get_vm_option(options, "-XX:ActiveProcessorCount=");
+    add_string(r, "active_processor_count", "Java processor count:", value);
+}
+
+#if defined(PROTEGE_LINUX)
+static void
+report_display(struct report *r)
+{
+    static const struct {
+        unsigned    feature;
+        char       *name;
+    } names[] = {
+        { DISPLAY_REMOTE,   "remote" },
+        { DISPLAY_XRENDER,  "xrender" },
+        { DISPLAY_GLX,      "glx" },
+        { DISPLAY_WAYLAND,  "xwayland" },
+        { DISPLAY_VIRTUAL,  "virtual" },
+        { 0,                NULL }
+    };
+    int hres, vres, i;
+    unsigned features;
+    char dpi[32], *values[5];
+    size_t n = 0;
+
+    begin_section(r, "display", "Display");
+    add_string(r, "x11_display", "X11 display:", getenv("DISPLAY"));
+    add_string(r, "wayland_display", "Wayland display:", getenv("WAYLAND_DISPLAY"));
+    add_string(r, "session_type", "Session type:", getenv("XDG_SESSION_TYPE"));
+    if ( getenv("DISPLAY") && get_screen_dpi(&hres, &vres) == 0 ) {
+        (void) snprintf(dpi, sizeof(dpi), "%dx%d", hres, vres);
+        add_string(r, "dpi", "Resolution (DPI):", dpi);
+    }
+    else
+        add_string(r, "dpi", "Resolution (DPI):", NULL);
+
+    if ( get_display_features(&features) == 0 )
+        for ( i = 0; names[i].name; i++ )
+            if ( features & names[i].feature )
+                values[n++] = names[i].name;
+    add_list(r, "features", "Display features:", values, n);
+}
+#endif
+
+/*
+ * Describe the class data sharing archives of the JRE, which allow
+ * Java to start faster.
+ */
+static void
+report_cds(struct report *r, const char *java_home, char **options)
+{
+    static const char *dirs[] = { "/lib/server", "/lib/amd64/server",
+                                  "/lib/aarch64/server", "/jre/lib/amd64/server", NULL };
+    const char *value;
+    char *path = NULL, *nocoops = NULL;
+    struct stat st;
+    size_t n;
+    unsigned long long size = 0, nocoops_size = 0;
+
+    for ( n = 0; dirs[n] && size == 0; n++ ) {
+        free(path);
+        path = NULL;
+        (void) xasprintf(&path, "%s%s/classes.jsa", java_home, dirs[n]);
+        if ( stat(path, &st) == 0 )
+            size = st.st_size;
+    }
+    *strrchr(path, '/') = '\0';
+
+    if ( size ) {
+        /* Archive used when the heap is too large for compressed oops. */
+        (void) xasprintf(&nocoops, "%s/classes_nocoops.jsa", path);
+        if ( stat(nocoops, &st) == 0 )
+            nocoops_size = st.st_size;
+        free(nocoops);
+    }
+
+    begin_section(r, "cds", "Class data sharing");
+    add_string(r, "directory", "Archive directory:", size ? path : NULL);
+    add_memory(r, "default_archive", "Default archive:", size);
+    add_memory(r, "nocoops_archive", "Archive without coops:", nocoops_size);
+    value = get_vm_option(options, "-XX:SharedArchiveFile=");
+    add_string(r, "archive_file", "Application archive:", value);
+    if ( value )
+        add_boolean(r, "archive_file_exists", "Application archive found:", stat(value, &st) == 0);
+    value = get_vm_option(options, "-Xshare:");
+    add_string(r, "sharing", "Sharing mode:", value ? value : "auto");
+
+    free(path);
+}
+
+/*
+ * Get the directory of the Felix bundle cache: from the system
+ * property, or from the Protégé configuration file, or the default
+ * (relative to the current directory, i.e. the application directory).
+ */
+static char *
+get_felix_cache(const char *app_dir, char **options)
+{
+    const char *value, *home, *tmpdir;
+    char *conf = NULL, line[1024], *start, *end, *cache = NULL;
+    FILE *f;
+
+    if ( (value = get_vm_option(options, "-Dorg.osgi.framework.storage=")) )
+        cache = xstrdup(value);
+    else {
+        (void) xasprintf(&conf, "%s/conf/config.xml", app_dir);
+        if ( (f = fopen(conf, "r")) ) {
+            while ( ! cache && get_line(f, line, sizeof(line)) >= 0 ) {
+                if ( ! strstr(line, "\"org.osgi.framework.storage\"")
+                        || ! (start = strstr(line, "value=\""))
+                        || ! (end = strchr(start + 7, '"')) )
+                    continue;
+                *end = '\0';
+                cache = xstrdup(start + 7);
+            }
+            fclose(f);
+        }
+        free(conf);
+    }
+
+    if ( ! cache )
+        (void) xasprintf(&cache, "%s/felix-cache", app_dir);
+    else if ( strncmp(cache, "${user.home}", 12) == 0 && (home = getenv("HOME")) ) {
+        conf = cache;
+        cache = NULL;
+        (void) xasprintf(&cache, "%s%s", home, conf + 12);
+        free(conf);
+    }
+    else if ( strncmp(cache, "${java.io.tmpdir}", 17) == 0 ) {
+        if ( ! (tmpdir = get_vm_option(options, "-Djava.io.tmpdir=")) )
+            tmpdir = "/tmp";
+        conf = cache;
+        cache = NULL;
+        (void) xasprintf(&cache, "%s%s", tmpdir, conf + 17);
+        free(conf);
+    }
+    else if ( cache[0] != '/' ) {
+        conf = cache;
+        cache = NULL;
+        (void) xasprintf(&cache, "%s/%s", app_dir, conf);
+        free(conf);
+    }
+
+    return cache;
+}
+
+static unsigned long long cache_size;
+static unsigned cache_bundles;
+
+static int
+add_cache_file(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    if ( type == FTW_F )
+        cache_size += st->st_size;
+    else if ( type == FTW_D && ftw->level == 1
+              && strncmp(path + ftw->base, "bundle", 6) == 0 )
+        cache_bundles += 1;
+
+    return 0;
+}
+
+static void
+report_felix_cache(struct report *r, const char *cache)
+{
+    struct stat st;
+    int exists = stat(cache, &st) == 0;
+
+    cache_size = 0;
+    cache_bundles = 0;
+    if ( exists )
+        (void) nftw(cache, add_cache_file, 16, FTW_PHYS);
+
+    begin_section(r, "felix_cache", "Bundle cache");
+    add_string(r, "path", "Directory:", cache);
+    add_boolean(r, "exists", "Present:", exists);
+    if ( exists ) {
+        add_number(r, "bundles", "Cached bundles:", cache_bundles);
+        add_memory(r, "size", "Size:", cache_size);
+    }
+}
+
+static void
+report_filesystems(struct report *r, const char *app_dir, const char *java_home,
+                   const char *cache, char **options)
+{
+    const char *tmpdir, *home = getenv("HOME");
+
+    if ( ! (tmpdir = get_vm_option(options, "-Djava.io.tmpdir=")) )
+        tmpdir = "/tmp";
+
+    begin_section(r, "filesystems", "Filesystems");
+    add_string(r, "home", "Home directory:", home ? get_filesystem_type(home) : NULL);
+    add_string(r, "application", "Application directory:", get_filesystem_type(app_dir));
+    add_string(r, "java", "Java:", get_filesystem_type(java_home));
+    add_string(r, "temporary", "Temporary files:", get_filesystem_type(tmpdir));
+    add_string(r, "felix_cache", "Bundle cache:", get_filesystem_type(cache));
+}
+
+/**
+ * Print a report of the environment Protégé would run in: the JRE, the
+ * final options for the virtual machine, and the characteristics of
+ * the system that matter for performance. Nothing is started.
+ *
+ * @param app_dir    The directory where Protégé is installed.
+ * @param java_home  The directory of the JRE.
+ * @param jre        Information about the JRE.
+ * @param vm_options The final, NULL-terminated list of Java options.
+ * @param list       The launcher options.
+ * @param json       If non-zero, print the report as JSON instead of
+ *                   plain text.
+ *
+ * @return The exit code for the launcher.
+ */
+int
+print_diagnosis(const char *app_dir, const char *java_home, const struct jre_info *jre,
+                char **vm_options, struct option_list *list, int json)
+{
+    struct report r = { json, 0, 0 };
+    char *cache;
+    size_t n;
+
+    report_launcher(&r, app_dir, list);
+    report_java(&r, java_home, jre);
+
+    begin_section(&r, "options", "Java options");
+    for ( n = 0; vm_options[n]; n++ ) ;
+    add_list(&r, "vm_options", "Options:", vm_options, n);
+
+    report_memory(&r, vm_options);
+    report_cpu(&r, list, vm_options);
+#if defined(PROTEGE_LINUX)
+    report_display(&r);
+#endif
+    report_cds(&r, java_home, vm_options);
+
+    cache = get_felix_cache(app_dir, vm_options);
+    report_felix_cache(&r, cache);
+    report_filesystems(&r, app_dir, java_home, cache, vm_options);
+    free(cache);
+
+    end_report(&r);
+
+    return EXIT_SUCCESS;
+}
+
+#endif
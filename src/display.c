@@ -0,0 +1,977 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "display.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+
+#include <xmem.h>
+
+#include "util.h"
+
+/* Reference resolution, corresponding to a scale factor of 1. */
+#define BASE_DPI            96.0
+
+/* How long we are willing to wait for the X server, in seconds. */
+#define X_QUERY_TIMEOUT     2
+
+/* How long a cached resolution or set of features remains valid, in
+ * seconds. */
+#define DISPLAY_CACHE_TTL       (24 * 60 * 60)
+
+/* Maximal number of displays remembered in each cache. */
+#define DISPLAY_CACHE_ENTRIES   16
+
+#define DPI_CACHE_FILE          "dpi"
+
+/* Where local X servers create their sockets. */
+#define X_SOCKET_DIR            "/tmp/.X11-unix"
+#define FEATURES_CACHE_FILE     "display"
+
+
+/*
+ * Functions from libX11, which is loaded dynamically so that the
+ * launcher does not depend on it.
+ */
+struct xlib {
+    void       *handle;
+    Display *  (*open_display)(const char *);
+    int        (*close_display)(Display *);
+    char *     (*resource_manager_string)(Display *);
+    Bool       (*query_extension)(Display *, const char *, int *, int *, int *);
+    Atom       (*intern_atom)(Display *, const char *, Bool);
+    int        (*select_input)(Display *, Window, long);
+    int        (*pending)(Display *);
+    int        (*next_event)(Display *, XEvent *);
+    int        (*get_window_property)(Display *, Window, Atom, long, long, Bool, Atom,
+                                      Atom *, int *, unsigned long *, unsigned long *,
+                                      unsigned char **);
+    Status     (*get_window_attributes)(Display *, Window, XWindowAttributes *);
+    int        (*free)(void *);
+    XErrorHandler
+               (*set_error_handler)(XErrorHandler);
+};
+
+/*
+ * Load libX11.
+ *
+ * Returns 0 if successful, or -1 if the library or one of the needed
+ * functions is not available.
+ */
+static int
+load_xlib(struct xlib *xlib)
+{
+    if ( ! (xlib->handle = dlopen("libX11.so.6", RTLD_LAZY)) )
+        return -1;
+
+    xlib->open_display = (Display * (*)(const char *)) dlsym(xlib->handle, "XOpenDisplay");
+    xlib->close_display = (int (*)(Display *)) dlsym(xlib->handle, "XCloseDisplay");
+    xlib->resource_manager_string = (char * (*)(Display *)) dlsym(xlib->handle,
+                                                                  "XResourceManagerString");
+    xlib->query_extension = (Bool (*)(Display *, const char *, int *, int *, int *))
+        dlsym(xlib->handle, "XQueryExtension");
+    xlib->intern_atom = (Atom (*)(Display *, const char *, Bool)) dlsym(xlib->handle,
+                                                                      "XInternAtom");
+    xlib->select_input = (int (*)(Display *, Window, long)) dlsym(xlib->handle, "XSelectInput");
+    xlib->pending = (int (*)(Display *)) dlsym(xlib->handle, "XPending");
+    xlib->next_event = (int (*)(Display *, XEvent *)) dlsym(xlib->handle, "XNextEvent");
+    xlib->get_window_property = (int (*)(Display *, Window, Atom, long, long, Bool, Atom,
+                                         Atom *, int *, unsigned long *, unsigned long *,
+                                         unsigned char **)) dlsym(xlib->handle,
+                                                                  "XGetWindowProperty");
+    xlib->get_window_attributes = (Status (*)(Display *, Window, XWindowAttributes *))
+        dlsym(xlib->handle, "XGetWindowAttributes");
+    xlib->free = (int (*)(void *)) dlsym(xlib->handle, "XFree");
+    xlib->set_error_handler = (XErrorHandler (*)(XErrorHandler)) dlsym(xlib->handle,
+                                                                        "XSetErrorHandler");
+
+    if ( ! xlib->open_display || ! xlib->close_display || ! xlib->resource_manager_string
+            || ! xlib->query_extension || ! xlib->intern_atom || ! xlib->select_input
+            || ! xlib->pending || ! xlib->next_event || ! xlib->get_window_property
+            || ! xlib->get_window_attributes || ! xlib->free || ! xlib->set_error_handler ) {
+        dlclose(xlib->handle);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Look for a Xft.dpi resource in a string containing X resources, one
+ * per line, as found in the RESOURCE_MANAGER property or in a
+ * ~/.Xresources file.
+ *
+ * Returns 0 if the resource was found, otherwise -1.
+ */
+static int
+parse_xft_dpi(const char *resources, double *dpi)
+{
+    const char *line;
+    double value;
+
+    for ( line = resources; line; line = strchr(line, '\n') ) {
+        if ( *line == '\n' )
+            line += 1;
+        while ( *line == ' ' || *line == '\t' )
+            line += 1;
+
+        if ( strncmp(line, "Xft.dpi:", 8) == 0
+                && sscanf(line + 8, "%lf", &value) == 1 && value > 0 ) {
+            *dpi = value;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Get the resolution from the scaling factors that toolkits honour,
+ * and that desktop environments often set in the session environment.
+ */
+static int
+get_dpi_from_environment(double *dpi)
+{
+    const char *value;
+    double factor;
+
+    if ( (value = getenv("GDK_SCALE")) && sscanf(value, "%lf", &factor) == 1 && factor > 0 ) {
+        *dpi = factor * BASE_DPI;
+        return 0;
+    }
+
+    if ( (value = getenv("QT_SCALE_FACTOR")) && sscanf(value, "%lf", &factor) == 1 && factor > 0 ) {
+        *dpi = factor * BASE_DPI;
+        return 0;
+    }
+
+    /* Either a list of factors, or a list of screen=factor pairs;
+     * we only consider the first screen. */
+    if ( (value = getenv("QT_SCREEN_SCALE_FACTORS")) ) {
+        const char *equal = strchr(value, '='), *semicolon = strchr(value, ';');
+
+        if ( equal && (! semicolon || equal < semicolon) )
+            value = equal + 1;
+
+        if ( sscanf(value, "%lf", &factor) == 1 && factor > 0 ) {
+            *dpi = factor * BASE_DPI;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Get the Xft.dpi resource from the user's resource files, which are
+ * usually loaded into the X server at the beginning of the session.
+ */
+static int
+get_dpi_from_resource_files(double *dpi)
+{
+    const char *home, *files[] = { ".Xresources", ".Xdefaults", NULL };
+    char *path, line[512];
+    FILE *f;
+    int i, ret = -1;
+
+    if ( ! (home = getenv("HOME")) )
+        return -1;
+
+    for ( i = 0; files[i] && ret == -1; i++ ) {
+        path = NULL;
+        (void) xasprintf(&path, "%s/%s", home, files[i]);
+        if ( (f = fopen(path, "r")) ) {
+            while ( ! feof(f) && ret == -1 )
+                if ( get_line(f, line, sizeof(line)) > 0 )
+                    ret = parse_xft_dpi(line, dpi);
+            fclose(f);
+        }
+        free(path);
+    }
+
+    return ret;
+}
+
+/*
+ * Get a value from a INI-style configuration file, as used by KDE.
+ */
+static int
+get_config_value(const char *file, const char *section, const char *key,
+                 double *value)
+{
+    const char *config_home;
+    char *path = NULL, line[512];
+    FILE *f;
+    int in_section = 0, ret = -1;
+    size_t key_len = strlen(key);
+
+    if ( (config_home = getenv("XDG_CONFIG_HOME")) && config_home[0] == '/' )
+        (void) xasprintf(&path, "%s/%s", config_home, file);
+    else if ( (config_home = getenv("HOME")) )
+        (void) xasprintf(&path, "%s/.config/%s", config_home, file);
+    else
+        return -1;
+
+    if ( (f = fopen(path, "r")) ) {
+        while ( ! feof(f) && ret == -1 ) {
+            if ( get_line(f, line, sizeof(line)) <= 0 )
+                continue;
+
+            if ( line[0] == '[' )
+                in_section = strcmp(line, section) == 0;
+            else if ( in_section && strncmp(line, key, key_len) == 0
+                    && line[key_len] == '=' && sscanf(line + key_len + 1, "%lf", value) == 1 )
+                ret = 0;
+        }
+        fclose(f);
+    }
+    free(path);
+
+    return ret;
+}
+
+/*
+ * Get the scaling factor set by the desktop environment in its own
+ * configuration files. On Wayland, the X server (XWayland) may be
+ * scaled as a whole, in which case it reports a resolution of 96 DPI
+ * even on HiDPI screens.
+ */
+static int
+get_dpi_from_desktop_settings(double *dpi)
+{
+    double factor;
+
+    if ( getenv("WAYLAND_DISPLAY")
+            && get_config_value("kwinrc", "[Xwayland]", "Scale", &factor) == 0 && factor > 0 ) {
+        *dpi = factor * BASE_DPI;
+        return 0;
+    }
+
+    if ( get_config_value("kdeglobals", "[KScreen]", "ScaleFactor", &factor) == 0
+            && factor > 0 ) {
+        *dpi = factor * BASE_DPI;
+        return 0;
+    }
+
+    return -1;
+}
+
+/*
+ * Get a string identifying the display we are running on. The display
+ * name alone is not enough, since the same display number is reused:
+ * for a display forwarded through SSH, by different clients; for a
+ * local display, by successive X servers (e.g. a restarted server, or
+ * Xvfb and VNC servers started on demand), which we tell apart by the
+ * socket they listen on.
+ */
+static char *
+get_display_identity(void)
+{
+    const char *display, *client;
+    char *identity = NULL, *socket_path = NULL;
+    struct stat st;
+    unsigned number;
+    size_t len;
+
+    if ( ! (display = getenv("DISPLAY")) )
+        return NULL;
+
+    if ( (client = getenv("SSH_CLIENT")) && display[0] != ':' ) {
+        len = strcspn(client, " ");
+        (void) xasprintf(&identity, "%s@%.*s", display, (int) len, client);
+    }
+    else if ( sscanf(display, ":%u", &number) == 1
+                || sscanf(display, "unix:%u", &number) == 1 ) {
+        (void) xasprintf(&socket_path, X_SOCKET_DIR "/X%u", number);
+        if ( stat(socket_path, &st) == 0 )
+            (void) xasprintf(&identity, "%s#%llu-%lld", display,
+                             (unsigned long long) st.st_ino, (long long) st.st_ctime);
+        else
+            identity = xstrdup(display);
+        free(socket_path);
+    }
+    else
+        identity = xstrdup(display);
+
+    return identity;
+}
+
+/*
+ * Get the pathname to one of the display cache files.
+ */
+static char *
+get_display_cache_file(const char *name)
+{
+    char *dir, *path = NULL;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) xasprintf(&path, "%s/%s", dir, name);
+        free(dir);
+    }
+
+    return path;
+}
+
+/*
+ * Look for a cached value for the specified display. Each line of a
+ * cache file contains the identity of a display, the cached value
+ * (which may contain spaces), and the time it was stored.
+ *
+ * Returns 0 if a value that has not expired was found, otherwise -1.
+ */
+static int
+get_from_cache(const char *file, const char *identity, char *value, size_t len)
+{
+    char *path, *last, line[512], name[256];
+    FILE *f;
+    long long timestamp;
+    int offset, ret = -1;
+
+    if ( ! (path = get_display_cache_file(file)) )
+        return -1;
+
+    if ( (f = fopen(path, "r")) ) {
+        while ( ! feof(f) && ret == -1 ) {
+            offset = 0;
+            if ( get_line(f, line, sizeof(line)) > 0
+                    && sscanf(line, "%255s %n", name, &offset) == 1 && offset > 0
+                    && strcmp(name, identity) == 0
+                    && (last = strrchr(line, ' ')) && last >= line + offset
+                    && sscanf(last, "%lld", &timestamp) == 1
+                    && time(NULL) - timestamp < DISPLAY_CACHE_TTL
+                    && (size_t) (last - line - offset) < len ) {
+                memcpy(value, line + offset, last - line - offset);
+                value[last - line - offset] = '\0';
+                ret = 0;
+            }
+        }
+        fclose(f);
+    }
+    free(path);
+
+    return ret;
+}
+
+/*
+ * Store a value for the specified display in the cache. The cache is
+ * rewritten with the new entry first, followed by the most recent
+ * entries for other displays.
+ */
+static void
+store_in_cache(const char *file, const char *identity, const char *value)
+{
+    char *path, *tmp_path = NULL, *dir, line[512], name[256];
+    FILE *in, *out;
+    int n = 1;
+
+    if ( ! (path = get_display_cache_file(file)) )
+        return;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) create_directory(dir);
+        free(dir);
+    }
+
+    (void) xasprintf(&tmp_path, "%s.%ld", path, (long) getpid());
+    if ( (out = fopen(tmp_path, "w")) ) {
+        fprintf(out, "%s %s %lld\n", identity, value, (long long) time(NULL));
+
+        if ( (in = fopen(path, "r")) ) {
+            while ( ! feof(in) && n < DISPLAY_CACHE_ENTRIES ) {
+                if ( get_line(in, line, sizeof(line)) > 0
+                        && sscanf(line, "%255s", name) == 1 && strcmp(name, identity) != 0 ) {
+                    fprintf(out, "%s\n", line);
+                    n += 1;
+                }
+            }
+            fclose(in);
+        }
+
+        if ( fclose(out) == 0 )
+            (void) rename(tmp_path, path);
+        else
+            (void) unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    free(path);
+}
+
+/*
+ * Look for a cached resolution for the specified display.
+ */
+static int
+get_dpi_from_cache(const char *identity, double *hres, double *vres)
+{
+    char value[64];
+
+    if ( get_from_cache(DPI_CACHE_FILE, identity, value, sizeof(value)) == -1
+            || sscanf(value, "%lf %lf", hres, vres) != 2 )
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Store the resolution of the specified display in the cache.
+ */
+static void
+store_dpi_in_cache(const char *identity, double hres, double vres)
+{
+    char value[64];
+
+    (void) snprintf(value, sizeof(value), "%.1f %.1f", hres, vres);
+    store_in_cache(DPI_CACHE_FILE, identity, value);
+}
+
+/*
+ * Parameters and results of an X query.
+ */
+struct x_query {
+    struct xlib xlib;
+    double      hres;
+    double      vres;
+    unsigned    features;
+    int         ret;
+};
+
+/*
+ * Query the X server for the resolution. The Xft.dpi resource, if set,
+ * is what desktop environments use to advertise the intended scaling;
+ * otherwise we compute the resolution from the physical dimensions of
+ * the default screen.
+ */
+static void *
+query_x_server(void *arg)
+{
+    struct x_query *query = arg;
+    Display *dpy;
+    char *resources;
+    double dpi;
+    int screen;
+
+    query->ret = -1;
+    if ( (dpy = query->xlib.open_display(NULL)) ) {
+        if ( (resources = query->xlib.resource_manager_string(dpy))
+                && parse_xft_dpi(resources, &dpi) == 0 ) {
+            query->hres = query->vres = dpi;
+            query->ret = 0;
+        }
+        else {
+            screen = DefaultScreen(dpy);
+            if ( DisplayWidthMM(dpy, screen) > 0 && DisplayHeightMM(dpy, screen) > 0 ) {
+                query->hres = (DisplayWidth(dpy, screen) * 25.4) / DisplayWidthMM(dpy, screen);
+                query->vres = (DisplayHeight(dpy, screen) * 25.4) / DisplayHeightMM(dpy, screen);
+                query->ret = 0;
+            }
+        }
+        query->xlib.close_display(dpy);
+    }
+
+    return NULL;
+}
+
+/*
+ * Run a query to the X server in a separate thread, giving up if the
+ * server does not answer in a timely fashion (which may happen with a
+ * remote display). In that case the thread is left running, and the
+ * query structure and libX11 are deliberately never released.
+ */
+static int
+run_x_query(void *(*func)(void *), struct x_query *result)
+{
+    struct x_query *query;
+    pthread_t thread;
+    struct timespec deadline;
+    int ret = -1;
+
+    query = xmalloc(sizeof(struct x_query));
+    if ( load_xlib(&query->xlib) == -1 ) {
+        free(query);
+        return -1;
+    }
+
+    if ( pthread_create(&thread, NULL, func, query) == 0 ) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += X_QUERY_TIMEOUT;
+
+        if ( pthread_timedjoin_np(thread, NULL, &deadline) == 0 ) {
+            if ( (ret = query->ret) == 0 )
+                *result = *query;
+        }
+        else {
+            (void) pthread_detach(thread);
+            return -1;
+        }
+    }
+
+    dlclose(query->xlib.handle);
+    free(query);
+
+    return ret;
+}
+
+static int
+get_dpi_from_x_server(double *hres, double *vres)
+{
+    struct x_query result;
+
+    if ( run_x_query(query_x_server, &result) == -1 )
+        return -1;
+
+    *hres = result.hres;
+    *vres = result.vres;
+
+    return 0;
+}
+
+/**
+ * Get the resolution of the screen in DPI.
+ *
+ * Several sources are tried in turn, from the cheapest to the most
+ * expensive: the scaling factors set in the environment, the Xft.dpi
+ * resource in the user's resource files, the scaling settings of the
+ * desktop environment, a cached value for the current display, and
+ * finally a query to the X server (with a timeout). The result of the
+ * latter is cached for the next sessions.
+ *
+ * @param[out] hres The horizontal resolution.
+ * @param[out] vres The vertical resolution.
+ * @return 0 if successful, or -1 if we could not get the resolution.
+ */
+int
+get_screen_dpi(int *hres, int *vres)
+{
+    double h, v;
+    char *identity;
+    int ret = -1;
+
+    if ( get_dpi_from_environment(&h) == 0
+            || get_dpi_from_resource_files(&h) == 0
+            || get_dpi_from_desktop_settings(&h) == 0 ) {
+        v = h;
+        ret = 0;
+    }
+    else if ( (identity = get_display_identity()) ) {
+        if ( (ret = get_dpi_from_cache(identity, &h, &v)) == -1
+                && (ret = get_dpi_from_x_server(&h, &v)) == 0 )
+            store_dpi_in_cache(identity, h, v);
+        free(identity);
+    }
+
+    if ( ret == 0 ) {
+        *hres = (int) (h + 0.5);
+        *vres = (int) (v + 0.5);
+    }
+
+    return ret;
+}
+
+/*
+ * Check whether the DISPLAY environment variable designates a remote
+ * display: either a display on another host, or a display forwarded
+ * through SSH (which appears as a TCP display on the local host).
+ */
+static int
+is_remote_display(const char *display)
+{
+    size_t len;
+
+    if ( display[0] == ':' || display[0] == '/' || strncmp(display, "unix:", 5) == 0 )
+        return 0;
+
+    len = strcspn(display, ":");
+    if ( (len == 9 && strncmp(display, "localhost", 9) == 0)
+            || (len == 9 && strncmp(display, "127.0.0.1", 9) == 0) )
+        return getenv("SSH_CONNECTION") || getenv("SSH_CLIENT");
+
+    return 1;
+}
+
+/*
+ * Look for the extensions of the X server that tell how Java can best
+ * render on it. A server is only deemed virtual on positive evidence:
+ * VNC servers advertise their own extension, and Xvfb may be told
+ * apart by its vendor string. The lack of the Direct Rendering
+ * extensions proves nothing, as some proprietary drivers do not
+ * provide them.
+ */
+static void *
+query_x_extensions(void *arg)
+{
+    struct x_query *query = arg;
+    Display *dpy;
+    int opcode, event, error;
+
+    query->ret = -1;
+    query->features = 0;
+    if ( (dpy = query->xlib.open_display(NULL)) ) {
+        if ( query->xlib.query_extension(dpy, "RENDER", &opcode, &event, &error) )
+            query->features |= DISPLAY_XRENDER;
+        if ( query->xlib.query_extension(dpy, "GLX", &opcode, &event, &error) )
+            query->features |= DISPLAY_GLX;
+        if ( query->xlib.query_extension(dpy, "XWAYLAND", &opcode, &event, &error) )
+            query->features |= DISPLAY_WAYLAND;
+        if ( query->xlib.query_extension(dpy, "VNC-EXTENSION", &opcode, &event, &error)
+                || (ServerVendor(dpy) && strstr(ServerVendor(dpy), "Xvfb")) )
+            query->features |= DISPLAY_VIRTUAL;
+        query->xlib.close_display(dpy);
+        query->ret = 0;
+    }
+
+    return NULL;
+}
+
+/**
+ * Get the features of the display the user interface will be shown
+ * on, so that a suitable rendering pipeline can be chosen for Java2D.
+ * The X server is only queried (with a timeout) for a local display,
+ * and the result is cached for the next sessions; for a remote
+ * display, only the DISPLAY_REMOTE feature is reported.
+ *
+ * @param[out] features A combination of the DISPLAY_* flags.
+ * @return 0 if successful, or -1 if there is no usable X display.
+ */
+int
+get_display_features(unsigned *features)
+{
+    const char *display, *session;
+    char *identity, value[16];
+    struct x_query result;
+
+    if ( ! (display = getenv("DISPLAY")) || ! *display )
+        return -1;
+
+    if ( is_remote_display(display) ) {
+        *features = DISPLAY_REMOTE;
+        return 0;
+    }
+
+    if ( ! (identity = get_display_identity()) )
+        return -1;
+
+    if ( get_from_cache(FEATURES_CACHE_FILE, identity, value, sizeof(value)) == -1
+            || sscanf(value, "%x", features) != 1 ) {
+        if ( run_x_query(query_x_extensions, &result) == -1 ) {
+            free(identity);
+            return -1;
+        }
+
+        *features = result.features;
+        (void) snprintf(value, sizeof(value), "%x", result.features);
+        store_in_cache(FEATURES_CACHE_FILE, identity, value);
+    }
+    free(identity);
+
+    /* Older Xwayland servers do not advertise themselves. */
+    if ( getenv("WAYLAND_DISPLAY")
+            || ((session = getenv("XDG_SESSION_TYPE")) && strcmp(session, "wayland") == 0) )
+        *features |= DISPLAY_WAYLAND;
+
+    return 0;
+}
+
+/*
+ * State of a search for the windows of a process.
+ */
+struct window_watch {
+    struct xlib xlib;
+    Display    *display;
+    Window      root;
+    Atom        wm_pid;
+    Atom        client_list;
+    pid_t       pid;
+};
+
+/*
+ * Connection used to watch for windows, and the error handler that
+ * was installed before ours. The error handler of Xlib is global to the
+ * process, so ours must leave errors on other connections (such as
+ * those of AWT) to the previous handler.
+ */
+static Display *volatile watch_display = NULL;
+static XErrorHandler previous_error_handler = NULL;
+
+/*
+ * Ignore the errors caused by our queries on windows of other clients,
+ * which may be destroyed at any time. The default handler of Xlib would
+ * terminate the process.
+ */
+static int
+ignore_watch_errors(Display *display, XErrorEvent *error)
+{
+    if ( display == watch_display || ! previous_error_handler )
+        return 0;
+
+    return previous_error_handler(display, error);
+}
+
+/*
+ * Check whether a window is a mapped, top-level window of the watched
+ * process. Override-redirect windows (menus, tooltips, the splash
+ * screen) do not count.
+ */
+static int
+is_process_window(struct window_watch *watch, Window window)
+{
+    XWindowAttributes attrs;
+    Atom type;
+    int format, ret = 0;
+    unsigned long count, remaining;
+    unsigned char *data = NULL;
+
+    if ( watch->xlib.get_window_property(watch->display, window, watch->wm_pid, 0, 1, False,
+                                         XA_CARDINAL, &type, &format, &count, &remaining,
+                                         &data) == Success
+            && data && type == XA_CARDINAL && format == 32 && count == 1
+            && (pid_t) *(unsigned long *) data == watch->pid
+            && watch->xlib.get_window_attributes(watch->display, window, &attrs)
+            && attrs.map_state == IsViewable && ! attrs.override_redirect )
+        ret = 1;
+
+    if ( data )
+        watch->xlib.free(data);
+
+    return ret;
+}
+
+/*
+ * Look for a window of the watched process in the list of client
+ * windows maintained by the window manager. With a reparenting window
+ * manager, this is how we learn about the mapping of a client window,
+ * since the MapNotify event we get is for the frame.
+ */
+static int
+find_in_client_list(struct window_watch *watch)
+{
+    Atom type;
+    int format, ret = 0;
+    unsigned long count, remaining, i;
+    unsigned char *data = NULL;
+
+    if ( watch->xlib.get_window_property(watch->display, watch->root, watch->client_list,
+                                         0, 1024, False, XA_WINDOW, &type, &format, &count,
+                                         &remaining, &data) == Success
+            && data && type == XA_WINDOW && format == 32 )
+        for ( i = 0; i < count && ! ret; i++ )
+            ret = is_process_window(watch, ((Window *) data)[i]);
+
+    if ( data )
+        watch->xlib.free(data);
+
+    return ret;
+}
+
+/**
+ * Wait until a process maps its first top-level window on the X
+ * display. Windows are recognized by their _NET_WM_PID property, as
+ * they are mapped (MapNotify events on the root window) or as the
+ * window manager adds them to its _NET_CLIENT_LIST.
+ *
+ * @param pid     The process whose window to wait for.
+ * @param timeout The maximal time to wait, in seconds.
+ * @return 0 once a window has been mapped, or -1 if there is no X
+ *         display or if no window was mapped within the time allowed.
+ */
+int
+wait_for_window(pid_t pid, unsigned timeout)
+{
+    struct window_watch watch;
+    XErrorHandler handler;
+    struct pollfd pfd;
+    struct timespec now, deadline;
+    XEvent event;
+    int found = 0, wait_time;
+
+    if ( load_xlib(&watch.xlib) == -1 )
+        return -1;
+
+    if ( ! (watch.display = watch.xlib.open_display(NULL)) ) {
+        dlclose(watch.xlib.handle);
+        return -1;
+    }
+
+    watch_display = watch.display;
+    previous_error_handler = watch.xlib.set_error_handler(ignore_watch_errors);
+
+    watch.root = DefaultRootWindow(watch.display);
+    watch.wm_pid = watch.xlib.intern_atom(watch.display, "_NET_WM_PID", False);
+    watch.client_list = watch.xlib.intern_atom(watch.display, "_NET_CLIENT_LIST", False);
+    watch.pid = pid;
+
+    /* Select the events first, so that no window can be missed
+     * between the initial check and the first event. */
+    watch.xlib.select_input(watch.display, watch.root,
+                            SubstructureNotifyMask | PropertyChangeMask);
+    found = find_in_client_list(&watch);
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout;
+
+    pfd.fd = ConnectionNumber(watch.display);
+    pfd.events = POLLIN;
+
+    while ( ! found ) {
+        while ( ! found && watch.xlib.pending(watch.display) ) {
+            watch.xlib.next_event(watch.display, &event);
+            if ( event.type == MapNotify )
+                found = is_process_window(&watch, event.xmap.window);
+            else if ( event.type == PropertyNotify && event.xproperty.atom == watch.client_list )
+                found = find_in_client_list(&watch);
+        }
+        if ( found )
+            break;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        wait_time = (deadline.tv_sec - now.tv_sec) * 1000
+            + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+        if ( wait_time <= 0 || poll(&pfd, 1, wait_time) <= 0 )
+            break;
+    }
+
+    watch.xlib.close_display(watch.display);
+    watch_display = NULL;
+
+    /* AWT may have installed its own handler in the meantime, which
+     * must be left in place (it may call ours, which now passes all
+     * errors on, so libX11 must stay loaded). */
+    if ( (handler = watch.xlib.set_error_handler(previous_error_handler)) != ignore_watch_errors )
+        (void) watch.xlib.set_error_handler(handler);
+    else
+        dlclose(watch.xlib.handle);
+
+    return found ? 0 : -1;
+}
+
+/*
+ * Layout of the XScreenSaverInfo structure from the X11 Screen Saver
+ * extension, so that we do not need the extension's headers.
+ */
+struct xss_info {
+    Window          window;
+    int             state;
+    int             kind;
+    unsigned long   til_or_since;
+    unsigned long   idle;
+    unsigned long   event_mask;
+};
+
+/*
+ * Connection used to query the user's idle time, opened on first use
+ * and kept for the lifetime of the launcher.
+ */
+static struct {
+    int             state;      /* 0 if not initialised yet, 1 if
+                                   ready, -1 if unavailable. */
+    struct xlib     xlib;
+    Display        *display;
+    int           (*query_info)(Display *, Drawable, struct xss_info *);
+    struct xss_info
+                   *info;
+} idle;
+
+/*
+ * Load libXss and connect to the X server for querying the idle time.
+ *
+ * Returns 0 if successful, or -1 if the Screen Saver extension is not
+ * available.
+ */
+static int
+init_idle_query(void)
+{
+    void *xss;
+    Bool (*query_extension)(Display *, int *, int *);
+    struct xss_info * (*alloc_info)(void);
+    int event_base, error_base;
+
+    if ( load_xlib(&idle.xlib) == -1 )
+        return -1;
+
+    if ( (xss = dlopen("libXss.so.1", RTLD_LAZY)) ) {
+        query_extension = (Bool (*)(Display *, int *, int *)) dlsym(xss,
+                "XScreenSaverQueryExtension");
+        alloc_info = (struct xss_info * (*)(void)) dlsym(xss, "XScreenSaverAllocInfo");
+        idle.query_info = (int (*)(Display *, Drawable, struct xss_info *)) dlsym(xss,
+                "XScreenSaverQueryInfo");
+
+        if ( query_extension && alloc_info && idle.query_info
+                && (idle.display = idle.xlib.open_display(NULL)) ) {
+            if ( query_extension(idle.display, &event_base, &error_base)
+                    && (idle.info = alloc_info()) )
+                return 0;
+
+            idle.xlib.close_display(idle.display);
+        }
+        dlclose(xss);
+    }
+    dlclose(idle.xlib.handle);
+
+    return -1;
+}
+
+/**
+ * Get the time elapsed since the last user input on the X display.
+ * This function is not thread-safe.
+ *
+ * @param[out] idle_time The idle time, in milliseconds.
+ * @return 0 if successful, or -1 if the idle time is not available
+ *         (no X display, or no Screen Saver extension).
+ */
+int
+get_user_idle_time(unsigned long *idle_time)
+{
+    if ( idle.state == 0 )
+        idle.state = init_idle_query() == 0 ? 1 : -1;
+
+    if ( idle.state == -1
+            || ! idle.query_info(idle.display, DefaultRootWindow(idle.display), idle.info) )
+        return -1;
+
+    *idle_time = idle.info->idle;
+    return 0;
+}
+
+#endif /* !PROTEGE_LINUX */
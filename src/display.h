@@ -0,0 +1,65 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_DISPLAY_H
+#define ICP20261018_DISPLAY_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(PROTEGE_LINUX)
+#define DISPLAY_REMOTE      0x01    /* Display on another host. */
+#define DISPLAY_XRENDER     0x02    /* Server has the RENDER extension. */
+#define DISPLAY_GLX         0x04    /* Server has the GLX extension. */
+#define DISPLAY_WAYLAND     0x08    /* Server is Xwayland. */
+#define DISPLAY_VIRTUAL     0x10    /* Server without graphics hardware
+                                       (Xvfb, VNC server). */
+
+int
+get_screen_dpi(int *hres, int *vres);
+
+int
+get_user_idle_time(unsigned long *idle_time);
+
+int
+get_display_features(unsigned *features);
+
+int
+wait_for_window(pid_t pid, unsigned timeout);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_DISPLAY_H */
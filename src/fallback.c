@@ -0,0 +1,353 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "fallback.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <string.h>
+#include <err.h>
+#include <unistd.h>
+
+#include <xmem.h>
+
+#include "util.h"
+
+/*
+ * Attempts to start Java. Each attempt drops more options than the
+ * previous one.
+ */
+#define ATTEMPT_NORMAL      0   /* All options except blacklisted ones. */
+#define ATTEMPT_SAFE        1   /* Without the options listed below. */
+#define ATTEMPT_MINIMAL     2   /* Without any non-essential option. */
+
+#define BLACKLIST_FILE      "vm-blacklist"
+
+#define MAX_KEY_LENGTH      128
+
+/*
+ * Options that are known to prevent the virtual machine from starting
+ * on some systems (e.g. because the system does not support large
+ * pages, or because a CDS archive is stale), and which are dropped on
+ * the first retry.
+ */
+static const char *risky_options[] = {
+    "-XX:UseLargePages",
+    "-XX:LargePageSizeInBytes",
+    "-XX:UseTransparentHugePages",
+    "-XX:AlwaysPreTouch",
+    "-XX:UseNUMA",
+    "-XX:SharedArchiveFile",
+    "-XX:AutoCreateSharedArchive",
+    "-XX:ArchiveClassesAtExit",
+    "-Xshare",
+    "-XX:UseZGC",
+    "-XX:ZGenerational",
+    "-XX:UseShenandoahGC",
+    "-XX:UseEpsilonGC",
+    "-XX:UseCompactObjectHeaders",
+    "-XX:UseJVMCICompiler",
+    NULL
+};
+
+/*
+ * -XX options that are kept even on the last attempt, because Protégé
+ * or the launcher itself depend on them.
+ */
+static const char *essential_options[] = {
+    "-XX:CompileCommand",
+    "-XX:ExitOnOutOfMemoryError",
+    "-XX:HeapDumpOnOutOfMemoryError",
+    "-XX:HeapDumpPath",
+    NULL
+};
+
+/*
+ * State of the current launch attempt.
+ */
+static struct {
+    char      **argv;       /* Arguments to re-execute ourselves. */
+    int         attempt;    /* Current attempt. */
+    unsigned    version;    /* Version of the JRE in use. */
+    int         done;       /* Whether the VM was created, or we
+                               already tried to re-execute. */
+    char      **dropped;    /* Risky options dropped on this attempt. */
+    size_t      n_dropped;
+    char      **blacklist;  /* Options blacklisted for the JRE. */
+    size_t      n_blacklisted;
+} launch;
+
+/*
+ * Get the key identifying an option, independently of its value: the
+ * flag name for -XX options (e.g. -XX:UseLargePages for both
+ * -XX:+UseLargePages and -XX:-UseLargePages), otherwise the option up
+ * to the first = or : character.
+ */
+static void
+get_option_key(const char *option, char *key, size_t len)
+{
+    if ( strncmp(option, "-XX:", 4) == 0 ) {
+        option += 4;
+        if ( *option == '+' || *option == '-' )
+            option += 1;
+        (void) snprintf(key, len, "-XX:%.*s", (int) strcspn(option, "="), option);
+    }
+    else
+        (void) snprintf(key, len, "%.*s", (int) strcspn(option, "=:"), option);
+}
+
+/*
+ * Check whether a key is in a NULL-terminated list.
+ */
+static int
+is_in_list(const char *key, const char **list)
+{
+    for ( ; *list; list++ )
+        if ( strcmp(key, *list) == 0 )
+            return 1;
+
+    return 0;
+}
+
+/*
+ * Get the pathname to the blacklist file.
+ */
+static char *
+get_blacklist_file(void)
+{
+    char *dir, *path = NULL;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) xasprintf(&path, "%s/" BLACKLIST_FILE, dir);
+        free(dir);
+    }
+
+    return path;
+}
+
+/*
+ * Read the options blacklisted for the current JRE.
+ */
+static void
+load_blacklist(void)
+{
+    char *path, line[256], name[MAX_KEY_LENGTH];
+    unsigned version;
+    FILE *f;
+
+    if ( ! launch.version || ! (path = get_blacklist_file()) )
+        return;
+
+    if ( (f = fopen(path, "r")) ) {
+        while ( ! feof(f) )
+            if ( get_line(f, line, sizeof(line)) > 0
+                    && sscanf(line, "%u %127s", &version, name) == 2
+                    && version == launch.version ) {
+                launch.blacklist = xrealloc(launch.blacklist,
+                                            (launch.n_blacklisted + 1) * sizeof(char *));
+                launch.blacklist[launch.n_blacklisted++] = xstrdup(name);
+            }
+        fclose(f);
+    }
+    free(path);
+}
+
+/*
+ * Check whether an option has been blacklisted for the current JRE.
+ */
+static int
+is_blacklisted(const char *key)
+{
+    size_t n;
+
+    for ( n = 0; n < launch.n_blacklisted; n++ )
+        if ( strcmp(launch.blacklist[n], key) == 0 )
+            return 1;
+
+    return 0;
+}
+
+/*
+ * Called once the virtual machine has been created. If we had to drop
+ * some options to get there, remember them so that we don't try them
+ * again with the same JRE.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    char *path, *dir;
+    FILE *f;
+    size_t n;
+
+    (void) jvm;
+    (void) env;
+    (void) data;
+
+    launch.done = 1;
+
+    if ( launch.n_dropped == 0 || ! launch.version )
+        return;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) create_directory(dir);
+        free(dir);
+    }
+
+    if ( (path = get_blacklist_file()) && (f = fopen(path, "a")) ) {
+        for ( n = 0; n < launch.n_dropped; n++ )
+            if ( ! is_blacklisted(launch.dropped[n]) )
+                fprintf(f, "%u %s\n", launch.version, launch.dropped[n]);
+        fclose(f);
+    }
+    free(path);
+}
+
+/*
+ * Called when the launcher exits. If that happens while the virtual
+ * machine is being created, that means the virtual machine aborted
+ * during its initialisation (some errors are not reported to the
+ * caller of JNI_CreateJavaVM), so we try again. Other early exits are
+ * not caused by the options, and trying again would not help.
+ */
+static void
+retry_at_exit(void)
+{
+    if ( is_creating_java() )
+        retry_launch();
+}
+
+/**
+ * Prepare for re-executing the launcher if the virtual machine cannot
+ * be created.
+ *
+ * @param argv The arguments the launcher was started with, or NULL if
+ *             the launcher is not to be re-executed (only the options
+ *             known to prevent Java from starting are then filtered).
+ * @param jre  The JRE in use.
+ */
+void
+init_fallback(char **argv, const struct jre_info *jre)
+{
+    const char *value;
+
+    launch.argv = argv;
+    launch.version = jre->version;
+    launch.attempt = ATTEMPT_NORMAL;
+
+    /* Do not let Java and its child processes see the marker. */
+    if ( (value = getenv(LAUNCH_ATTEMPT_ENV)) ) {
+        launch.attempt = atoi(value);
+        (void) unsetenv(LAUNCH_ATTEMPT_ENV);
+    }
+
+    load_blacklist();
+
+    add_java_callback(on_java_created, NULL);
+    (void) atexit(retry_at_exit);
+}
+
+/**
+ * Remove from a list of Java options the options that should not be
+ * used for the current launch attempt. On the first attempt, this only
+ * removes the options that previously prevented the virtual machine
+ * from starting with the same JRE.
+ *
+ * @param options A NULL-terminated list of options, as returned by
+ *                translate_options; it is modified in place.
+ */
+void
+filter_vm_options(char **options)
+{
+    char key[MAX_KEY_LENGTH];
+    size_t n, m;
+    int drop;
+
+    for ( n = m = 0; options[n]; n++ ) {
+        get_option_key(options[n], key, sizeof(key));
+
+        if ( (drop = is_blacklisted(key)) )
+            warnx("Ignoring option %s, which prevented Java from starting", options[n]);
+        else if ( launch.attempt >= ATTEMPT_SAFE && is_in_list(key, risky_options) ) {
+            warnx("Trying without option %s", options[n]);
+            launch.dropped = xrealloc(launch.dropped, (launch.n_dropped + 1) * sizeof(char *));
+            launch.dropped[launch.n_dropped++] = xstrdup(key);
+            drop = 1;
+        }
+        else if ( launch.attempt >= ATTEMPT_MINIMAL
+                  && ((strncmp(key, "-XX:", 4) == 0 && ! is_in_list(key, essential_options))
+                      || strncmp(key, "-Xms", 4) == 0 || strncmp(key, "-Xmn", 4) == 0) ) {
+            /* Those are not blacklisted, as we cannot tell which of
+             * them is the culprit. */
+            warnx("Trying without option %s", options[n]);
+            drop = 1;
+        }
+
+        if ( drop )
+            free(options[n]);
+        else
+            options[m++] = options[n];
+    }
+    options[m] = NULL;
+}
+
+/**
+ * Re-execute the launcher to make another attempt at starting Java with
+ * a safer set of options. This function only returns if there is no
+ * further attempt to make, or if the launcher cannot be re-executed.
+ */
+void
+retry_launch(void)
+{
+    char *exe, attempt[16];
+
+    if ( launch.done || ! launch.argv || launch.attempt >= ATTEMPT_MINIMAL )
+        return;
+    launch.done = 1;
+
+    if ( ! (exe = get_executable_path()) )
+        return;
+
+    warnx("Cannot create Java virtual machine, trying again with safer options");
+
+    (void) snprintf(attempt, sizeof(attempt), "%d", launch.attempt + 1);
+    (void) setenv(LAUNCH_ATTEMPT_ENV, attempt, 1);
+    fflush(NULL);
+    (void) execv(exe, launch.argv);
+
+    warn("Cannot execute %s", exe);
+    free(exe);
+}
+
+#endif /* !PROTEGE_WIN32 */
@@ -0,0 +1,207 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "fastexit.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <err.h>
+#include <unistd.h>
+
+#if defined(PROTEGE_LINUX)
+#include <pwd.h>
+#endif
+
+#include <xmem.h>
+
+#include "java.h"
+#include "util.h"
+
+#if defined(PROTEGE_LINUX)
+/*
+ * Remove the performance data file of the virtual machine, which it
+ * would have removed itself on a normal exit. Otherwise it would only
+ * be removed when the next virtual machine starts, and until then
+ * tools such as jps would list a process that no longer exists.
+ */
+static void
+remove_perf_data(void)
+{
+    struct passwd *pw;
+    char *path = NULL;
+
+    if ( (pw = getpwuid(geteuid())) ) {
+        (void) xasprintf(&path, "/tmp/hsperfdata_%s/%ld", pw->pw_name, (long) getpid());
+        (void) unlink(path);
+        free(path);
+    }
+}
+#endif
+
+/*
+ * Class file of org.protege.launcher.FastExit, which is equivalent to:
+ *
+ *   public final class FastExit implements Runnable {
+ *       public native void run();
+ *   }
+ */
+static const unsigned char fast_exit_class[] = {
+    0xca, 0xfe, 0xba, 0xbe, 0x00, 0x00, 0x00, 0x32, 0x00, 0x0d, 0x01, 0x00,
+    0x1d, 0x6f, 0x72, 0x67, 0x2f, 0x70, 0x72, 0x6f, 0x74, 0x65, 0x67, 0x65,
+    0x2f, 0x6c, 0x61, 0x75, 0x6e, 0x63, 0x68, 0x65, 0x72, 0x2f, 0x46, 0x61,
+    0x73, 0x74, 0x45, 0x78, 0x69, 0x74, 0x07, 0x00, 0x01, 0x01, 0x00, 0x10,
+    0x6a, 0x61, 0x76, 0x61, 0x2f, 0x6c, 0x61, 0x6e, 0x67, 0x2f, 0x4f, 0x62,
+    0x6a, 0x65, 0x63, 0x74, 0x07, 0x00, 0x03, 0x01, 0x00, 0x12, 0x6a, 0x61,
+    0x76, 0x61, 0x2f, 0x6c, 0x61, 0x6e, 0x67, 0x2f, 0x52, 0x75, 0x6e, 0x6e,
+    0x61, 0x62, 0x6c, 0x65, 0x07, 0x00, 0x05, 0x01, 0x00, 0x06, 0x3c, 0x69,
+    0x6e, 0x69, 0x74, 0x3e, 0x01, 0x00, 0x03, 0x28, 0x29, 0x56, 0x0c, 0x00,
+    0x07, 0x00, 0x08, 0x0a, 0x00, 0x04, 0x00, 0x09, 0x01, 0x00, 0x03, 0x72,
+    0x75, 0x6e, 0x01, 0x00, 0x04, 0x43, 0x6f, 0x64, 0x65, 0x00, 0x31, 0x00,
+    0x02, 0x00, 0x04, 0x00, 0x01, 0x00, 0x06, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x01, 0x00, 0x07, 0x00, 0x08, 0x00, 0x01, 0x00, 0x0c, 0x00, 0x00, 0x00,
+    0x11, 0x00, 0x01, 0x00, 0x01, 0x00, 0x00, 0x00, 0x05, 0x2a, 0xb7, 0x00,
+    0x0a, 0xb1, 0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x00, 0x0b, 0x00, 0x08,
+    0x00, 0x00, 0x00, 0x00,
+};
+
+/*
+ * Slot of java.lang.Shutdown where the hook is installed. The runtime
+ * has 10 slots for system hooks, run in order once the application
+ * hooks (slot 1) and the deletion of files marked as deleteOnExit
+ * (slot 2) have completed; the last one is never used by the runtime.
+ */
+#define FAST_EXIT_HOOK_SLOT 9
+
+/*
+ * Native implementation of FastExit.run, called as the last shutdown
+ * hook, once Protégé and the OSGi framework have saved their state.
+ * Instead of returning to let the Java runtime stop the virtual
+ * machine, which involves waiting for all threads to reach a safepoint
+ * (including compiler threads busy with a large method) and stopping
+ * the garbage collector, we only do the launcher's own cleanup and end
+ * the process immediately. The status passed to System.exit is not
+ * available to shutdown hooks, so the process always ends with 0.
+ */
+static void JNICALL
+fast_exit_hook(JNIEnv *env, jobject hook)
+{
+    (void) env;
+    (void) hook;
+
+    run_exit_handlers();
+#if defined(PROTEGE_LINUX)
+    remove_perf_data();
+#endif
+    fflush(NULL);
+
+    _exit(EXIT_SUCCESS);
+}
+
+/*
+ * Define the FastExit class and create an instance of it.
+ *
+ * Returns the new instance, or NULL if an error occured.
+ */
+static jobject
+create_hook(JNIEnv *env)
+{
+    JNINativeMethod method = { "run", "()V", (void *) fast_exit_hook };
+    jclass loader_class, fast_exit;
+    jmethodID method_id;
+    jobject loader = NULL, hook = NULL;
+
+    if ( (loader_class = (*env)->FindClass(env, "java/lang/ClassLoader"))
+            && (method_id = (*env)->GetStaticMethodID(env, loader_class, "getSystemClassLoader",
+                                                      "()Ljava/lang/ClassLoader;")) )
+        loader = (*env)->CallStaticObjectMethod(env, loader_class, method_id);
+
+    if ( loader
+            && (fast_exit = (*env)->DefineClass(env, "org/protege/launcher/FastExit", loader,
+                                                (const jbyte *) fast_exit_class,
+                                                sizeof(fast_exit_class)))
+            && (*env)->RegisterNatives(env, fast_exit, &method, 1) == JNI_OK
+            && (method_id = (*env)->GetMethodID(env, fast_exit, "<init>", "()V")) )
+        hook = (*env)->NewObject(env, fast_exit, method_id);
+
+    return hook;
+}
+
+/*
+ * Called once the virtual machine has been created, to install the
+ * FastExit hook.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    jclass shutdown;
+    jmethodID add;
+    jobject hook;
+
+    (void) jvm;
+    (void) data;
+
+    if ( (*env)->PushLocalFrame(env, 8) != JNI_OK )
+        return;
+
+    /* Shutdown.add is not public, but JNI does not check accesses. */
+    if ( (hook = create_hook(env))
+            && (shutdown = (*env)->FindClass(env, "java/lang/Shutdown"))
+            && (add = (*env)->GetStaticMethodID(env, shutdown, "add",
+                                                "(IZLjava/lang/Runnable;)V")) )
+        (*env)->CallStaticVoidMethod(env, shutdown, add, FAST_EXIT_HOOK_SLOT, JNI_FALSE, hook);
+
+    if ( ! hook || (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        warnx("Cannot enable fast exit");
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+}
+
+/**
+ * Make the process end as soon as Protégé has finished shutting down,
+ * without stopping the virtual machine. This applies whenever the
+ * shutdown hooks are run (when Protégé calls System.exit or when its
+ * last non-daemon thread ends), once the other hooks have completed; it
+ * does not apply to Runtime.halt.
+ */
+void
+enable_fast_exit(void)
+{
+    add_java_callback(on_java_created, NULL);
+}
+
+#endif
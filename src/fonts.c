@@ -0,0 +1,617 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "fonts.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include <xmem.h>
+
+#include "util.h"
+
+#define FONT_CACHE_PREFIX   "fonts-"
+#define FONT_CACHE_SUFFIX   ".properties"
+
+/* Deepest subdirectory of a font directory that is looked at. */
+#define MAX_FONT_DIR_DEPTH  16
+
+/* Largest number of fonts in each logical font. */
+#define MAX_COMPONENTS      8
+
+/* 64-bit FNV-1a hash. */
+#define FNV_OFFSET_BASIS    0xcbf29ce484222325ULL
+#define FNV_PRIME           0x100000001b3ULL
+
+/*
+ * The subset of the fontconfig API we need. The library is loaded
+ * dynamically, so that the launcher neither depends on it nor needs
+ * its headers.
+ */
+typedef struct _FcPattern FcPattern;
+typedef struct _FcCharSet FcCharSet;
+typedef unsigned char FcChar8;
+typedef int FcBool;
+
+typedef struct {
+    int         nfont;
+    int         sfont;
+    FcPattern **fonts;
+} FcFontSet;
+
+#define FC_FAMILY           "family"
+#define FC_FILE             "file"
+#define FC_FULLNAME         "fullname"
+#define FC_FONTFORMAT       "fontformat"
+#define FC_WEIGHT           "weight"
+#define FC_SLANT            "slant"
+#define FC_LANG             "lang"
+#define FC_WEIGHT_REGULAR   80
+#define FC_WEIGHT_BOLD      200
+#define FC_SLANT_ROMAN      0
+#define FC_SLANT_ITALIC     100
+#define FC_MATCH_PATTERN    0
+#define FC_RESULT_MATCH     0
+
+struct fontconfig {
+    void       *handle;
+    FcBool     (*init)(void);
+    FcPattern *(*pattern_create)(void);
+    void       (*pattern_destroy)(FcPattern *);
+    FcBool     (*pattern_add_string)(FcPattern *, const char *, const FcChar8 *);
+    FcBool     (*pattern_add_integer)(FcPattern *, const char *, int);
+    int        (*pattern_get_string)(const FcPattern *, const char *, int, FcChar8 **);
+    FcBool     (*config_substitute)(void *, FcPattern *, int);
+    void       (*default_substitute)(FcPattern *);
+    FcFontSet *(*font_sort)(void *, FcPattern *, FcBool, FcCharSet **, int *);
+    void       (*font_set_destroy)(FcFontSet *);
+};
+
+/*
+ * Logical fonts of Java, and the generic fontconfig families they are
+ * mapped to, as Java itself does.
+ */
+static const struct {
+    const char *logical;
+    const char *family;
+} logical_fonts[] = {
+    { "serif",          "serif" },
+    { "sansserif",      "sans-serif" },
+    { "monospaced",     "monospace" },
+    { "dialog",         "sans-serif" },
+    { "dialoginput",    "monospace" },
+    { NULL,             NULL }
+};
+
+static const char *styles[] = { "plain", "bold", "italic", "bolditalic" };
+
+/*
+ * A font chosen for a component of a logical font.
+ */
+struct component {
+    char   *name;
+    char   *file;
+};
+
+/*
+ * The fonts chosen for all the logical fonts and styles.
+ */
+struct font_mapping {
+    struct component    components[5][4][MAX_COMPONENTS];
+    int                 counts[5][4];
+    int                 max_count;
+};
+
+static uint64_t fingerprint;
+static int fingerprint_done = 0;
+
+static uint64_t
+hash_string(uint64_t hash, const char *s)
+{
+    while ( *s ) {
+        hash ^= (unsigned char) *s++;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Add a file or directory to the fingerprint of the font setup.
+ */
+static void
+add_to_fingerprint(const char *path, const struct stat *st)
+{
+    uint64_t hash;
+
+    hash = hash_string(FNV_OFFSET_BASIS, path);
+    hash ^= (uint64_t) st->st_mtime;
+    hash *= FNV_PRIME;
+    hash ^= (uint64_t) st->st_size;
+    hash *= FNV_PRIME;
+    fingerprint += hash;
+}
+
+/* Callback for nftw, to add every file of a configuration directory. */
+static int
+add_config_file(const char *path, const struct stat *st, int type, struct FTW *ftw)
+{
+    (void) ftw;
+
+    if ( type == FTW_D || type == FTW_F )
+        add_to_fingerprint(path, st);
+
+    return 0;
+}
+
+/*
+ * Add a font directory and its subdirectories to the fingerprint. Only
+ * directories are considered, as adding or removing a font changes
+ * the modification time of its directory; font files are never looked
+ * at, since there may be thousands of them.
+ */
+static void
+add_font_directory(const char *path, int depth)
+{
+    DIR *d;
+    struct dirent *entry;
+    struct stat st;
+    char *subdir;
+
+    if ( depth > MAX_FONT_DIR_DEPTH || lstat(path, &st) == -1 || ! S_ISDIR(st.st_mode) )
+        return;
+
+    add_to_fingerprint(path, &st);
+
+    if ( ! (d = opendir(path)) )
+        return;
+
+    while ( (entry = readdir(d)) ) {
+        if ( strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0 )
+            continue;
+
+        /* Only entries of unknown type need to be checked. */
+        if ( entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN )
+            continue;
+
+        subdir = NULL;
+        (void) xasprintf(&subdir, "%s/%s", path, entry->d_name);
+        add_font_directory(subdir, depth + 1);
+        free(subdir);
+    }
+
+    closedir(d);
+}
+
+/*
+ * Get the language to ask fontconfig about, from the locale settings
+ * (e.g. "fr_FR.UTF-8" gives "fr-fr").
+ */
+static void
+get_language(char *buffer, size_t len)
+{
+    const char *locale;
+    size_t n;
+
+    if ( ! (locale = getenv("LC_ALL")) || ! *locale )
+        if ( ! (locale = getenv("LC_CTYPE")) || ! *locale )
+            locale = getenv("LANG");
+
+    if ( ! locale || ! *locale || strcmp(locale, "C") == 0 || strncmp(locale, "C.", 2) == 0
+            || strcmp(locale, "POSIX") == 0 )
+        locale = "en";
+
+    for ( n = 0; n < len - 1 && locale[n] && locale[n] != '.' && locale[n] != '@'; n++ )
+        buffer[n] = locale[n] == '_' ? '-' : tolower((unsigned char) locale[n]);
+    buffer[n] = '\0';
+}
+
+/*
+ * Compute a fingerprint of everything the font configuration depends
+ * on: the font directories, the fontconfig configuration, and the
+ * language. It is only computed once, and reused by later calls.
+ */
+static uint64_t
+get_font_fingerprint(void)
+{
+    const char *home, *data_home, *config_home;
+    char *dirs[6] = { NULL }, language[32];
+    size_t n = 0, n_config, i;
+
+    if ( fingerprint_done )
+        return fingerprint;
+
+    dirs[n++] = xstrdup("/etc/fonts");
+    if ( (home = getenv("HOME")) ) {
+        if ( (config_home = getenv("XDG_CONFIG_HOME")) && config_home[0] == '/' )
+            (void) xasprintf(&dirs[n++], "%s/fontconfig", config_home);
+        else
+            (void) xasprintf(&dirs[n++], "%s/.config/fontconfig", home);
+    }
+    n_config = n;
+
+    if ( home ) {
+        (void) xasprintf(&dirs[n++], "%s/.fonts", home);
+
+        if ( (data_home = getenv("XDG_DATA_HOME")) && data_home[0] == '/' )
+            (void) xasprintf(&dirs[n++], "%s/fonts", data_home);
+        else
+            (void) xasprintf(&dirs[n++], "%s/.local/share/fonts", home);
+    }
+    dirs[n++] = xstrdup("/usr/share/fonts");
+    dirs[n++] = xstrdup("/usr/local/share/fonts");
+
+    get_language(language, sizeof(language));
+    fingerprint = hash_string(FNV_OFFSET_BASIS, language);
+
+    for ( i = 0; i < n; i++ ) {
+        if ( i < n_config )
+            (void) nftw(dirs[i], add_config_file, 16, FTW_PHYS);
+        else
+            add_font_directory(dirs[i], 0);
+        free(dirs[i]);
+    }
+
+    fingerprint_done = 1;
+    return fingerprint;
+}
+
+static char *
+get_cache_file(uint64_t fp)
+{
+    char *dir, *path = NULL;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) xasprintf(&path, "%s/" FONT_CACHE_PREFIX "%016" PRIx64 FONT_CACHE_SUFFIX,
+                         dir, fp);
+        free(dir);
+    }
+
+    return path;
+}
+
+/**
+ * Get a font configuration for Java, matching the current font setup
+ * of the system, as built by a previous call to
+ * update_font_configuration.
+ *
+ * @return A newly allocated buffer containing the pathname to the font
+ *         configuration (a Java fontconfig.properties file), or NULL
+ *         if no configuration matching the current setup is available.
+ */
+char *
+get_font_configuration(void)
+{
+    char *path;
+
+    if ( (path = get_cache_file(get_font_fingerprint())) && access(path, R_OK) != 0 ) {
+        free(path);
+        path = NULL;
+    }
+
+    return path;
+}
+
+static int
+load_fontconfig(struct fontconfig *fc)
+{
+    if ( ! (fc->handle = dlopen("libfontconfig.so.1", RTLD_LAZY)) )
+        return -1;
+
+    fc->init = (FcBool (*)(void)) dlsym(fc->handle, "FcInit");
+    fc->pattern_create = (FcPattern *(*)(void)) dlsym(fc->handle, "FcPatternCreate");
+    fc->pattern_destroy = (void (*)(FcPattern *)) dlsym(fc->handle, "FcPatternDestroy");
+    fc->pattern_add_string = (FcBool (*)(FcPattern *, const char *, const FcChar8 *))
+        dlsym(fc->handle, "FcPatternAddString");
+    fc->pattern_add_integer = (FcBool (*)(FcPattern *, const char *, int))
+        dlsym(fc->handle, "FcPatternAddInteger");
+    fc->pattern_get_string = (int (*)(const FcPattern *, const char *, int, FcChar8 **))
+        dlsym(fc->handle, "FcPatternGetString");
+    fc->config_substitute = (FcBool (*)(void *, FcPattern *, int))
+        dlsym(fc->handle, "FcConfigSubstitute");
+    fc->default_substitute = (void (*)(FcPattern *)) dlsym(fc->handle, "FcDefaultSubstitute");
+    fc->font_sort = (FcFontSet *(*)(void *, FcPattern *, FcBool, FcCharSet **, int *))
+        dlsym(fc->handle, "FcFontSort");
+    fc->font_set_destroy = (void (*)(FcFontSet *)) dlsym(fc->handle, "FcFontSetDestroy");
+
+    if ( ! fc->init || ! fc->pattern_create || ! fc->pattern_destroy
+            || ! fc->pattern_add_string || ! fc->pattern_add_integer
+            || ! fc->pattern_get_string || ! fc->config_substitute
+            || ! fc->default_substitute || ! fc->font_sort || ! fc->font_set_destroy
+            || ! fc->init() ) {
+        dlclose(fc->handle);
+        return -1;
+    }
+
+    return 0;
+}
+
+/*
+ * Check whether Java can use a font file: TrueType and OpenType fonts
+ * (including collections) and Type 1 fonts.
+ */
+static int
+is_supported_font(const char *format)
+{
+    return strcmp(format, "TrueType") == 0 || strcmp(format, "CFF") == 0
+        || strcmp(format, "Type 1") == 0;
+}
+
+/*
+ * Choose the fonts for a logical font in a given style: the best match
+ * for the generic family, followed by the fonts that cover characters
+ * the previous ones do not, as sorted by fontconfig.
+ */
+static int
+match_fonts(struct fontconfig *fc, const char *family, int style, const char *language,
+            struct component *components)
+{
+    FcPattern *pattern;
+    FcFontSet *set;
+    FcChar8 *file, *name, *format;
+    int result, n, count = 0;
+
+    if ( ! (pattern = fc->pattern_create()) )
+        return 0;
+
+    fc->pattern_add_string(pattern, FC_FAMILY, (const FcChar8 *) family);
+    fc->pattern_add_string(pattern, FC_LANG, (const FcChar8 *) language);
+    fc->pattern_add_integer(pattern, FC_WEIGHT, style & 1 ? FC_WEIGHT_BOLD : FC_WEIGHT_REGULAR);
+    fc->pattern_add_integer(pattern, FC_SLANT, style & 2 ? FC_SLANT_ITALIC : FC_SLANT_ROMAN);
+    fc->config_substitute(NULL, pattern, FC_MATCH_PATTERN);
+    fc->default_substitute(pattern);
+
+    if ( (set = fc->font_sort(NULL, pattern, 1, NULL, &result)) ) {
+        for ( n = 0; n < set->nfont && count < MAX_COMPONENTS; n++ ) {
+            if ( fc->pattern_get_string(set->fonts[n], FC_FILE, 0, &file) != FC_RESULT_MATCH
+                    || fc->pattern_get_string(set->fonts[n], FC_FULLNAME, 0, &name) != FC_RESULT_MATCH
+                    || fc->pattern_get_string(set->fonts[n], FC_FONTFORMAT, 0, &format) != FC_RESULT_MATCH
+                    || ! is_supported_font((const char *) format) )
+                continue;
+
+            components[count].name = xstrdup((const char *) name);
+            components[count].file = xstrdup((const char *) file);
+            count += 1;
+        }
+        fc->font_set_destroy(set);
+    }
+
+    fc->pattern_destroy(pattern);
+
+    return count;
+}
+
+/*
+ * Get the key under which the file of a font is given, in which spaces
+ * are replaced by underscores.
+ */
+static void
+print_filename_key(FILE *f, const char *name)
+{
+    fprintf(f, "filename.");
+    for ( ; *name; name++ )
+        fputc(*name == ' ' ? '_' : *name, f);
+}
+
+/*
+ * Write the font mapping as a Java font configuration file. Every
+ * logical font gets the same number of components, as the sequence is
+ * common to all of them; the missing ones repeat the last font.
+ */
+static int
+write_font_configuration(const char *path, struct font_mapping *mapping)
+{
+    FILE *f;
+    char *tmp_path = NULL;
+    struct component *c;
+    int i, j, k, ret = -1;
+
+    (void) xasprintf(&tmp_path, "%s.%ld", path, (long) getpid());
+    if ( ! (f = fopen(tmp_path, "w")) ) {
+        free(tmp_path);
+        return -1;
+    }
+
+    fprintf(f, "# Generated by the Protégé launcher from the fontconfig setup.\n");
+    fprintf(f, "version=1\n\n");
+
+    for ( i = 0; logical_fonts[i].logical; i++ ) {
+        for ( j = 0; j < 4; j++ ) {
+            for ( k = 0; k < mapping->max_count; k++ ) {
+                c = &mapping->components[i][j][k < mapping->counts[i][j] ? k : mapping->counts[i][j] - 1];
+                if ( k == 0 )
+                    fprintf(f, "%s.%s.latin-1=%s\n", logical_fonts[i].logical, styles[j], c->name);
+                else
+                    fprintf(f, "%s.%s.fallback-%d=%s\n", logical_fonts[i].logical, styles[j], k,
+                            c->name);
+            }
+        }
+    }
+
+    fprintf(f, "\nsequence.allfonts=latin-1");
+    for ( k = 1; k < mapping->max_count; k++ )
+        fprintf(f, ",fallback-%d", k);
+    fprintf(f, "\n\n");
+
+    for ( i = 0; logical_fonts[i].logical; i++ ) {
+        for ( j = 0; j < 4; j++ ) {
+            for ( k = 0; k < mapping->counts[i][j]; k++ ) {
+                c = &mapping->components[i][j][k];
+                print_filename_key(f, c->name);
+                fprintf(f, "=%s\n", c->file);
+            }
+        }
+    }
+
+    if ( fclose(f) == 0 && rename(tmp_path, path) == 0 )
+        ret = 0;
+    else
+        (void) unlink(tmp_path);
+    free(tmp_path);
+
+    return ret;
+}
+
+/*
+ * Remove the font configurations built for previous font setups.
+ */
+static void
+remove_old_configurations(const char *dir, const char *current)
+{
+    DIR *d;
+    struct dirent *entry;
+    char *path;
+    size_t len;
+
+    if ( ! (d = opendir(dir)) )
+        return;
+
+    while ( (entry = readdir(d)) ) {
+        len = strlen(entry->d_name);
+        if ( strncmp(entry->d_name, FONT_CACHE_PREFIX, strlen(FONT_CACHE_PREFIX)) != 0
+                || len < strlen(FONT_CACHE_SUFFIX)
+                || strcmp(entry->d_name + len - strlen(FONT_CACHE_SUFFIX), FONT_CACHE_SUFFIX) != 0 )
+            continue;
+
+        path = NULL;
+        (void) xasprintf(&path, "%s/%s", dir, entry->d_name);
+        if ( strcmp(path, current) != 0 )
+            (void) unlink(path);
+        free(path);
+    }
+
+    closedir(d);
+}
+
+/*
+ * Main function of the thread building the font configuration.
+ */
+static void *
+build_main(void *arg)
+{
+    char *path = arg, *dir, language[32];
+    struct fontconfig fc;
+    struct font_mapping mapping;
+    int i, j, k, complete = 1;
+
+    set_thread_name("protege-fonts");
+
+    /* Do not compete with Java for the CPU while it is starting. */
+    (void) setpriority(PRIO_PROCESS, syscall(SYS_gettid), 10);
+
+    if ( load_fontconfig(&fc) == 0 ) {
+        get_language(language, sizeof(language));
+
+        memset(&mapping, 0, sizeof(mapping));
+        for ( i = 0; logical_fonts[i].logical; i++ ) {
+            for ( j = 0; j < 4; j++ ) {
+                mapping.counts[i][j] = match_fonts(&fc, logical_fonts[i].family, j, language,
+                                                   mapping.components[i][j]);
+                if ( mapping.counts[i][j] == 0 )
+                    complete = 0;
+                if ( mapping.counts[i][j] > mapping.max_count )
+                    mapping.max_count = mapping.counts[i][j];
+            }
+        }
+
+        /* Without a font for every logical font, let Java do its own
+         * configuration. */
+        if ( complete && (dir = get_cache_directory()) ) {
+            (void) create_directory(dir);
+            if ( write_font_configuration(path, &mapping) == 0 )
+                remove_old_configurations(dir, path);
+            free(dir);
+        }
+
+        for ( i = 0; logical_fonts[i].logical; i++ ) {
+            for ( j = 0; j < 4; j++ ) {
+                for ( k = 0; k < mapping.counts[i][j]; k++ ) {
+                    free(mapping.components[i][j][k].name);
+                    free(mapping.components[i][j][k].file);
+                }
+            }
+        }
+
+        /* Java uses the library as well, do not unload it. */
+    }
+
+    free(path);
+
+    return NULL;
+}
+
+/**
+ * Build, in the background, a font configuration for Java matching the
+ * current font setup of the system, unless one is already available.
+ * Java can then use that configuration on the next launches instead of
+ * querying fontconfig for its logical fonts, which can be slow on
+ * systems with many fonts.
+ */
+void
+update_font_configuration(void)
+{
+    char *path;
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    if ( ! (path = get_cache_file(get_font_fingerprint())) )
+        return;
+
+    if ( access(path, R_OK) == 0 ) {
+        free(path);
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, build_main, path) != 0 )
+        free(path);
+    pthread_attr_destroy(&attr);
+}
+
+#endif
@@ -0,0 +1,384 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "heapdump.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#if defined(HAVE_ZLIB_H)
+#include <zlib.h>
+#endif
+
+#if defined(PROTEGE_LINUX)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
+
+#include <xmem.h>
+
+#include "util.h"
+
+/*
+ * The JVM names heap dumps java_pid<pid>.hprof when -XX:HeapDumpPath
+ * points to a directory.
+ */
+#define DUMP_PREFIX         "java_pid"
+#define DUMP_SUFFIX         ".hprof"
+#define COMPRESSED_SUFFIX   ".hprof.gz"
+#define TEMP_SUFFIX         ".tmp"
+#define LOCK_FILE           ".lock"
+
+#define COPY_BUFFER_SIZE    (1024 * 1024)
+
+/*
+ * Parameters of the heap dump manager.
+ */
+struct dump_manager {
+    char       *dir;        /* Heap dump directory. */
+    unsigned    count;      /* Maximal number of dumps to keep. */
+    size_t      quota;      /* Maximal size of all dumps (0 for no
+                               limit). */
+};
+
+/*
+ * A heap dump found in the dump directory.
+ */
+struct dump_file {
+    char       *path;
+    time_t      mtime;
+    off_t       size;
+};
+
+static pthread_t manager_thread;
+static int manager_started = 0;
+
+/**
+ * Get the heap dump written by the specified process.
+ *
+ * @param dir The heap dump directory.
+ * @param pid The process that ran the Java virtual machine.
+ *
+ * @return A newly allocated buffer containing the pathname to the heap
+ *         dump, or NULL if the process did not write any dump.
+ */
+char *
+get_heap_dump(const char *dir, pid_t pid)
+{
+    char *path = NULL;
+    struct stat st;
+
+    (void) xasprintf(&path, "%s/" DUMP_PREFIX "%ld" DUMP_SUFFIX, dir, (long) pid);
+    if ( stat(path, &st) == -1 ) {
+        free(path);
+        path = NULL;
+    }
+
+    return path;
+}
+
+/*
+ * Check whether a string ends with the specified suffix.
+ */
+static int
+has_suffix(const char *s, const char *suffix)
+{
+    size_t len = strlen(s), suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+/*
+ * Check whether a dump is (possibly) still being written by a running
+ * process.
+ */
+static int
+is_live_dump(const char *name)
+{
+    long pid;
+
+    if ( sscanf(name, DUMP_PREFIX "%ld", &pid) != 1 || pid <= 0 )
+        return 0;
+
+    return kill((pid_t) pid, 0) == 0 || errno == EPERM;
+}
+
+#if defined(HAVE_ZLIB_H)
+
+/*
+ * Compress a heap dump into a gzip file with the same name plus a .gz
+ * extension, then delete the original dump. The compressed dump keeps
+ * the modification time of the original, for rotation purposes. The
+ * compressed data is
+ * first written to a temporary file, which is only renamed once the
+ * compression is complete, so that an interrupted compression (e.g.
+ * because the launcher terminated in the meantime) never leaves a
+ * truncated dump behind.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+compress_dump(const char *path)
+{
+    FILE *in;
+    gzFile out;
+    char *tmp_path = NULL, *gz_path = NULL, *buffer;
+    size_t n;
+    int ret = 0;
+    struct stat st;
+    struct utimbuf times;
+
+    if ( stat(path, &st) == -1 || ! (in = fopen(path, "rb")) )
+        return -1;
+
+    (void) xasprintf(&gz_path, "%s.gz", path);
+    (void) xasprintf(&tmp_path, "%s" TEMP_SUFFIX, gz_path);
+
+    /* Favour speed over ratio, heap dumps compress well anyway. */
+    if ( ! (out = gzopen(tmp_path, "wb1")) )
+        ret = -1;
+
+    buffer = xmalloc(COPY_BUFFER_SIZE);
+    while ( ret == 0 && (n = fread(buffer, 1, COPY_BUFFER_SIZE, in)) > 0 ) {
+        if ( gzwrite(out, buffer, n) != (int) n )
+            ret = -1;
+    }
+    if ( ferror(in) )
+        ret = -1;
+    free(buffer);
+    fclose(in);
+
+    if ( out && gzclose(out) != Z_OK )
+        ret = -1;
+
+    times.actime = st.st_atime;
+    times.modtime = st.st_mtime;
+    if ( ret == 0 && utime(tmp_path, &times) == 0 && rename(tmp_path, gz_path) == 0 )
+        (void) unlink(path);
+    else
+        (void) unlink(tmp_path);
+
+    free(tmp_path);
+    free(gz_path);
+
+    return ret;
+}
+
+#endif
+
+/*
+ * Sort dumps from the newest to the oldest.
+ */
+static int
+compare_dumps(const void *a, const void *b)
+{
+    const struct dump_file *da = a, *db = b;
+
+    return da->mtime < db->mtime ? 1 : da->mtime > db->mtime ? -1 : 0;
+}
+
+/*
+ * Compress the heap dumps left by terminated processes, then delete
+ * the oldest dumps so that no more than the allowed number of dumps
+ * are kept, within the allowed quota. The most recent dump is always
+ * kept, and once a dump does not fit in the quota, no older dump is
+ * kept either.
+ */
+static void
+process_dumps(struct dump_manager *manager)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct dump_file *dumps = NULL;
+    size_t n_dumps = 0, allocated = 0, total = 0, kept = 0, i;
+    int full = 0;
+    char *path;
+    struct stat st;
+
+    if ( ! (dir = opendir(manager->dir)) )
+        return;
+
+    /* Collect the dumps first, as compressing them while reading the
+     * directory would add new entries to it. */
+    while ( (entry = readdir(dir)) ) {
+        if ( strncmp(entry->d_name, DUMP_PREFIX, strlen(DUMP_PREFIX)) != 0 )
+            continue;
+
+        if ( is_live_dump(entry->d_name) )
+            continue;
+
+        path = NULL;
+        (void) xasprintf(&path, "%s/%s", manager->dir, entry->d_name);
+
+        /* Leftover of an interrupted compression. */
+        if ( has_suffix(path, TEMP_SUFFIX) ) {
+            (void) unlink(path);
+            free(path);
+            continue;
+        }
+
+        if ( ! has_suffix(path, DUMP_SUFFIX) && ! has_suffix(path, COMPRESSED_SUFFIX) ) {
+            free(path);
+            continue;
+        }
+
+        if ( n_dumps >= allocated ) {
+            allocated += 10;
+            dumps = xrealloc(dumps, allocated * sizeof(struct dump_file));
+        }
+        dumps[n_dumps++].path = path;
+    }
+    closedir(dir);
+
+    for ( i = 0; i < n_dumps; i++ ) {
+#if defined(HAVE_ZLIB_H)
+        if ( has_suffix(dumps[i].path, DUMP_SUFFIX) && compress_dump(dumps[i].path) == 0 ) {
+            path = NULL;
+            (void) xasprintf(&path, "%s.gz", dumps[i].path);
+            free(dumps[i].path);
+            dumps[i].path = path;
+        }
+#endif
+
+        if ( stat(dumps[i].path, &st) == 0 ) {
+            dumps[i].mtime = st.st_mtime;
+            dumps[i].size = st.st_size;
+        }
+        else {
+            dumps[i].mtime = 0;
+            dumps[i].size = 0;
+        }
+    }
+
+    qsort(dumps, n_dumps, sizeof(struct dump_file), compare_dumps);
+    for ( i = 0; i < n_dumps; i++ ) {
+        /* Never trade the most recent dump for older, smaller ones. */
+        if ( i > 0 && manager->quota && total + dumps[i].size > manager->quota )
+            full = 1;
+
+        if ( ! full && kept < manager->count ) {
+            kept += 1;
+            total += dumps[i].size;
+        }
+        else
+            (void) unlink(dumps[i].path);
+
+        free(dumps[i].path);
+    }
+    free(dumps);
+}
+
+/*
+ * Body of the heap dump manager thread.
+ */
+static void *
+manage_dumps(void *arg)
+{
+    struct dump_manager *manager = arg;
+    char *lock_path = NULL;
+    int lock_fd;
+
+    set_thread_name("protege-dumps");
+
+#if defined(PROTEGE_LINUX)
+    /* Do not compete with Protégé for the CPU. */
+    (void) setpriority(PRIO_PROCESS, syscall(SYS_gettid), 19);
+#endif
+
+    /* Make sure no other instance of the launcher is processing the
+     * same directory. */
+    (void) xasprintf(&lock_path, "%s/" LOCK_FILE, manager->dir);
+    if ( (lock_fd = open(lock_path, O_RDWR | O_CREAT, 0600)) != -1 ) {
+        if ( flock(lock_fd, LOCK_EX | LOCK_NB) == 0 )
+            process_dumps(manager);
+        close(lock_fd);
+    }
+    free(lock_path);
+
+    free(manager->dir);
+    free(manager);
+
+    return NULL;
+}
+
+/**
+ * Start the heap dump manager. The manager runs in a background thread
+ * which compresses any heap dump left by a terminated Java virtual
+ * machine, and enforces the rotation policy. If the manager has
+ * already been started, this waits for the previous run to complete
+ * before starting a new one.
+ *
+ * The thread is not waited for when the launcher exits. If it is
+ * interrupted, it will resume its work the next time it is started.
+ *
+ * @param dir   The heap dump directory.
+ * @param count The maximal number of dumps to keep.
+ * @param quota The maximal size of all dumps in bytes, or 0 for no
+ *              limit.
+ */
+void
+start_heap_dump_manager(const char *dir, unsigned count, size_t quota)
+{
+    struct dump_manager *manager;
+
+    if ( manager_started ) {
+        (void) pthread_join(manager_thread, NULL);
+        manager_started = 0;
+    }
+
+    manager = xmalloc(sizeof(struct dump_manager));
+    manager->dir = xstrdup(dir);
+    manager->count = count;
+    manager->quota = quota;
+
+    if ( pthread_create(&manager_thread, NULL, manage_dumps, manager) == 0 )
+        manager_started = 1;
+    else {
+        free(manager->dir);
+        free(manager);
+    }
+}
+
+#endif /* !PROTEGE_WIN32 */
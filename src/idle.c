@@ -0,0 +1,201 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "idle.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdio.h>
+#include <string.h>
+#include <err.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "java.h"
+#include "jmx.h"
+#include "display.h"
+#include "util.h"
+
+/* How often to check whether the user is idle, in seconds. */
+#define IDLE_POLL_INTERVAL  30
+
+/* Heap free ratios while the user is away. */
+#define IDLE_MIN_FREE_RATIO "0"
+#define IDLE_MAX_FREE_RATIO "10"
+
+/* Lower bound for the soft heap size while the user is away. */
+#define IDLE_MIN_SOFT_MAX   (64 * 1024 * 1024)
+
+#define OPTION_VALUE_LEN    32
+
+/*
+ * State of the idle monitor.
+ */
+static struct {
+    unsigned long   delay;      /* Idle time before reducing the heap,
+                                   in milliseconds. */
+    int             reduced;    /* Whether the heap is currently reduced. */
+    char            min_free_ratio[OPTION_VALUE_LEN];
+    char            max_free_ratio[OPTION_VALUE_LEN];
+    char            soft_max_heap[OPTION_VALUE_LEN];
+} monitor;
+
+/*
+ * Let the virtual machine give back as much memory as possible. The
+ * free ratios make the heap shrink after a collection (with G1 and the
+ * other HotSpot collectors), and the soft heap size makes ZGC and
+ * Shenandoah uncommit memory; the options that do not exist in the
+ * running virtual machine are ignored.
+ */
+static void
+reduce_heap(JNIEnv *env)
+{
+    struct jvm_metrics metrics;
+    char value[OPTION_VALUE_LEN];
+    jlong soft_max;
+
+    if ( get_vm_option(env, "MinHeapFreeRatio", monitor.min_free_ratio, OPTION_VALUE_LEN) == -1
+            || get_vm_option(env, "MaxHeapFreeRatio", monitor.max_free_ratio,
+                             OPTION_VALUE_LEN) == -1 )
+        return;
+
+    /* Lower the minimum first, since it may not exceed the maximum. */
+    (void) set_vm_option(env, "MinHeapFreeRatio", IDLE_MIN_FREE_RATIO);
+    (void) set_vm_option(env, "MaxHeapFreeRatio", IDLE_MAX_FREE_RATIO);
+
+    monitor.soft_max_heap[0] = '\0';
+    if ( get_jvm_metrics(env, &metrics) == 0
+            && get_vm_option(env, "SoftMaxHeapSize", monitor.soft_max_heap,
+                             OPTION_VALUE_LEN) == 0 ) {
+        soft_max = metrics.heap_used + metrics.heap_used / 4;
+        if ( soft_max < IDLE_MIN_SOFT_MAX )
+            soft_max = IDLE_MIN_SOFT_MAX;
+        if ( soft_max < metrics.heap_max ) {
+            (void) snprintf(value, sizeof(value), "%lld", (long long) soft_max);
+            (void) set_vm_option(env, "SoftMaxHeapSize", value);
+        }
+    }
+
+    (void) run_gc(env);
+    monitor.reduced = 1;
+}
+
+/*
+ * Restore the options changed by reduce_heap.
+ */
+static void
+restore_heap(JNIEnv *env)
+{
+    /* Raise the maximum first, since the minimum may not exceed it. */
+    (void) set_vm_option(env, "MaxHeapFreeRatio", monitor.max_free_ratio);
+    (void) set_vm_option(env, "MinHeapFreeRatio", monitor.min_free_ratio);
+    if ( monitor.soft_max_heap[0] )
+        (void) set_vm_option(env, "SoftMaxHeapSize", monitor.soft_max_heap);
+
+    monitor.reduced = 0;
+}
+
+/*
+ * Main function of the idle monitor thread.
+ */
+static void *
+monitor_main(void *arg)
+{
+    JavaVM *jvm = arg;
+    JNIEnv *env;
+    JavaVMAttachArgs attach_args;
+    unsigned long idle_time;
+
+    attach_args.version = JNI_VERSION_1_2;
+    attach_args.name = "protege-idle";
+    attach_args.group = NULL;
+
+    set_thread_name(attach_args.name);
+
+    if ( (*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **) &env, &attach_args) != JNI_OK )
+        return NULL;
+
+    for ( ;; ) {
+        sleep(IDLE_POLL_INTERVAL);
+
+        if ( get_user_idle_time(&idle_time) == -1 )
+            break;  /* No X display, nothing we can do. */
+
+        if ( idle_time >= monitor.delay && ! monitor.reduced )
+            reduce_heap(env);
+        else if ( idle_time < monitor.delay && monitor.reduced )
+            restore_heap(env);
+    }
+
+    (*jvm)->DetachCurrentThread(jvm);
+    return NULL;
+}
+
+/*
+ * Called once the virtual machine has been created.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    (void) data;
+
+    if ( init_jmx(env) == -1 )
+        return;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, monitor_main, jvm) != 0 )
+        warn("Cannot start idle monitor");
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Monitor the user's activity on the X display, and let the virtual
+ * machine return memory to the system while the user is away. The
+ * monitor will start as soon as the virtual machine has been created.
+ *
+ * @param delay The time without any user input after which the user is
+ *              considered away, in minutes.
+ */
+void
+start_idle_monitor(unsigned delay)
+{
+    monitor.delay = delay * 60 * 1000UL;
+    add_java_callback(on_java_created, NULL);
+}
+
+#endif /* !PROTEGE_LINUX */
@@ -0,0 +1,162 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "interactive.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include <err.h>
+
+#include "util.h"
+#include "display.h"
+#include "report.h"
+
+/* How long to wait for the first window, in seconds. */
+#define WINDOW_TIMEOUT      600
+
+/* Interval between two measures of the CPU usage, in milliseconds. */
+#define IDLE_SAMPLE_INTERVAL    250
+
+/* Number of consecutive samples over which the process must be idle. */
+#define IDLE_SAMPLES        4
+
+/* CPU usage below which the process is considered idle, in percents
+ * of one processor. */
+#define IDLE_THRESHOLD      10
+
+/* How long to wait for the process to become idle, in samples. */
+#define IDLE_TIMEOUT        (WINDOW_TIMEOUT * 1000 / IDLE_SAMPLE_INTERVAL)
+
+/*
+ * Get the CPU time used by the process so far, in milliseconds.
+ */
+static uint64_t
+get_cpu_time(void)
+{
+    struct rusage usage;
+
+    if ( getrusage(RUSAGE_SELF, &usage) == -1 )
+        return 0;
+
+    return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
+/*
+ * Wait for the process to become idle, that is, for the first period
+ * of IDLE_SAMPLES samples during which it used less than
+ * IDLE_THRESHOLD percents of one processor.
+ *
+ * Returns the time at which that period started, in milliseconds since
+ * the start of the process, or 0 if the process never became idle.
+ */
+static uint64_t
+wait_for_idle(void)
+{
+    struct timespec delay;
+    uint64_t cpu[IDLE_SAMPLES + 1], times[IDLE_SAMPLES + 1];
+    unsigned n, first;
+
+    delay.tv_sec = IDLE_SAMPLE_INTERVAL / 1000;
+    delay.tv_nsec = (IDLE_SAMPLE_INTERVAL % 1000) * 1000000;
+
+    for ( n = 0; n < IDLE_TIMEOUT; n++ ) {
+        cpu[n % (IDLE_SAMPLES + 1)] = get_cpu_time();
+        times[n % (IDLE_SAMPLES + 1)] = get_session_time();
+
+        if ( n >= IDLE_SAMPLES ) {
+            first = (n - IDLE_SAMPLES) % (IDLE_SAMPLES + 1);
+            if ( (cpu[n % (IDLE_SAMPLES + 1)] - cpu[first]) * 100
+                    < (times[n % (IDLE_SAMPLES + 1)] - times[first]) * IDLE_THRESHOLD )
+                return times[first];
+        }
+
+        nanosleep(&delay, NULL);
+    }
+
+    return 0;
+}
+
+/*
+ * Main function of the watching thread.
+ */
+static void *
+watch_main(void *arg)
+{
+    uint64_t idle_time;
+
+    (void) arg;
+
+    set_thread_name("protege-tti");
+
+    if ( wait_for_window(getpid(), WINDOW_TIMEOUT) == -1 )
+        return NULL;
+
+    add_report_value("time_to_window_ms", get_session_time());
+
+    if ( (idle_time = wait_for_idle()) )
+        add_report_value("time_to_idle_ms", idle_time);
+
+    /* Let benchmarks know without waiting for Protégé to exit. */
+    write_session_report();
+
+    return NULL;
+}
+
+/**
+ * Start measuring the time Protégé takes to become usable: the time
+ * until it maps its first window on the X display, and the time until
+ * it becomes idle after that. The results are added to the session
+ * report.
+ */
+void
+start_interactive_watch(void)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, watch_main, NULL) != 0 )
+        warn("Cannot start the time-to-interactive measure");
+    pthread_attr_destroy(&attr);
+}
+
+#endif
@@ -34,16 +34,19 @@
 
 #include "java.h"
 
+#include <stdio.h>
+#include <string.h>
 #include <dlfcn.h>
 
 #include <jni.h>
 
 #include <xmem.h>
 
+#include "util.h"
+
 #if defined(PROTEGE_WIN32)
 #include <windows.h>    /* SetDllDirectory */
 #include <shlwapi.h>    /* PathFileExists */
-#include <string.h>     /* strrchr */
 #endif
 
 
@@ -62,33 +65,66 @@
 #endif
 
 /*
- * BUNDLED_JAVA_LIB_PATH is the location of the Java library within
- * Protégé's directory, when using the bundled JRE.
+ * SPLASH_LIB_PATH is the name and location of the library providing
+ * the native splash screen within the JRE.
+ */
+#if   defined(PROTEGE_LINUX)
+#define SPLASH_LIB_PATH "/lib/libsplashscreen.so"
+#elif defined(PROTEGE_MACOS)
+#define SPLASH_LIB_PATH "/lib/libsplashscreen.dylib"
+#elif defined(PROTEGE_WIN32)
+#define SPLASH_LIB_PATH "\\bin\\splashscreen.dll"
+#endif
+
+/*
+ * BUNDLED_JRE_PATH is the location of the bundled JRE within
+ * Protégé's directory.
  */
 #if defined(PROTEGE_WIN32)
-#define BUNDLED_JAVA_LIB_PATH "\\jre" JAVA_LIB_PATH
+#define BUNDLED_JRE_PATH "\\jre"
 #else
-#define BUNDLED_JAVA_LIB_PATH "/jre" JAVA_LIB_PATH
+#define BUNDLED_JRE_PATH "/jre"
 #endif
 
 
 typedef jint (JNICALL CreateJavaVM_t)(JavaVM **vm, JNIEnv **env, JavaVMInitArgs *args);
 
+/* Functions exported by the splash screen library. */
+typedef void (SplashInit_t)(void);
+typedef int  (SplashLoadFile_t)(const char *filename);
+typedef void (SplashSetFileJarName_t)(const char *filename, const char *jarname);
+typedef void (SplashClose_t)(void);
+
+static void *splash_lib = NULL;
+
+/* Callbacks to call once the virtual machine has been created. */
+#define MAX_JAVA_CALLBACKS 8
+
+static struct {
+    java_callback_t callback;
+    void           *data;
+} java_callbacks[MAX_JAVA_CALLBACKS];
+
+static size_t n_java_callbacks = 0;
+
+/* Whether JNI_CreateJavaVM is running. */
+static volatile int creating_java = 0;
+
 
 /*
  * Catenate the two specified path components and attempt to load the
- * Java library from the resulting full pathname.
+ * library from the resulting full pathname.
  *
  * Returns a handle to the loaded library if loading was successful,
  * otherwise NULL.
  */
 void*
-load_jre_from_path(const char *base_path, const char *lib_path)
+load_jre_from_path(const char *java_home, const char *lib_path)
 {
     void *lib;
     char *full_path = NULL;
 
-    (void) xasprintf(&full_path, "%s%s", base_path, lib_path);
+    (void) xasprintf(&full_path, "%s%s", java_home, lib_path);
 
 #if defined(PROTEGE_WIN32)
     /*
@@ -100,13 +136,9 @@ load_jre_from_path(const char *base_path, const char *lib_path)
      * DLL search path before attempting to use LoadLibrary.
      */
     if ( PathFileExists(full_path) ) {
-        char *bin_path, *last_slash;
-        int n = 2;
-
-        bin_path = xstrdup(full_path);
-        while ( n-- > 0 && (last_slash = strrchr(bin_path, '\\')) )
-            *last_slash = '\0';
+        char *bin_path = NULL;
 
+        (void) xasprintf(&bin_path, "%s\\bin", java_home);
         (void) SetDllDirectory(bin_path);
         free(bin_path);
     }
@@ -124,43 +156,223 @@ load_jre_from_path(const char *base_path, const char *lib_path)
     return lib;
 }
 
+/*
+ * Attempt to load the Java library from the specified JRE directory.
+ * If successful and java_home is not NULL, it receives a copy of the
+ * JRE directory.
+ */
+static void *
+try_java_home(const char *path, char **java_home)
+{
+    void *lib;
+
+    if ( (lib = load_jre_from_path(path, JAVA_LIB_PATH)) && java_home )
+        *java_home = xstrdup(path);
+
+    return lib;
+}
+
 /**
  * Attempt to load the Java library.
  *
- * @param[in] path    The base directory from where the Java library
- *                    should be loaded; if NULL, PROTEGE_JAVA_HOME and
- *                    JAVA_HOME will be successively tested if they are
- *                    defined in the environment.
- * @param[in] bundled If non-zero, @a path is expected to be the
- *                    Protégé directory, and the Java library will be
- *                    looked for in the jre/ subdirectory; otherwise,
- *                    @a path is assumed to be a JRE directory.
- * @param[out] jre    A pointer that will receive the handle to the
- *                    Java library after it has been loaded.
+ * @param[in] path       The base directory from where the Java library
+ *                       should be loaded; if NULL, PROTEGE_JAVA_HOME
+ *                       and JAVA_HOME will be successively tested if
+ *                       they are defined in the environment.
+ * @param[in] bundled    If non-zero, @a path is expected to be the
+ *                       Protégé directory, and the Java library will be
+ *                       looked for in the jre/ subdirectory; otherwise,
+ *                       @a path is assumed to be a JRE directory.
+ * @param[out] jre       A pointer that will receive the handle to the
+ *                       Java library after it has been loaded.
+ * @param[out] java_home If not NULL, a pointer that will receive a
+ *                       newly allocated buffer containing the directory
+ *                       of the JRE that was loaded.
  *
  * @return
  * - 0 if the Java library has been successfully loaded;
  * - JAVA_DLOPEN_ERROR if an error occured.
  */
 int
-load_jre(const char *path, int bundled, void **jre)
+load_jre(const char *path, int bundled, void **jre, char **java_home)
 {
     void *lib = NULL;
 
-    if ( path )
-        lib = load_jre_from_path(path, bundled ?
-                                 BUNDLED_JAVA_LIB_PATH : JAVA_LIB_PATH);
+    if ( path ) {
+        if ( bundled ) {
+            char *bundled_home = NULL;
+
+            (void) xasprintf(&bundled_home, "%s" BUNDLED_JRE_PATH, path);
+            lib = try_java_home(bundled_home, java_home);
+            free(bundled_home);
+        }
+        else
+            lib = try_java_home(path, java_home);
+    }
 
     if ( ! lib && (path = getenv("PROTEGE_JAVA_HOME")) )
-        lib = load_jre_from_path(path, JAVA_LIB_PATH);
+        lib = try_java_home(path, java_home);
 
     if ( ! lib && (path = getenv("JAVA_HOME")) )
-        lib = load_jre_from_path(path, JAVA_LIB_PATH);
+        lib = try_java_home(path, java_home);
 
     *jre = lib;
     return lib ? 0 : JAVA_DLOPEN_ERROR;
 }
 
+/*
+ * Parse a Java version string, either old-style (1.8.0_352) or new-style
+ * (11.0.16, 17, 21.0.1+12).
+ *
+ * Returns the version encoded by JRE_VERSION, or 0 if the string is not
+ * a valid version.
+ */
+static unsigned
+parse_java_version(const char *value)
+{
+    unsigned parts[3] = { 0, 0, 0 };
+    char *end;
+    int n;
+
+    if ( strncmp(value, "1.", 2) == 0 )
+        value += 2;
+
+    for ( n = 0; n < 3; n++ ) {
+        if ( *value < '0' || *value > '9' )
+            break;
+        parts[n] = (unsigned) strtoul(value, &end, 10);
+        if ( *end != '.' && *end != '_' ) {
+            n += 1;
+            break;
+        }
+        value = end + 1;
+    }
+
+    if ( n == 0 || parts[0] == 0 || parts[1] >= 1000 || parts[2] >= 1000 )
+        return 0;
+
+    return JRE_VERSION(parts[0], parts[1], parts[2]);
+}
+
+/**
+ * Get information about a JRE from its release file.
+ *
+ * @param[in] java_home The directory of the JRE.
+ * @param[out] info     The structure to fill; it should be freed with
+ *                      free_jre_info after use. If the release file
+ *                      cannot be read, the structure is filled with
+ *                      "unknown" values.
+ *
+ * @return 0 if the version of the JRE could be found, otherwise -1.
+ */
+int
+get_jre_info(const char *java_home, struct jre_info *info)
+{
+    FILE *f;
+    char *path = NULL, line[1024], *value;
+    size_t len;
+
+    info->version = 0;
+    info->implementor = NULL;
+
+    (void) xasprintf(&path, "%s/release", java_home);
+    f = fopen(path, "r");
+    free(path);
+    if ( ! f )
+        return -1;
+
+    while ( ! feof(f) ) {
+        if ( get_line(f, line, sizeof(line)) <= 0 || ! (value = strchr(line, '=')) )
+            continue;
+
+        *value++ = '\0';
+        if ( *value == '"' && (len = strlen(value)) > 1 && value[len - 1] == '"' ) {
+            value[len - 1] = '\0';
+            value += 1;
+        }
+
+        if ( strcmp(line, "JAVA_VERSION") == 0 )
+            info->version = parse_java_version(value);
+        else if ( strcmp(line, "IMPLEMENTOR") == 0 && ! info->implementor )
+            info->implementor = xstrdup(value);
+    }
+    fclose(f);
+
+    return info->version ? 0 : -1;
+}
+
+/**
+ * Free the resources associated with a jre_info structure.
+ *
+ * @param info The structure to free.
+ */
+void
+free_jre_info(struct jre_info *info)
+{
+    if ( info->implementor )
+        free(info->implementor);
+    info->implementor = NULL;
+}
+
+/**
+ * Show a splash screen before the Java virtual machine is started.
+ *
+ * This uses the splash screen library of the JRE, as the standard
+ * java launcher does when given the -splash: option. Once the virtual
+ * machine is running, Java code can take over the splash screen through
+ * the java.awt.SplashScreen class.
+ *
+ * @param java_home The directory of the JRE in use.
+ * @param image     The pathname to the image to display.
+ *
+ * @return 0 if the splash screen is displayed, or -1 if it could not
+ *         be displayed for whatever reason.
+ */
+int
+show_splash_screen(const char *java_home, const char *image)
+{
+    SplashInit_t *splash_init;
+    SplashLoadFile_t *splash_load_file;
+    SplashSetFileJarName_t *splash_set_file_jar_name;
+
+    if ( ! (splash_lib = load_jre_from_path(java_home, SPLASH_LIB_PATH)) )
+        return -1;
+
+    splash_init = (SplashInit_t *)dlsym(splash_lib, "SplashInit");
+    splash_load_file = (SplashLoadFile_t *)dlsym(splash_lib, "SplashLoadFile");
+    splash_set_file_jar_name = (SplashSetFileJarName_t *)dlsym(splash_lib,
+                                                               "SplashSetFileJarName");
+    if ( ! splash_init || ! splash_load_file ) {
+        dlclose(splash_lib);
+        splash_lib = NULL;
+        return -1;
+    }
+
+    splash_init();
+
+    /* Let java.awt.SplashScreen.getImageURL() know about the image. */
+    if ( splash_set_file_jar_name )
+        splash_set_file_jar_name(image, NULL);
+
+    return splash_load_file(image) ? 0 : -1;
+}
+
+/**
+ * Close the splash screen, if any. This is only needed if we fail to
+ * start Java; otherwise, closing the splash screen is the
+ * responsibility of the Java code.
+ */
+void
+close_splash_screen(void)
+{
+    SplashClose_t *splash_close;
+
+    if ( splash_lib ) {
+        if ( (splash_close = (SplashClose_t *)dlsym(splash_lib, "SplashClose")) )
+            splash_close();
+    }
+}
+
 /*
  * Convert the specified char ** array into an equivalent Java array.
  *
@@ -239,6 +451,38 @@ get_java_options(const char **options, jint *n_options)
     return jvm_opts;
 }
 
+/**
+ * Register a function to be called once the Java virtual machine has
+ * been successfully created, before the main class is started. The
+ * function is called on the thread that created the virtual machine.
+ *
+ * @param callback The function to call.
+ * @param data     An arbitrary pointer to pass to the function.
+ */
+void
+add_java_callback(java_callback_t callback, void *data)
+{
+    if ( n_java_callbacks < MAX_JAVA_CALLBACKS ) {
+        java_callbacks[n_java_callbacks].callback = callback;
+        java_callbacks[n_java_callbacks].data = data;
+        n_java_callbacks += 1;
+    }
+}
+
+/**
+ * Check whether the Java virtual machine is being created. This is
+ * meant to be called from an exit handler, to tell whether the virtual
+ * machine aborted during its initialisation.
+ *
+ * @return 1 if JNI_CreateJavaVM has been called and has not returned,
+ *         otherwise 0.
+ */
+int
+is_creating_java(void)
+{
+    return creating_java;
+}
+
 /**
  * Start the Java virtual machine.
  *
@@ -250,7 +494,7 @@ get_java_options(const char **options, jint *n_options)
  *
  * @return 0 if successful, or one of the JAVA_* error values.
  */
-#if !defined(PROTEGE_MACOS)
+#if defined(PROTEGE_WIN32)
 int
 start_java(void        *jre,
            const char **vm_args,
@@ -268,6 +512,7 @@ start_java_impl(void        *jre,
     JavaVMInitArgs jvm_args;
     JNIEnv *env;
     CreateJavaVM_t *create_java_vm = NULL;
+    size_t n;
     int ret = 0;
 
     jvm_args.version = JNI_VERSION_1_2;
@@ -277,8 +522,17 @@ start_java_impl(void        *jre,
     if ( ret == 0 && ! (create_java_vm = (CreateJavaVM_t *)dlsym(jre, "JNI_CreateJavaVM")) )
         ret = JAVA_SYMBOL_NOT_FOUND;
 
-    if ( ret == 0 && create_java_vm(&jvm, &env, &jvm_args) == JNI_ERR )
-        ret = JAVA_CREATE_VM_ERROR;
+    if ( ret == 0 ) {
+        creating_java = 1;
+        if ( create_java_vm(&jvm, &env, &jvm_args) != JNI_OK ) {
+            jvm = NULL;
+            ret = JAVA_CREATE_VM_ERROR;
+        }
+        creating_java = 0;
+    }
+
+    for ( n = 0; ret == 0 && n < n_java_callbacks; n++ )
+        java_callbacks[n].callback(jvm, env, java_callbacks[n].data);
 
     if ( ret == 0 )
         ret = start_java_main(env, main_class, main_args);
@@ -301,49 +555,101 @@ start_java_impl(void        *jre,
     return ret;
 }
 
-#if defined(PROTEGE_MACOS)
+#if !defined(PROTEGE_WIN32)
 
 /*
- * On macOS, the Java virtual machine must be started in a separate
- * thread, while the first thread runs an infinite loop. This is needed
- * to properly receive events from the operating system.
+ * On GNU/Linux and macOS, the Java virtual machine is started in a
+ * separate thread. On macOS, this is needed to properly receive events
+ * from the operating system, as the first thread must run an infinite
+ * loop. On both systems, this allows to run the virtual machine on a
+ * thread with the stack size requested by -Xss, as the standard java
+ * launcher does, instead of the primordial thread whose stack size is
+ * set by `ulimit -s`.
  */
 
-#include <err.h>
+#include <string.h>
 #include <pthread.h>
+
+#if defined(PROTEGE_MACOS)
 #include <CoreFoundation/CoreFoundation.h>
 
-/*Dummy callback for the main thread loop. */
+/* Callback to stop the main thread loop. */
 static void
-dummy_callback(void *info) { }
+stop_loop_callback(void *info)
+{
+    CFRunLoopStop(CFRunLoopGetCurrent());
+}
+#endif
 
 /* Wrap the parameters to the real start_java function. */
 struct java_start_info
 {
-    void        *jre;
-    const char **vm_args;
-    const char  *main_class;
-    const char **main_args;
+    void               *jre;
+    const char        **vm_args;
+    const char         *main_class;
+    const char        **main_args;
+    int                 ret;
+#if defined(PROTEGE_MACOS)
+    CFRunLoopRef        loop;
+    CFRunLoopSourceRef  loop_source;
+#endif
 };
 
 /*
  * The function that will run in the dedicated thread. Merely a wrapper
- * for the start_java_impl function above. Explicitly calls exit at the
- * end (whether start_java_impl was successful or not) to cause the
- * dummy loop in the first thread to stop.
+ * for the start_java_impl function above.
+ *
+ * On macOS, explicitly calls exit at the end if start_java_impl was
+ * successful, to cause the loop in the first thread to stop; if it was
+ * not, the loop is stopped so that the error can be reported from the
+ * first thread.
  */
 static void *
 start_java_wrapper(void *info)
 {
     struct java_start_info *jinfo;
-    int ret;
+#if defined(PROTEGE_MACOS)
+    CFRunLoopRef loop;
+    CFRunLoopSourceRef loop_source;
+#endif
+
+    set_thread_name("protege-vm");
 
     jinfo = (struct java_start_info *)info;
-    if ( (ret = start_java_impl(jinfo->jre, jinfo->vm_args, jinfo->main_class,
-                                jinfo->main_args)) != 0 )
-        errx(EXIT_FAILURE, "Cannot start Java: %s", get_java_error(ret));
+    jinfo->ret = start_java_impl(jinfo->jre, jinfo->vm_args, jinfo->main_class,
+                                 jinfo->main_args);
 
-    exit(EXIT_SUCCESS);
+#if defined(PROTEGE_MACOS)
+    if ( jinfo->ret == 0 )
+        exit(EXIT_SUCCESS);
+
+    /* Once the source is signalled, the first thread may return from
+     * start_java at any time, and jinfo (on its stack) is gone. */
+    loop = jinfo->loop;
+    loop_source = jinfo->loop_source;
+    CFRunLoopSourceSignal(loop_source);
+    CFRunLoopWakeUp(loop);
+#endif
+
+    return NULL;
+}
+
+/*
+ * Get the thread stack size requested with a -Xss option.
+ *
+ * Returns the stack size in bytes, or 0 if no stack size has been
+ * explicitly requested.
+ */
+static size_t
+get_stack_size(const char **vm_args)
+{
+    size_t n, stack_size = 0;
+
+    for ( n = 0; vm_args && vm_args[n]; n++ )
+        if ( strncmp(vm_args[n], "-Xss", 4) == 0 )
+            stack_size = get_memory_amount(vm_args[n] + 4);
+
+    return stack_size;
 }
 
 /*
@@ -357,31 +663,54 @@ start_java(void        *jre,
 {
     pthread_t jvm_thread;
     pthread_attr_t jvm_thread_attr;
-    CFRunLoopSourceContext loop_context;
-    CFRunLoopSourceRef loop_ref;
     struct java_start_info info;
+    size_t stack_size;
+#if defined(PROTEGE_MACOS)
+    CFRunLoopSourceContext loop_context;
+#endif
 
     info.jre = jre;
     info.vm_args = vm_args;
     info.main_class = main_class;
     info.main_args = main_args;
+    info.ret = 0;
 
-    /* Start the thread where the JVM will run. */
     pthread_attr_init(&jvm_thread_attr);
     pthread_attr_setscope(&jvm_thread_attr, PTHREAD_SCOPE_SYSTEM);
+    if ( (stack_size = get_stack_size(vm_args)) > 0 )
+        /* Ignore errors, the default stack size will be used. */
+        (void) pthread_attr_setstacksize(&jvm_thread_attr, stack_size);
+
+#if defined(PROTEGE_MACOS)
+    /* Prepare the loop for the main thread, before the JVM thread
+     * has any chance to signal it. */
+    memset(&loop_context, 0, sizeof(loop_context));
+    loop_context.perform = &stop_loop_callback;
+    info.loop = CFRunLoopGetCurrent();
+    info.loop_source = CFRunLoopSourceCreate(NULL, 0, &loop_context);
+    CFRunLoopAddSource(info.loop, info.loop_source, kCFRunLoopCommonModes);
+
     pthread_attr_setdetachstate(&jvm_thread_attr, PTHREAD_CREATE_DETACHED);
+#endif
+
+    /* Start the thread where the JVM will run. */
     if ( pthread_create(&jvm_thread, &jvm_thread_attr, start_java_wrapper,
-                        (void *)&info) != 0 )
+                        (void *)&info) != 0 ) {
+        pthread_attr_destroy(&jvm_thread_attr);
         return JAVA_CREATE_THREAD_ERROR;
+    }
+    pthread_attr_destroy(&jvm_thread_attr);
 
+#if defined(PROTEGE_MACOS)
     /* Run a dummy loop in the main thread. */
-    memset(&loop_context, 0, sizeof(loop_context));
-    loop_context.perform = &dummy_callback;
-    loop_ref = CFRunLoopSourceCreate(NULL, 0, &loop_context);
-    CFRunLoopAddSource(CFRunLoopGetCurrent(), loop_ref, kCFRunLoopCommonModes);
     CFRunLoopRun();
+    CFRelease(info.loop_source);
+#else
+    /* Wait for the JVM to terminate. */
+    (void) pthread_join(jvm_thread, NULL);
+#endif
 
-    return 0;
+    return info.ret;
 }
 
 #endif
@@ -41,12 +41,53 @@
 #define JAVA_CREATE_THREAD_ERROR    -6
 #define JAVA_DLOPEN_ERROR           -7
 
+/*
+ * Encode a Java version number so that versions can be compared.
+ * Old-style versions are normalised, so that 1.8.0_352 is encoded
+ * as JRE_VERSION(8, 0, 352).
+ */
+#define JRE_VERSION(feature, interim, update) \
+    ((((feature) * 1000) + (interim)) * 1000 + (update))
+
+/*
+ * Information about a JRE, as found in its release file.
+ */
+struct jre_info {
+    unsigned    version;        /* As encoded by JRE_VERSION, or 0 if
+                                   the version is unknown. */
+    char       *implementor;    /* Vendor of the JRE, or NULL. */
+};
+
+/*
+ * A function to call once the Java virtual machine has been created,
+ * before the main class is started.
+ */
+typedef void (*java_callback_t)(JavaVM *jvm, JNIEnv *env, void *data);
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int
-load_jre(const char *path, int bundled, void **jre);
+load_jre(const char *path, int bundled, void **jre, char **java_home);
+
+int
+get_jre_info(const char *java_home, struct jre_info *info);
+
+void
+free_jre_info(struct jre_info *info);
+
+int
+show_splash_screen(const char *java_home, const char *image);
+
+void
+close_splash_screen(void);
+
+void
+add_java_callback(java_callback_t callback, void *data);
+
+int
+is_creating_java(void);
 
 int
 start_java(void        *jre,
@@ -0,0 +1,526 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "jmx.h"
+
+#include <string.h>
+
+#include <xmem.h>
+
+/*
+ * Cached references to the management beans and their methods. The
+ * platform beans are singletons, and the list of garbage collectors
+ * does not change once the virtual machine is running, so they only
+ * need to be looked up once.
+ */
+static struct {
+    int         initialised;
+    jobject     memory_bean;
+    jobject     thread_bean;
+    jobject     class_bean;
+    jobjectArray
+                gc_beans;
+    jmethodID   get_heap_usage;
+    jmethodID   get_nonheap_usage;
+    jmethodID   get_used;
+    jmethodID   get_committed;
+    jmethodID   get_max;
+    jmethodID   get_collection_count;
+    jmethodID   get_collection_time;
+    jmethodID   get_thread_count;
+    jmethodID   get_daemon_thread_count;
+    jmethodID   get_loaded_class_count;
+    jobject     diagnostic_bean;        /* May be NULL. */
+    jmethodID   get_vm_option;
+    jmethodID   set_vm_option;
+    jmethodID   get_option_value;
+    jobject     mbean_server;           /* May be NULL. */
+    jobject     diagnostic_command;     /* May be NULL. */
+    jmethodID   invoke;
+    jclass      string_class;
+} jmx;
+
+/*
+ * Look up a method in the specified class.
+ *
+ * Returns the method ID, or NULL if either the class or the method
+ * cannot be found (or if an exception is already pending).
+ */
+static jmethodID
+get_method(JNIEnv *env, const char *class_name, const char *name, const char *signature)
+{
+    jclass class;
+    jmethodID method = NULL;
+
+    if ( (*env)->ExceptionCheck(env) )
+        return NULL;
+
+    if ( (class = (*env)->FindClass(env, class_name)) ) {
+        method = (*env)->GetMethodID(env, class, name, signature);
+        (*env)->DeleteLocalRef(env, class);
+    }
+
+    return method;
+}
+
+/*
+ * Get a global reference to one of the platform beans, by calling the
+ * specified static method of the ManagementFactory class.
+ */
+static jobject
+get_platform_bean(JNIEnv *env, jclass factory, const char *name, const char *signature)
+{
+    jmethodID method;
+    jobject bean, global = NULL;
+
+    if ( (*env)->ExceptionCheck(env) )
+        return NULL;
+
+    if ( (method = (*env)->GetStaticMethodID(env, factory, name, signature))
+            && (bean = (*env)->CallStaticObjectMethod(env, factory, method)) ) {
+        global = (*env)->NewGlobalRef(env, bean);
+        (*env)->DeleteLocalRef(env, bean);
+    }
+
+    return global;
+}
+
+/*
+ * Look up the HotSpotDiagnosticMXBean, which allows to change the
+ * manageable -XX options of a running virtual machine. It is not
+ * available on all virtual machines.
+ */
+static void
+init_diagnostic_bean(JNIEnv *env)
+{
+    jclass factory, bean_class;
+    jmethodID get_bean;
+    jobject bean;
+
+    if ( (*env)->PushLocalFrame(env, 8) != JNI_OK )
+        return;
+
+    if ( (factory = (*env)->FindClass(env, "java/lang/management/ManagementFactory"))
+            && (bean_class = (*env)->FindClass(env, "com/sun/management/HotSpotDiagnosticMXBean"))
+            && (get_bean = (*env)->GetStaticMethodID(env, factory, "getPlatformMXBean",
+                    "(Ljava/lang/Class;)Ljava/lang/management/PlatformManagedObject;"))
+            && (bean = (*env)->CallStaticObjectMethod(env, factory, get_bean, bean_class)) ) {
+        jmx.get_vm_option = (*env)->GetMethodID(env, bean_class, "getVMOption",
+                "(Ljava/lang/String;)Lcom/sun/management/VMOption;");
+        jmx.set_vm_option = (*env)->GetMethodID(env, bean_class, "setVMOption",
+                "(Ljava/lang/String;Ljava/lang/String;)V");
+        jmx.get_option_value = get_method(env, "com/sun/management/VMOption",
+                "getValue", "()Ljava/lang/String;");
+
+        if ( jmx.get_vm_option && jmx.set_vm_option && jmx.get_option_value )
+            jmx.diagnostic_bean = (*env)->NewGlobalRef(env, bean);
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        if ( jmx.diagnostic_bean )
+            (*env)->DeleteGlobalRef(env, jmx.diagnostic_bean);
+        jmx.diagnostic_bean = NULL;
+    }
+}
+
+/*
+ * Look up the DiagnosticCommand MBean, which provides the same commands
+ * as the jcmd tool.
+ */
+static void
+init_diagnostic_command(JNIEnv *env)
+{
+    jclass factory, name_class, server_class, string_class;
+    jmethodID get_server, constructor;
+    jobject server, name;
+    jstring jname;
+
+    if ( (*env)->PushLocalFrame(env, 16) != JNI_OK )
+        return;
+
+    if ( (factory = (*env)->FindClass(env, "java/lang/management/ManagementFactory"))
+            && (get_server = (*env)->GetStaticMethodID(env, factory, "getPlatformMBeanServer",
+                                                       "()Ljavax/management/MBeanServer;"))
+            && (server = (*env)->CallStaticObjectMethod(env, factory, get_server))
+            && (name_class = (*env)->FindClass(env, "javax/management/ObjectName"))
+            && (constructor = (*env)->GetMethodID(env, name_class, "<init>",
+                                                  "(Ljava/lang/String;)V"))
+            && (jname = (*env)->NewStringUTF(env, "com.sun.management:type=DiagnosticCommand"))
+            && (name = (*env)->NewObject(env, name_class, constructor, jname))
+            && (server_class = (*env)->FindClass(env, "javax/management/MBeanServerConnection"))
+            && (jmx.invoke = (*env)->GetMethodID(env, server_class, "invoke",
+                    "(Ljavax/management/ObjectName;Ljava/lang/String;[Ljava/lang/Object;"
+                    "[Ljava/lang/String;)Ljava/lang/Object;"))
+            && (string_class = (*env)->FindClass(env, "java/lang/String")) ) {
+        jmx.mbean_server = (*env)->NewGlobalRef(env, server);
+        jmx.diagnostic_command = (*env)->NewGlobalRef(env, name);
+        jmx.string_class = (*env)->NewGlobalRef(env, string_class);
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        jmx.mbean_server = NULL;
+    }
+}
+
+/**
+ * Look up the management beans used by the other functions of this
+ * module. This must be called before any other function. This function
+ * is not thread-safe: it should be called from a callback registered
+ * with add_java_callback, before starting any thread that uses this
+ * module.
+ *
+ * @param env The JNI environment of the calling thread.
+ *
+ * @return 0 if successful, or -1 if the management beans are not
+ *         available.
+ */
+int
+init_jmx(JNIEnv *env)
+{
+    jclass factory, list_class;
+    jobject gc_list;
+    jmethodID to_array;
+
+    if ( jmx.initialised )
+        return 0;
+
+    if ( (*env)->PushLocalFrame(env, 16) != JNI_OK )
+        return -1;
+
+    if ( (factory = (*env)->FindClass(env, "java/lang/management/ManagementFactory")) ) {
+        jmx.memory_bean = get_platform_bean(env, factory, "getMemoryMXBean",
+                                            "()Ljava/lang/management/MemoryMXBean;");
+        jmx.thread_bean = get_platform_bean(env, factory, "getThreadMXBean",
+                                            "()Ljava/lang/management/ThreadMXBean;");
+        jmx.class_bean = get_platform_bean(env, factory, "getClassLoadingMXBean",
+                                           "()Ljava/lang/management/ClassLoadingMXBean;");
+
+        /* Convert the list of collectors to an array once and for all. */
+        if ( (gc_list = get_platform_bean(env, factory, "getGarbageCollectorMXBeans",
+                                          "()Ljava/util/List;")) ) {
+            if ( (list_class = (*env)->FindClass(env, "java/util/List"))
+                    && (to_array = (*env)->GetMethodID(env, list_class, "toArray",
+                                                       "()[Ljava/lang/Object;")) )
+                jmx.gc_beans = (*env)->NewGlobalRef(env,
+                        (*env)->CallObjectMethod(env, gc_list, to_array));
+            (*env)->DeleteGlobalRef(env, gc_list);
+        }
+    }
+
+    jmx.get_heap_usage = get_method(env, "java/lang/management/MemoryMXBean",
+            "getHeapMemoryUsage", "()Ljava/lang/management/MemoryUsage;");
+    jmx.get_nonheap_usage = get_method(env, "java/lang/management/MemoryMXBean",
+            "getNonHeapMemoryUsage", "()Ljava/lang/management/MemoryUsage;");
+    jmx.get_used = get_method(env, "java/lang/management/MemoryUsage", "getUsed", "()J");
+    jmx.get_committed = get_method(env, "java/lang/management/MemoryUsage",
+            "getCommitted", "()J");
+    jmx.get_max = get_method(env, "java/lang/management/MemoryUsage", "getMax", "()J");
+    jmx.get_collection_count = get_method(env, "java/lang/management/GarbageCollectorMXBean",
+            "getCollectionCount", "()J");
+    jmx.get_collection_time = get_method(env, "java/lang/management/GarbageCollectorMXBean",
+            "getCollectionTime", "()J");
+    jmx.get_thread_count = get_method(env, "java/lang/management/ThreadMXBean",
+            "getThreadCount", "()I");
+    jmx.get_daemon_thread_count = get_method(env, "java/lang/management/ThreadMXBean",
+            "getDaemonThreadCount", "()I");
+    jmx.get_loaded_class_count = get_method(env, "java/lang/management/ClassLoadingMXBean",
+            "getLoadedClassCount", "()I");
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        return -1;
+    }
+
+    /* The HotSpot-specific beans are optional. */
+    init_diagnostic_bean(env);
+    init_diagnostic_command(env);
+
+    if ( ! jmx.memory_bean || ! jmx.thread_bean || ! jmx.class_bean || ! jmx.gc_beans
+            || ! jmx.get_heap_usage || ! jmx.get_nonheap_usage || ! jmx.get_used
+            || ! jmx.get_committed || ! jmx.get_max || ! jmx.get_collection_count
+            || ! jmx.get_collection_time || ! jmx.get_thread_count
+            || ! jmx.get_daemon_thread_count || ! jmx.get_loaded_class_count )
+        return -1;
+
+    jmx.initialised = 1;
+    return 0;
+}
+
+/*
+ * Get the used, committed and maximal sizes of a memory area.
+ */
+static void
+get_memory_usage(JNIEnv *env, jmethodID method, jlong *used, jlong *committed, jlong *max)
+{
+    jobject usage;
+
+    if ( (usage = (*env)->CallObjectMethod(env, jmx.memory_bean, method)) ) {
+        *used = (*env)->CallLongMethod(env, usage, jmx.get_used);
+        *committed = (*env)->CallLongMethod(env, usage, jmx.get_committed);
+        if ( max )
+            *max = (*env)->CallLongMethod(env, usage, jmx.get_max);
+        (*env)->DeleteLocalRef(env, usage);
+    }
+}
+
+/**
+ * Get a snapshot of the virtual machine's activity.
+ *
+ * @param[in] env      The JNI environment of the calling thread.
+ * @param[out] metrics The structure to fill.
+ *
+ * @return 0 if successful, or -1 if an error occured.
+ */
+int
+get_jvm_metrics(JNIEnv *env, struct jvm_metrics *metrics)
+{
+    jobject bean;
+    jsize n, count;
+
+    if ( ! jmx.initialised || (*env)->PushLocalFrame(env, 16) != JNI_OK )
+        return -1;
+
+    get_memory_usage(env, jmx.get_heap_usage, &metrics->heap_used,
+                     &metrics->heap_committed, &metrics->heap_max);
+    get_memory_usage(env, jmx.get_nonheap_usage, &metrics->nonheap_used,
+                     &metrics->nonheap_committed, NULL);
+
+    metrics->gc_count = metrics->gc_time = 0;
+    count = (*env)->GetArrayLength(env, jmx.gc_beans);
+    for ( n = 0; n < count; n++ ) {
+        if ( (bean = (*env)->GetObjectArrayElement(env, jmx.gc_beans, n)) ) {
+            metrics->gc_count += (*env)->CallLongMethod(env, bean, jmx.get_collection_count);
+            metrics->gc_time += (*env)->CallLongMethod(env, bean, jmx.get_collection_time);
+            (*env)->DeleteLocalRef(env, bean);
+        }
+    }
+
+    metrics->threads = (*env)->CallIntMethod(env, jmx.thread_bean, jmx.get_thread_count);
+    metrics->daemon_threads = (*env)->CallIntMethod(env, jmx.thread_bean,
+                                                    jmx.get_daemon_thread_count);
+    metrics->classes = (*env)->CallIntMethod(env, jmx.class_bean, jmx.get_loaded_class_count);
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Get the current value of a -XX option of the virtual machine.
+ *
+ * @param[in] env     The JNI environment of the calling thread.
+ * @param[in] name    The name of the option (e.g. "MaxHeapFreeRatio").
+ * @param[out] buffer A buffer to receive the value.
+ * @param[in] len     The size of @a buffer.
+ *
+ * @return 0 if successful, or -1 if the option does not exist or its
+ *         value could not be obtained.
+ */
+int
+get_vm_option(JNIEnv *env, const char *name, char *buffer, size_t len)
+{
+    jstring jname, jvalue;
+    jobject option;
+    const char *value;
+    int ret = -1;
+
+    if ( ! jmx.diagnostic_bean || (*env)->PushLocalFrame(env, 8) != JNI_OK )
+        return -1;
+
+    if ( (jname = (*env)->NewStringUTF(env, name))
+            && (option = (*env)->CallObjectMethod(env, jmx.diagnostic_bean,
+                                                  jmx.get_vm_option, jname))
+            && (jvalue = (*env)->CallObjectMethod(env, option, jmx.get_option_value))
+            && (value = (*env)->GetStringUTFChars(env, jvalue, NULL)) ) {
+        if ( strlen(value) < len ) {
+            strcpy(buffer, value);
+            ret = 0;
+        }
+        (*env)->ReleaseStringUTFChars(env, jvalue, value);
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/**
+ * Change the value of a manageable -XX option of the virtual machine.
+ *
+ * @param env   The JNI environment of the calling thread.
+ * @param name  The name of the option (e.g. "MaxHeapFreeRatio").
+ * @param value The new value.
+ *
+ * @return 0 if successful, or -1 if the option does not exist, is not
+ *         manageable, or if the value is invalid.
+ */
+int
+set_vm_option(JNIEnv *env, const char *name, const char *value)
+{
+    jstring jname, jvalue;
+    int ret = -1;
+
+    if ( ! jmx.diagnostic_bean || (*env)->PushLocalFrame(env, 8) != JNI_OK )
+        return -1;
+
+    if ( (jname = (*env)->NewStringUTF(env, name))
+            && (jvalue = (*env)->NewStringUTF(env, value)) ) {
+        (*env)->CallVoidMethod(env, jmx.diagnostic_bean, jmx.set_vm_option, jname, jvalue);
+        ret = 0;
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/**
+ * Request a garbage collection, as System.gc() does.
+ *
+ * @param env The JNI environment of the calling thread.
+ *
+ * @return 0 if successful, otherwise -1.
+ */
+int
+run_gc(JNIEnv *env)
+{
+    jclass system;
+    jmethodID gc;
+    int ret = -1;
+
+    if ( (system = (*env)->FindClass(env, "java/lang/System")) ) {
+        if ( (gc = (*env)->GetStaticMethodID(env, system, "gc", "()V")) ) {
+            (*env)->CallStaticVoidMethod(env, system, gc);
+            ret = 0;
+        }
+        (*env)->DeleteLocalRef(env, system);
+    }
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        ret = -1;
+    }
+
+    return ret;
+}
+
+/**
+ * Run a diagnostic command, as the jcmd tool does.
+ *
+ * @param[in] env      The JNI environment of the calling thread.
+ * @param[in] command  The name of the command, as an operation of the
+ *                     DiagnosticCommand MBean (e.g. "threadPrint" for
+ *                     the Thread.print command).
+ * @param[in] args     A NULL-terminated list of arguments to the
+ *                     command; may be NULL itself for no arguments.
+ * @param[out] output  If not NULL, a pointer that will receive a newly
+ *                     allocated buffer containing the output of the
+ *                     command.
+ *
+ * @return 0 if successful, or -1 if the command is not available or
+ *         has failed.
+ */
+int
+run_diagnostic_command(JNIEnv *env, const char *command, const char **args, char **output)
+{
+    jobjectArray jargs, params, signature;
+    jstring joperation, jarg;
+    jobject result;
+    const char *value;
+    jsize n, count;
+    int ret = -1;
+
+    if ( ! jmx.mbean_server || (*env)->PushLocalFrame(env, 16) != JNI_OK )
+        return -1;
+
+    for ( count = 0; args && args[count]; count++ ) ;
+
+    if ( (joperation = (*env)->NewStringUTF(env, command))
+            && (jargs = (*env)->NewObjectArray(env, count, jmx.string_class, NULL))
+            && (params = (*env)->NewObjectArray(env, 1,
+                    (*env)->FindClass(env, "java/lang/Object"), jargs))
+            && (signature = (*env)->NewObjectArray(env, 1, jmx.string_class,
+                    (*env)->NewStringUTF(env, "[Ljava.lang.String;"))) ) {
+        for ( n = 0; n < count; n++ ) {
+            if ( (jarg = (*env)->NewStringUTF(env, args[n])) )
+                (*env)->SetObjectArrayElement(env, jargs, n, jarg);
+        }
+
+        result = (*env)->CallObjectMethod(env, jmx.mbean_server, jmx.invoke,
+                                          jmx.diagnostic_command, joperation, params,
+                                          signature);
+        if ( ! (*env)->ExceptionCheck(env) ) {
+            ret = 0;
+            if ( output ) {
+                *output = NULL;
+                if ( result && (value = (*env)->GetStringUTFChars(env, result, NULL)) ) {
+                    *output = xstrdup(value);
+                    (*env)->ReleaseStringUTFChars(env, result, value);
+                }
+            }
+        }
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        ret = -1;
+    }
+
+    return ret;
+}
@@ -0,0 +1,81 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_JMX_H
+#define ICP20261018_JMX_H
+
+#include <stdlib.h>
+
+#include <jni.h>
+
+/*
+ * Metrics obtained from the platform management beans. Memory amounts
+ * are in bytes, times in milliseconds.
+ */
+struct jvm_metrics {
+    jlong   heap_used;
+    jlong   heap_committed;
+    jlong   heap_max;
+    jlong   nonheap_used;
+    jlong   nonheap_committed;
+    jlong   gc_count;           /* Sum over all collectors. */
+    jlong   gc_time;            /* Likewise. */
+    jint    threads;
+    jint    daemon_threads;
+    jint    classes;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int
+init_jmx(JNIEnv *env);
+
+int
+get_jvm_metrics(JNIEnv *env, struct jvm_metrics *metrics);
+
+int
+get_vm_option(JNIEnv *env, const char *name, char *buffer, size_t len);
+
+int
+set_vm_option(JNIEnv *env, const char *name, const char *value);
+
+int
+run_gc(JNIEnv *env);
+
+int
+run_diagnostic_command(JNIEnv *env, const char *command, const char **args, char **output);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_JMX_H */
@@ -0,0 +1,428 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "metrics.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <err.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include <xmem.h>
+
+#include "java.h"
+#include "jmx.h"
+#include "util.h"
+
+#define METRICS_FILE_PREFIX "protege-"
+#define METRICS_FILE_SUFFIX ".metrics"
+
+#define MEGABYTE            (1024 * 1024)
+
+/*
+ * State of the sampler.
+ */
+static struct {
+    struct metrics_buffer  *buffer;
+    char                   *path;
+    pid_t                   owner;      /* Process that created the file. */
+} sampler;
+
+/*
+ * Get the current time, in milliseconds since the Epoch.
+ */
+static uint64_t
+get_time(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Get the CPU time used by the process so far, in milliseconds.
+ */
+static uint64_t
+get_cpu_time(void)
+{
+    struct rusage usage;
+
+    if ( getrusage(RUSAGE_SELF, &usage) == -1 )
+        return 0;
+
+    return (uint64_t) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
+/*
+ * Remove the shared memory file when the launcher exits. Processes
+ * forked from the launcher must not remove it.
+ */
+static void
+remove_metrics_file(void)
+{
+    if ( sampler.path && getpid() == sampler.owner )
+        (void) unlink(sampler.path);
+}
+
+/*
+ * Main function of the sampler thread.
+ */
+static void *
+sampler_main(void *arg)
+{
+    JavaVM *jvm = arg;
+    JNIEnv *env;
+    JavaVMAttachArgs attach_args;
+    struct jvm_metrics metrics;
+    struct metrics_buffer *buffer = sampler.buffer;
+    struct metrics_record *record;
+    struct timespec delay;
+
+    attach_args.version = JNI_VERSION_1_2;
+    attach_args.name = "protege-metrics";
+    attach_args.group = NULL;
+
+    set_thread_name(attach_args.name);
+
+    /* As a daemon thread, we do not prevent the VM from exiting. */
+    if ( (*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **) &env, &attach_args) != JNI_OK )
+        return NULL;
+
+    delay.tv_sec = buffer->interval / 1000;
+    delay.tv_nsec = (buffer->interval % 1000) * 1000000;
+
+    for ( ;; ) {
+        if ( get_jvm_metrics(env, &metrics) == 0 ) {
+            record = &buffer->records[buffer->count % buffer->capacity];
+
+            record->timestamp = get_time();
+            record->cpu_time = get_cpu_time();
+            record->heap_used = metrics.heap_used;
+            record->heap_committed = metrics.heap_committed;
+            record->heap_max = metrics.heap_max;
+            record->nonheap_used = metrics.nonheap_used;
+            record->nonheap_committed = metrics.nonheap_committed;
+            record->gc_count = metrics.gc_count;
+            record->gc_time = metrics.gc_time;
+            record->threads = metrics.threads;
+            record->daemon_threads = metrics.daemon_threads;
+            record->classes = metrics.classes;
+
+            /* Publish the record only once it is complete. */
+            __atomic_store_n(&buffer->count, buffer->count + 1, __ATOMIC_RELEASE);
+        }
+
+        nanosleep(&delay, NULL);
+    }
+
+    return NULL;
+}
+
+/*
+ * Called once the virtual machine has been created.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    (void) data;
+
+    if ( init_jmx(env) == -1 ) {
+        warnx("Cannot start metrics sampler: management beans not available");
+        return;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, sampler_main, jvm) != 0 )
+        warn("Cannot start metrics sampler");
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Prepare the sampling of the virtual machine's activity into a shared
+ * memory file in the runtime directory. The sampler thread will start
+ * as soon as the virtual machine has been created.
+ *
+ * @param interval The sampling interval, in milliseconds.
+ *
+ * @return 0 if successful, or -1 if the shared memory file could not
+ *         be created.
+ */
+int
+start_metrics_sampler(unsigned interval)
+{
+    char *dir;
+    int fd;
+    void *map = MAP_FAILED;
+
+    dir = get_runtime_directory();
+    (void) xasprintf(&sampler.path, "%s/" METRICS_FILE_PREFIX "%ld" METRICS_FILE_SUFFIX,
+                     dir, (long) getpid());
+    free(dir);
+
+    /* The runtime directory may be shared with other users (when
+     * falling back to /tmp), so we never reuse an existing file: a
+     * file left over by a previous process with the same PID is
+     * removed, and anything else found at that path makes us fail. */
+    (void) unlink(sampler.path);
+    if ( (fd = open(sampler.path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600)) != -1 ) {
+        if ( ftruncate(fd, sizeof(struct metrics_buffer)) == 0 )
+            map = mmap(NULL, sizeof(struct metrics_buffer), PROT_READ | PROT_WRITE,
+                       MAP_SHARED, fd, 0);
+        close(fd);
+    }
+
+    if ( map == MAP_FAILED ) {
+        warn("Cannot create metrics file %s", sampler.path);
+        if ( fd != -1 )
+            (void) unlink(sampler.path);
+        free(sampler.path);
+        sampler.path = NULL;
+        return -1;
+    }
+
+    sampler.buffer = map;
+    sampler.buffer->capacity = METRICS_CAPACITY;
+    sampler.buffer->interval = interval;
+    sampler.buffer->pid = getpid();
+    sampler.buffer->start_time = get_time();
+    sampler.buffer->count = 0;
+    memcpy(sampler.buffer->magic, METRICS_MAGIC, sizeof(sampler.buffer->magic));
+
+    sampler.owner = getpid();
+    add_exit_handler(remove_metrics_file);
+    add_java_callback(on_java_created, NULL);
+
+    return 0;
+}
+
+/*
+ * Check whether a directory may be written to by other users.
+ */
+static int
+is_shared_directory(const char *dir)
+{
+    struct stat st;
+
+    if ( stat(dir, &st) == -1 )
+        return 1;
+
+    return (st.st_mode & (S_IWGRP | S_IWOTH)) != 0;
+}
+
+/*
+ * Map a metrics file in memory. If the file is in a shared directory,
+ * it must belong to the calling user, so that another user cannot
+ * feed us with bogus data.
+ *
+ * Returns the mapped buffer, or NULL if the file cannot be read or is
+ * not a valid metrics file.
+ */
+static const struct metrics_buffer *
+open_metrics_file(const char *path, int shared)
+{
+    struct metrics_buffer *buffer = NULL;
+    struct stat st;
+    void *map;
+    int fd;
+
+    if ( (fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC)) == -1 )
+        return NULL;
+
+    if ( fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+            && (! shared || st.st_uid == getuid())
+            && st.st_size == sizeof(struct metrics_buffer)
+            && (map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0)) != MAP_FAILED ) {
+        buffer = map;
+        if ( memcmp(buffer->magic, METRICS_MAGIC, sizeof(buffer->magic)) != 0
+                || buffer->capacity != METRICS_CAPACITY ) {
+            munmap(map, st.st_size);
+            buffer = NULL;
+        }
+    }
+    close(fd);
+
+    return buffer;
+}
+
+/*
+ * Format a duration given in milliseconds.
+ */
+static void
+format_duration(uint64_t duration, char *buffer, size_t len)
+{
+    duration /= 1000;
+
+    if ( duration >= 86400 )
+        (void) snprintf(buffer, len, "%ud%02uh", (unsigned) (duration / 86400),
+                        (unsigned) (duration % 86400) / 3600);
+    else if ( duration >= 3600 )
+        (void) snprintf(buffer, len, "%uh%02um", (unsigned) (duration / 3600),
+                        (unsigned) (duration % 3600) / 60);
+    else
+        (void) snprintf(buffer, len, "%um%02us", (unsigned) (duration / 60),
+                        (unsigned) (duration % 60));
+}
+
+/*
+ * Print a summary line for one instance, from its two most recent
+ * records.
+ */
+static void
+print_instance(const struct metrics_buffer *buffer)
+{
+    struct metrics_record last, prev;
+    uint64_t count, elapsed;
+    char uptime[16];
+    double gc_load = 0, cpu_load = 0;
+
+    count = __atomic_load_n(&buffer->count, __ATOMIC_ACQUIRE);
+    format_duration(get_time() - buffer->start_time, uptime, sizeof(uptime));
+
+    if ( count == 0 ) {
+        printf("%7ld %8s  (starting)\n", (long) buffer->pid, uptime);
+        return;
+    }
+
+    last = buffer->records[(count - 1) % buffer->capacity];
+    prev = count > 1 ? buffer->records[(count - 2) % buffer->capacity] : last;
+
+    if ( (elapsed = last.timestamp - prev.timestamp) > 0 ) {
+        gc_load = 100.0 * (last.gc_time - prev.gc_time) / elapsed;
+        cpu_load = 100.0 * (last.cpu_time - prev.cpu_time) / elapsed;
+    }
+
+    printf("%7ld %8s %7lld %7lld %7lld %7lld %8lld %5.1f %6.1f %7d %7d\n",
+           (long) buffer->pid, uptime,
+           (long long) last.heap_used / MEGABYTE,
+           (long long) last.heap_committed / MEGABYTE,
+           (long long) last.heap_max / MEGABYTE,
+           (long long) last.nonheap_used / MEGABYTE,
+           (long long) last.gc_count, gc_load, cpu_load,
+           last.threads, last.classes);
+}
+
+/**
+ * Show the activity of running Protégé instances, from their metrics
+ * files. If the standard output is a terminal, the display is
+ * refreshed every second until interrupted; otherwise the activity is
+ * printed once.
+ *
+ * @param pid If not NULL, the process ID of the only instance to show.
+ *
+ * @return The exit code for the launcher.
+ */
+int
+run_metrics_viewer(const char *pid)
+{
+    char *dir, *path;
+    DIR *d;
+    struct dirent *entry;
+    const struct metrics_buffer *buffer;
+    struct stat st;
+    long instance_pid, wanted_pid = pid ? atol(pid) : 0;
+    int interactive, shared, len, found;
+
+    dir = get_runtime_directory();
+    shared = is_shared_directory(dir);
+    interactive = isatty(STDOUT_FILENO);
+
+    do {
+        if ( interactive )
+            printf("\033[H\033[2J");
+        printf("%7s %8s %7s %7s %7s %7s %8s %5s %6s %7s %7s\n", "PID", "UPTIME",
+               "HEAP", "COMMIT", "MAX", "NONHEAP", "GCS", "GC%", "CPU%",
+               "THREADS", "CLASSES");
+
+        found = 0;
+        if ( (d = opendir(dir)) ) {
+            while ( (entry = readdir(d)) ) {
+                len = 0;
+                if ( sscanf(entry->d_name, METRICS_FILE_PREFIX "%ld" METRICS_FILE_SUFFIX "%n",
+                            &instance_pid, &len) != 1 || len == 0 || entry->d_name[len] != '\0' )
+                    continue;
+
+                if ( wanted_pid && instance_pid != wanted_pid )
+                    continue;
+
+                path = NULL;
+                (void) xasprintf(&path, "%s/%s", dir, entry->d_name);
+
+                if ( kill(instance_pid, 0) == -1 && errno == ESRCH ) {
+                    /* Left over by an instance that crashed. */
+                    if ( ! shared || (lstat(path, &st) == 0 && st.st_uid == getuid()) )
+                        (void) unlink(path);
+                }
+                else if ( (buffer = open_metrics_file(path, shared)) ) {
+                    print_instance(buffer);
+                    munmap((void *) buffer, sizeof(struct metrics_buffer));
+                    found += 1;
+                }
+
+                free(path);
+            }
+            closedir(d);
+        }
+
+        if ( ! found )
+            printf("No running instance with metrics enabled.\n");
+
+        fflush(stdout);
+        if ( interactive )
+            sleep(1);
+    } while ( interactive );
+
+    free(dir);
+
+    return EXIT_SUCCESS;
+}
+
+#endif /* !PROTEGE_WIN32 */
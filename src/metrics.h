@@ -0,0 +1,89 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_METRICS_H
+#define ICP20261018_METRICS_H
+
+#include <stdint.h>
+
+#define METRICS_MAGIC       "PROTMTR1"
+#define METRICS_CAPACITY    600
+
+/*
+ * One sample of the virtual machine's activity. Memory amounts are in
+ * bytes, times in milliseconds.
+ */
+struct metrics_record {
+    uint64_t    timestamp;          /* Since the Epoch. */
+    uint64_t    cpu_time;           /* Process CPU time (user+system). */
+    int64_t     heap_used;
+    int64_t     heap_committed;
+    int64_t     heap_max;
+    int64_t     nonheap_used;
+    int64_t     nonheap_committed;
+    int64_t     gc_count;
+    int64_t     gc_time;
+    int32_t     threads;
+    int32_t     daemon_threads;
+    int32_t     classes;
+    int32_t     reserved;
+};
+
+/*
+ * Layout of the shared memory file. The sampler writes the record at
+ * index (count % capacity), then increments count; readers should
+ * only read the records before count.
+ */
+struct metrics_buffer {
+    char        magic[8];
+    uint32_t    capacity;
+    uint32_t    interval;           /* Sampling interval, in ms. */
+    int64_t     pid;
+    uint64_t    start_time;         /* Since the Epoch, in ms. */
+    uint64_t    count;              /* Number of records written. */
+    struct metrics_record
+                records[METRICS_CAPACITY];
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int
+start_metrics_sampler(unsigned interval);
+
+int
+run_metrics_viewer(const char *pid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_METRICS_H */
@@ -43,6 +43,10 @@
 #include <xmem.h>
 
 #include "util.h"
+#include "display.h"
+#include "supervisor.h"
+#include "plugins.h"
+#include "fonts.h"
 
 #if defined(PROTEGE_WIN32)
 #define JAVA_CLASSPATH_SEPARATOR ";"
@@ -79,6 +83,15 @@ static const char *default_options[] = {
 
 static size_t n_default_options = sizeof(default_options) / sizeof(char**) - 1;
 
+/*
+ * Default splash screen image, relative to the application directory.
+ */
+#if defined(PROTEGE_MACOS)
+#define DEFAULT_SPLASH_IMAGE "Resources/splash.png"
+#else
+#define DEFAULT_SPLASH_IMAGE "splash.png"
+#endif
+
 /*
  * Fill the list structure with the default options.
  * The string themselves are *not* duplicated, the list will only
@@ -110,7 +123,7 @@ append_option(struct option_list *list, char *option)
     /* Grow the list as needed. */
     if ( list->count >= list->allocated - 1 ) {
         list->allocated += 10;
-        list->options = xrealloc(list->options, list->allocated);
+        list->options = xrealloc(list->options, list->allocated * sizeof(char *));
     }
 
     /* Append the option. */
@@ -118,6 +131,140 @@ append_option(struct option_list *list, char *option)
     list->options[list->count] = NULL;
 }
 
+/*
+ * Find an option starting with the specified prefix among the
+ * non-default options.
+ *
+ * Returns the last matching option, or NULL if no option matches.
+ */
+static const char *
+find_option(struct option_list *list, const char *prefix)
+{
+    const char *found = NULL;
+    size_t n, len = strlen(prefix);
+
+    for ( n = n_default_options; n < list->count; n++ )
+        if ( strncmp(list->options[n], prefix, len) == 0 )
+            found = list->options[n];
+
+    return found;
+}
+
+/*
+ * Append an option constructed from a format string, unless an option
+ * starting with the specified prefix has already been set.
+ */
+static void
+set_default_option(struct option_list *list, const char *prefix, const char *fmt, ...)
+{
+    char *option = NULL;
+    va_list ap;
+
+    if ( find_option(list, prefix) )
+        return;
+
+    va_start(ap, fmt);
+    (void) xvasprintf(&option, fmt, ap);
+    va_end(ap);
+
+    append_option(list, option);
+}
+
+/*
+ * Parse an integer configuration value.
+ *
+ * Returns 0 if the value is a valid integer within the [min,max]
+ * range, otherwise -1.
+ */
+static int
+get_integer_value(const char *value, int min, int max, int *result)
+{
+    int n;
+
+    if ( sscanf(value, "%d", &n) != 1 || n < min || n > max )
+        return -1;
+
+    *result = n;
+    return 0;
+}
+
+/*
+ * Parse a Java2D pipeline configuration value.
+ *
+ * Returns 0 if the value is a known pipeline name, otherwise -1.
+ */
+static int
+get_java2d_pipeline_value(const char *value, unsigned *result)
+{
+    static const struct {
+        const char *name;
+        unsigned    pipeline;
+    } pipelines[] = {
+        { "default",    PROTEGE_JAVA2D_DEFAULT },
+        { "auto",       PROTEGE_JAVA2D_AUTO },
+        { "xrender",    PROTEGE_JAVA2D_XRENDER },
+        { "opengl",     PROTEGE_JAVA2D_OPENGL },
+        { "software",   PROTEGE_JAVA2D_SOFTWARE },
+        { NULL,         0 }
+    };
+    int i;
+
+    for ( i = 0; pipelines[i].name; i++ ) {
+        if ( strcmp(value, pipelines[i].name) == 0 ) {
+            *result = pipelines[i].pipeline;
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * Parse a resource limit configuration value, which may be either
+ * "unlimited" or an amount (with an optional unit if is_memory is
+ * non-zero).
+ *
+ * Returns 0 if the value is valid, otherwise -1.
+ */
+static int
+get_limit_value(const char *value, int is_memory, long long *result)
+{
+    size_t amount;
+
+    if ( strcmp(value, "unlimited") == 0 ) {
+        *result = -1;
+        return 0;
+    }
+
+    if ( is_memory ) {
+        if ( (amount = get_memory_amount(value)) == 0 && value[0] != '0' )
+            return -1;
+    }
+    else if ( sscanf(value, "%zu", &amount) != 1 )
+        return -1;
+
+    *result = amount;
+    return 0;
+}
+
+/*
+ * Parse a memory amount configuration value, which may be either an
+ * amount with a unit, or a percentage of the physical memory.
+ *
+ * Returns the amount in bytes, or 0 if the value is invalid.
+ */
+static size_t
+get_memory_value(const char *value)
+{
+    size_t amount;
+    char unit;
+
+    if ( sscanf(value, "%zu%c", &amount, &unit) == 2 && unit == '%' )
+        return get_physical_memory() * (amount / 100.0);
+
+    return get_memory_amount(value);
+}
+
 /*
  * Check if a file exists at a constructed pathname.
  *
@@ -143,14 +290,17 @@ try_pathname(const char *fmt, ...)
     return path;
 }
 
-/*
+/**
  * Try to find a jvm.conf configuration file. We look into the user's
  * home directory, then into the Protégé directory.
  *
- * Returns a newly allocated buffer containing the path to the
- * configuration file that was found, or NULL if we didn't find any.
+ * @param app_dir The directory where Protégé is installed.
+ *
+ * @return A newly allocated buffer containing the path to the
+ *         configuration file that was found, or NULL if we didn't
+ *         find any.
  */
-static char *
+char *
 find_configuration_file(const char *app_dir)
 {
     char *home, *conf_file = NULL;
@@ -249,47 +399,368 @@ get_options_from_l4j_file(const char *app_dir, struct option_list *list)
 #endif
 
 
+#define MB (1024 * 1024)
+
+/*
+ * Share of the memory available to the process that is given to Java
+ * (heap and native memory), depending on that amount of memory (in
+ * megabytes). The thresholds are a bit below round numbers of
+ * gigabytes, as the memory reported by the system excludes what the
+ * firmware and the kernel reserve for themselves.
+ */
+static const struct {
+    unsigned long long  min_memory;
+    double              share;
+} heap_bands[] = {
+    { 15 * 1024,        .75 },
+    { 7 * 1024 + 512,   .66 },
+    { 3 * 1024 + 768,   .5 },
+    { 0,                0 }
+};
+
+/* Largest heap (in megabytes) with which Java can still use compressed
+ * object pointers, which are limited to 32 GB of address space. */
+#define COMPRESSED_OOPS_MAX_HEAP    (31 * 1024ULL)
+
+/* Smallest heap (in megabytes) worth using without compressed object
+ * pointers, since uncompressed pointers make the objects about 1.5
+ * times larger. */
+#define UNCOMPRESSED_OOPS_MIN_HEAP  (48 * 1024ULL)
+
+/*
+ * Get the value of a memory option in megabytes, or the specified
+ * default value if the option is not set.
+ */
+static unsigned long long
+get_option_mb(struct option_list *list, const char *prefix, unsigned long long def)
+{
+    const char *option;
+    size_t amount;
+
+    if ( (option = find_option(list, prefix))
+            && (amount = get_memory_amount(option + strlen(prefix))) > 0 )
+        return amount / MB;
+
+    return def;
+}
+
+/*
+ * Estimate the native memory (in megabytes) Java needs besides a heap
+ * of the specified size: the metaspace, half of the code cache, the
+ * stacks of about 128 threads (of which only the pages actually used
+ * count), direct buffers, the data structures of the garbage collector
+ * (about 1/32 of the heap for G1), and the virtual machine and native
+ * libraries themselves.
+ */
+static unsigned long long
+get_native_memory(struct option_list *list, unsigned long long heap)
+{
+    return get_option_mb(list, "-XX:MetaspaceSize=", 128) * 2
+        + get_option_mb(list, "-XX:ReservedCodeCacheSize=", 240) / 2
+        + get_option_mb(list, "-Xss", 1) * 128 / 4
+        + 64
+        + heap / 32
+        + 192;
+}
+
+/*
+ * Check whether the garbage collector in use is G1 (the default since
+ * Java 9), in which case the heap is divided into regions.
+ */
+static int
+uses_g1(struct option_list *list)
+{
+    return ! find_option(list, "-XX:+UseParallelGC")
+        && ! find_option(list, "-XX:+UseSerialGC")
+        && ! find_option(list, "-XX:+UseConcMarkSweepGC")
+        && ! find_option(list, "-XX:+UseShenandoahGC")
+        && ! find_option(list, "-XX:+UseZGC")
+        && ! find_option(list, "-XX:+UseEpsilonGC");
+}
+
 /*
  * Try to set a default value for the max heap setting. If no value
  * has already been explicitly specified in the option list, this
  * function attempts to determine a suitable default based on the
- * amount of physical memory available on the system.
+ * amount of memory available to the process (the physical memory, or
+ * the memory limit of its control group on GNU/Linux), keeping enough
+ * room for the native memory Java needs, and avoiding the heap sizes
+ * just above 32 GB with which Java would lose the benefit of
+ * compressed object pointers. The initial heap size and the size of
+ * the G1 regions are set to match.
  */
 static void
 set_default_max_heap(struct option_list *list)
 {
-    int is_set = 0;
-    size_t phys_mem;
+    unsigned long long memory, budget, native, heap, initial, region;
+    size_t n;
 
-    if ( list->allocated ) {
-        size_t n;
+    if ( ! find_option(list, "-Xmx")
+            && ! find_option(list, "-XX:MaxRAMPercentage=")
+            && ! find_option(list, "-XX:MaxRAMFraction=")
+            && (memory = get_physical_memory() / MB) != 0 ) {
+#if defined(PROTEGE_LINUX)
+        if ( get_cgroup_memory_limit() / MB > 0 && get_cgroup_memory_limit() / MB < memory )
+            memory = get_cgroup_memory_limit() / MB;
+#endif
 
-        for ( n = n_default_options; list->options[n] && is_set == 0; n++ )
-            if ( strncmp(list->options[n], "-Xmx", 4) == 0 )
-                is_set = 1;
+        for ( n = 0; memory < heap_bands[n].min_memory; n++ ) ;
+        if ( heap_bands[n].share == 0 )
+            return;     /* Let Java use its own default. */
+
+        /* The native memory grows with the heap (heap / 32), so solve
+         * heap + native(heap) = budget. */
+        budget = memory * heap_bands[n].share;
+        native = get_native_memory(list, 0);
+        if ( budget <= native )
+            return;
+        heap = (budget - native) * 32 / 33;
+
+        /* Never go below an initial heap size set by the user. */
+        if ( heap < get_option_mb(list, "-Xms", 0) )
+            heap = get_option_mb(list, "-Xms", 0);
+
+        if ( heap > COMPRESSED_OOPS_MAX_HEAP && heap < UNCOMPRESSED_OOPS_MIN_HEAP
+                && ! find_option(list, "-XX:-UseCompressedOops") )
+            heap = COMPRESSED_OOPS_MAX_HEAP;
+
+        /* Aim for about 2048 regions, as G1 does when it chooses the
+         * region size itself, but from the maximal heap size only;
+         * otherwise a small initial heap would result in a large
+         * heap made of too many small regions. */
+        for ( region = 1; region < 32 && region * 2 * 2048 <= heap; region *= 2 ) ;
+        heap -= heap % region;
+
+        set_default_option(list, "-Xmx", "-Xmx%lluM", heap);
+
+        if ( uses_g1(list) )
+            set_default_option(list, "-XX:G1HeapRegionSize=", "-XX:G1HeapRegionSize=%lluM", region);
+
+        /* Start with an eighth of the heap, so that Protégé does not
+         * have to grow it repeatedly while starting, unless the heap
+         * is to shrink back when Protégé is idle. */
+        if ( ! (list->flags & PROTEGE_FLAG_IDLE_MEMORY_RETURN) ) {
+            initial = heap / 8 < 256 ? 256 : heap / 8 > 2048 ? 2048 : heap / 8;
+            initial -= initial % region;
+            set_default_option(list, "-Xms", "-Xms%lluM", initial);
+        }
     }
+}
+
+#if defined(PROTEGE_LINUX)
 
-    if ( ! is_set && (phys_mem = get_physical_memory()) != 0 ) {
-        phys_mem /= 1024 * 1024 * 1024;
+/*
+ * Compute the base-2 logarithm of a positive integer, rounded down.
+ */
+static int
+log2_int(int n)
+{
+    int log = 0;
 
-        if ( phys_mem >= 16 )
-            phys_mem *= .75;
-        else if ( phys_mem >= 8 )
-            phys_mem *= .66;
-        else if ( phys_mem >= 4 )
-            phys_mem *= .5;
-        else
-            phys_mem = 0;
+    while ( n >>= 1 )
+        log += 1;
 
-        if ( phys_mem ) {
-            char *option;
+    return log;
+}
 
-            (void) xasprintf(&option, "-Xmx%luG", phys_mem);
-            append_option(list, option);
+/*
+ * Explicitly size the thread pools of the Java virtual machine if the
+ * launcher is to be restricted to a subset of the available CPUs, or
+ * if the CPUs are of different kinds. In the latter case, the garbage
+ * collector and compiler threads are sized after the number of
+ * performance cores only, since the JVM would otherwise count the
+ * (slower) efficiency cores as well, and have its threads wait for the
+ * stragglers running on them. We use the same formulas as the JVM's
+ * own ergonomics.
+ */
+static void
+set_processor_options(struct option_list *list)
+{
+    int ncpus, nthreads, gc_threads, conc_threads, log_cpus, compilers;
+    struct cpu_topology topology;
+
+    nthreads = ncpus = get_resource_cpu_count(&list->resources);
+
+    if ( get_cpu_topology(list->resources.cpu_set, &topology) == 0
+            && topology.heterogeneous ) {
+        nthreads = CPU_COUNT(&topology.performance);
+
+        if ( list->flags & PROTEGE_FLAG_PIN_PERFORMANCE ) {
+            if ( list->resources.cpu_set )
+                free(list->resources.cpu_set);
+            list->resources.cpu_set = format_cpu_list(&topology.performance);
+            ncpus = nthreads;
         }
     }
+
+    if ( nthreads == 0 )
+        return;
+
+    gc_threads = nthreads <= 8 ? nthreads : 8 + (nthreads - 8) * 5 / 8;
+    conc_threads = (gc_threads + 2) / 4 > 1 ? (gc_threads + 2) / 4 : 1;
+
+    log_cpus = log2_int(nthreads);
+    compilers = log_cpus * log2_int(log_cpus > 1 ? log_cpus : 1) * 3 / 2;
+    if ( compilers < 2 )
+        compilers = 2;
+
+    if ( ncpus )
+        set_default_option(list, "-XX:ActiveProcessorCount=",
+                           "-XX:ActiveProcessorCount=%d", ncpus);
+    set_default_option(list, "-XX:ParallelGCThreads=",
+                       "-XX:ParallelGCThreads=%d", gc_threads);
+    set_default_option(list, "-XX:ConcGCThreads=",
+                       "-XX:ConcGCThreads=%d", conc_threads);
+    set_default_option(list, "-XX:CICompilerCount=",
+                       "-XX:CICompilerCount=%d", compilers);
+}
+
+/*
+ * Make Java code visible to perf: keep frame pointers in compiled code
+ * so that perf can walk the stacks, and write a perf map of the
+ * compiled methods (the launcher will keep it up to date).
+ */
+static void
+set_profile_options(struct option_list *list)
+{
+    set_default_option(list, "-XX:-PreserveFramePointer", "-XX:+PreserveFramePointer");
+    set_default_option(list, "-XX:-DumpPerfMapAtExit", "-XX:+DumpPerfMapAtExit");
+}
+
+#endif
+
+/*
+ * Configure the garbage collector so that the heap shrinks back when
+ * Protégé no longer needs the memory: a periodic collection when the
+ * application is inactive (Java 12 and later), and lower free ratios
+ * than the defaults (40% and 70%) so that the heap is actually shrunk
+ * after a collection.
+ */
+static void
+set_idle_memory_options(struct option_list *list)
+{
+    set_default_option(list, "-XX:G1PeriodicGCInterval=",
+                       "-XX:G1PeriodicGCInterval=%u", 5 * 60 * 1000);
+
+    /* Only set both ratios, or none of them, as the JVM refuses to
+     * start if the minimum is higher than the maximum. */
+    if ( ! find_option(list, "-XX:MinHeapFreeRatio=")
+            && ! find_option(list, "-XX:MaxHeapFreeRatio=") ) {
+        set_default_option(list, "-XX:MinHeapFreeRatio=", "-XX:MinHeapFreeRatio=10");
+        set_default_option(list, "-XX:MaxHeapFreeRatio=", "-XX:MaxHeapFreeRatio=30");
+    }
+}
+
+#if !defined(PROTEGE_WIN32)
+
+/*
+ * Round an amount of memory up to the megabyte, and keep it within
+ * the specified bounds (in megabytes).
+ */
+static unsigned long long
+clamp_mb(unsigned long long amount, unsigned long long min, unsigned long long max)
+{
+    amount = (amount + MB - 1) / MB;
+
+    return amount < min ? min : amount > max ? max : amount;
+}
+
+/*
+ * Size the memory areas where the virtual machine stores classes and
+ * compiled code after what the installed bundles and plugins contain.
+ * Class metadata take about twice the size of the class files, plus a
+ * few hundred bytes per class in the compressed class space. About
+ * half of the classes are loaded at startup, so the first Metaspace
+ * collection is set to happen above that.
+ *
+ * The estimate ignores the classes of the Java runtime and those
+ * generated at runtime, so upper limits are only set if the user asked
+ * for them: we then assume that every class may eventually get loaded,
+ * and allow for three times as much before Metaspace is exhausted. The
+ * code cache is sized after the total size of the bytecode, with the
+ * default size of the JVM (240M) for about 120M of bytecode, but never
+ * below that default.
+ */
+static void
+set_class_space_options(struct option_list *list, const char *app_dir)
+{
+    struct plugin_stats stats;
+    unsigned long long metaspace, class_space;
+
+    if ( get_plugin_stats(app_dir, &stats) == -1 )
+        return;
+
+    metaspace = stats.bytecode * 2 + stats.classes * 512;
+    class_space = stats.classes * 1024;
+
+    set_default_option(list, "-XX:MetaspaceSize=", "-XX:MetaspaceSize=%lluM",
+                       clamp_mb(metaspace / 2, 32, 1024));
+
+    if ( ! (list->flags & PROTEGE_FLAG_PLUGIN_LIMITS) )
+        return;
+
+    if ( ! find_option(list, "-XX:MaxPermSize=") )
+        set_default_option(list, "-XX:MaxMetaspaceSize=", "-XX:MaxMetaspaceSize=%lluM",
+                           clamp_mb(metaspace * 3, 256, 8192));
+    set_default_option(list, "-XX:CompressedClassSpaceSize=",
+                       "-XX:CompressedClassSpaceSize=%lluM",
+                       clamp_mb(class_space * 4, 64, 3072));
+    set_default_option(list, "-XX:ReservedCodeCacheSize=", "-XX:ReservedCodeCacheSize=%lluM",
+                       clamp_mb(stats.bytecode * 2, 240, 2047));
+}
+
+/*
+ * Tell the OSGi framework where to find a pre-built index of the
+ * installed bundles.
+ */
+static void
+set_bundle_index_option(struct option_list *list, const char *app_dir)
+{
+    char *index;
+
+    if ( (index = get_bundle_index(app_dir)) ) {
+        set_default_option(list, "-Dprotege.bundle.index=",
+                           "-Dprotege.bundle.index=%s", index);
+        free(index);
+    }
+}
+
+/*
+ * Configure the Java virtual machine to write heap dumps into the
+ * managed heap dump directory, if either managed heap dumps have been
+ * enabled or the user has enabled heap dumps without specifying where
+ * to write them (in which case they would end up in the application
+ * directory).
+ */
+static void
+set_heap_dump_options(struct option_list *list)
+{
+    char *home;
+    int managed = 1;
+
+    if ( ! (list->flags & PROTEGE_FLAG_HEAP_DUMPS)
+            && ! find_option(list, "-XX:+HeapDumpOnOutOfMemoryError") )
+        managed = 0;
+    else if ( find_option(list, "-XX:HeapDumpPath=") )
+        managed = 0;    /* The user is managing heap dumps. */
+    else if ( ! list->heap_dump_dir && (home = getenv("HOME")) )
+        (void) xasprintf(&list->heap_dump_dir, "%s/.Protege/dumps", home);
+
+    if ( ! managed || ! list->heap_dump_dir ) {
+        if ( list->heap_dump_dir )
+            free(list->heap_dump_dir);
+        list->heap_dump_dir = NULL;
+        return;
+    }
+
+    set_default_option(list, "-XX:+HeapDumpOnOutOfMemoryError",
+                       "-XX:+HeapDumpOnOutOfMemoryError");
+    set_default_option(list, "-XX:HeapDumpPath=",
+                       "-XX:HeapDumpPath=%s", list->heap_dump_dir);
 }
 
+#endif
+
 /*
  * Construct a option string to set a memory parameter. This function
  * both checks that the desired value is correct, and handles the '%'
@@ -341,21 +812,15 @@ make_memory_option(const char *option, const char *value)
 static void
 set_ui_scaling(struct option_list *list)
 {
-    int is_set = 0;
     int hres, vres, res, factor;
     char * opt = NULL;
 
-    if ( list->allocated ) {
-        size_t n;
-
-        /* If the user has already explicit set the UI scaling option,
-         * do not override it. */
-        for ( n = n_default_options; list->options[n] && is_set == 0; n++ )
-            if ( strncmp(list->options[n], "-Dsun.java2d.uiScale", 20) == 0 )
-                is_set = 1;
-    }
+    /* If the user has already explicit set the UI scaling option,
+     * do not override it. */
+    if ( find_option(list, "-Dsun.java2d.uiScale") )
+        return;
 
-    if ( !is_set && get_screen_dpi(&hres, &vres) != -1 ) {
+    if ( get_screen_dpi(&hres, &vres) != -1 ) {
         /* Not sure what to do if horizontal and vertical resolution are
          * different (does that even happen?). For now, we just take
          * whichever value is the highest. */
@@ -373,6 +838,108 @@ set_ui_scaling(struct option_list *list)
     }
 }
 
+/*
+ * Choose a rendering pipeline for Java2D according to the display.
+ *
+ * - On a remote display, drawing is best done by the X server, so
+ *   XRender is used and offscreen images are kept in server-side
+ *   pixmaps, which saves sending them over the network again each
+ *   time they are painted. OpenGL (indirect GLX) is never used.
+ * - On a server without graphics hardware (Xvfb, VNC), XRender is
+ *   merely a software renderer in another process; Java's own software
+ *   loops, drawing in its memory and sending the result through shared
+ *   memory, are faster.
+ * - On Xwayland, XRender is accelerated (by glamor) while GLX goes
+ *   through another translation layer, so XRender is used.
+ * - On a local display with XRender, Java's defaults are fine; without
+ *   it, the software loops are used.
+ */
+static unsigned
+choose_java2d_pipeline(int *server_pixmaps)
+{
+    unsigned features;
+
+    *server_pixmaps = 0;
+    if ( get_display_features(&features) == -1 )
+        return PROTEGE_JAVA2D_DEFAULT;
+
+    if ( features & DISPLAY_REMOTE ) {
+        *server_pixmaps = 1;
+        return PROTEGE_JAVA2D_XRENDER;
+    }
+
+    if ( features & DISPLAY_VIRTUAL || ! (features & DISPLAY_XRENDER) )
+        return PROTEGE_JAVA2D_SOFTWARE;
+
+    if ( features & DISPLAY_WAYLAND )
+        return PROTEGE_JAVA2D_XRENDER;
+
+    return PROTEGE_JAVA2D_DEFAULT;
+}
+
+/*
+ * Set the Java2D properties selecting the rendering pipeline, unless
+ * the user has set any of them already.
+ */
+static void
+set_java2d_options(struct option_list *list)
+{
+    unsigned pipeline = list->java2d_pipeline;
+    int server_pixmaps = 0;
+
+    if ( find_option(list, "-Dsun.java2d.xrender=")
+            || find_option(list, "-Dsun.java2d.opengl=")
+            || find_option(list, "-Dsun.java2d.pmoffscreen=") )
+        return;
+
+    /* No display at all, nothing to choose. */
+    if ( find_option(list, "-Djava.awt.headless=true") )
+        return;
+
+    if ( pipeline == PROTEGE_JAVA2D_AUTO )
+        pipeline = choose_java2d_pipeline(&server_pixmaps);
+
+    switch ( pipeline ) {
+    case PROTEGE_JAVA2D_XRENDER:
+        append_option(list, xstrdup("-Dsun.java2d.xrender=true"));
+        append_option(list, xstrdup("-Dsun.java2d.opengl=false"));
+        break;
+
+    case PROTEGE_JAVA2D_OPENGL:
+        append_option(list, xstrdup("-Dsun.java2d.opengl=true"));
+        break;
+
+    case PROTEGE_JAVA2D_SOFTWARE:
+        append_option(list, xstrdup("-Dsun.java2d.xrender=false"));
+        append_option(list, xstrdup("-Dsun.java2d.opengl=false"));
+        append_option(list, xstrdup("-Dsun.java2d.pmoffscreen=false"));
+        break;
+    }
+
+    if ( server_pixmaps )
+        append_option(list, xstrdup("-Dsun.java2d.pmoffscreen=true"));
+}
+
+/*
+ * Make Java use the font configuration built for the current font
+ * setup, if there is one, instead of querying fontconfig for the
+ * fonts behind its logical fonts.
+ */
+static void
+set_font_options(struct option_list *list)
+{
+    char *path, *opt = NULL;
+
+    if ( find_option(list, "-Dsun.awt.fontconfig=") )
+        return;
+
+    if ( (path = get_font_configuration()) ) {
+        (void) xasprintf(&opt, "-Dsun.awt.fontconfig=%s", path);
+        append_option(list, opt);
+        free(path);
+    }
+}
+
 #endif
 
 
@@ -394,7 +961,7 @@ set_ui_scaling(struct option_list *list)
 void
 get_option_list(const char *app_dir, struct option_list *list)
 {
-    char *conf_file;
+    char *conf_file, *splash;
 
     /*
      * At first we make the list point to the static list of default
@@ -404,12 +971,39 @@ get_option_list(const char *app_dir, struct option_list *list)
     list->allocated = 0;
     list->count = n_default_options;
     list->options = (char **) default_options;
+    list->java_home = NULL;
+    list->splash = NULL;
+    list->flags = 0;
+    list->supervisor_max_heap = 0;
+    list->supervisor_restart_code = SUPERVISOR_RESTART_CODE;
+    list->heap_dump_dir = NULL;
+    list->heap_dump_count = 3;
+    list->heap_dump_quota = 0;
+    list->metrics_interval = 0;
+    list->idle_memory_delay = 10;
+    list->perf_record_duration = 0;
+    list->startup_timeout = 0;
+    list->hang_threshold = 0;
+    list->startup_trace = 0;
+    list->scratch_dir = NULL;
+    list->java2d_pipeline = PROTEGE_JAVA2D_DEFAULT;
+
+    init_resource_settings(&list->resources);
 
 #if defined(PROTEGE_LINUX) && defined(UI_AUTO_SCALING)
     /* Enable UI scaling by default unless explicitly disabled. */
     list->flags = PROTEGE_FLAG_UI_AUTO_SCALING;
 #endif
 
+#if defined(PROTEGE_LINUX)
+    list->java2d_pipeline = PROTEGE_JAVA2D_AUTO;
+#endif
+
+#if !defined(PROTEGE_WIN32)
+    list->flags |= PROTEGE_FLAG_SCRATCH_DIR | PROTEGE_FLAG_PRELOAD
+        | PROTEGE_FLAG_PLUGIN_SIZING;
+#endif
+
     /*
      * We look for the jvm.conf file that is now the modern,
      * cross-platform method for specifying extra options.
@@ -441,11 +1035,175 @@ get_option_list(const char *app_dir, struct option_list *list)
                         opt_string = xstrdup(opt_value);
                     else if ( strcmp(line, "java_home") == 0 )
                         list->java_home = xstrdup(opt_value);
+                    else if ( strcmp(line, "cpu_set") == 0 ) {
+                        if ( list->resources.cpu_set )
+                            free(list->resources.cpu_set);
+                        list->resources.cpu_set = xstrdup(opt_value);
+                    }
+                    else if ( strcmp(line, "cpu_pinning") == 0 ) {
+                        if ( strcmp(opt_value, "performance") == 0 )
+                            list->flags |= PROTEGE_FLAG_PIN_PERFORMANCE;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_PIN_PERFORMANCE;
+                    }
+                    else if ( strcmp(line, "nice") == 0 )
+                        (void) get_integer_value(opt_value, -20, 19,
+                                                 &list->resources.nice);
+                    else if ( strcmp(line, "io_priority") == 0 )
+                        (void) set_io_priority_setting(&list->resources, opt_value);
+                    else if ( strcmp(line, "oom_score_adj") == 0 )
+                        (void) get_integer_value(opt_value, -1000, 1000,
+                                                 &list->resources.oom_score_adj);
+                    else if ( strcmp(line, "max_open_files") == 0 )
+                        (void) get_limit_value(opt_value, 0,
+                                               &list->resources.max_open_files);
+                    else if ( strcmp(line, "max_locked_memory") == 0 )
+                        (void) get_limit_value(opt_value, 1,
+                                               &list->resources.max_locked_memory);
+                    else if ( strcmp(line, "heap_dumps") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_HEAP_DUMPS;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_HEAP_DUMPS;
+                    }
+                    else if ( strcmp(line, "heap_dump_dir") == 0 ) {
+                        if ( list->heap_dump_dir )
+                            free(list->heap_dump_dir);
+                        list->heap_dump_dir = xstrdup(opt_value);
+                    }
+                    else if ( strcmp(line, "heap_dump_count") == 0 ) {
+                        int count;
+
+                        if ( get_integer_value(opt_value, 1, 1000, &count) == 0 )
+                            list->heap_dump_count = count;
+                    }
+                    else if ( strcmp(line, "heap_dump_quota") == 0 )
+                        list->heap_dump_quota = get_memory_value(opt_value);
+                    else if ( strcmp(line, "splash_screen") == 0 ) {
+                        if ( list->splash )
+                            free(list->splash);
+                        list->splash = xstrdup(opt_value);
+                    }
                     else if ( strcmp(line, "ui_auto_scaling") == 0 ) {
                         if ( strcmp(opt_value, "yes") == 0 )
                             list->flags |= PROTEGE_FLAG_UI_AUTO_SCALING;
                         else
-                            list->flags &= !PROTEGE_FLAG_UI_AUTO_SCALING;
+                            list->flags &= ~PROTEGE_FLAG_UI_AUTO_SCALING;
+                    }
+                    else if ( strcmp(line, "supervisor") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_SUPERVISOR;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_SUPERVISOR;
+                    }
+                    else if ( strcmp(line, "supervisor_max_heap") == 0 )
+                        list->supervisor_max_heap = get_memory_value(opt_value);
+                    else if ( strcmp(line, "supervisor_restart_code") == 0 ) {
+                        int code;
+
+                        if ( get_integer_value(opt_value, 1, 255, &code) == 0
+                                && code != SUPERVISOR_OOM_CODE )
+                            list->supervisor_restart_code = code;
+                    }
+                    else if ( strcmp(line, "idle_memory_return") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_IDLE_MEMORY_RETURN;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_IDLE_MEMORY_RETURN;
+                    }
+                    else if ( strcmp(line, "idle_memory_delay") == 0 ) {
+                        int delay;
+
+                        if ( get_integer_value(opt_value, 1, 1440, &delay) == 0 )
+                            list->idle_memory_delay = delay;
+                    }
+                    else if ( strcmp(line, "profile") == 0 ) {
+                        if ( strcmp(opt_value, "perf") == 0 )
+                            list->flags |= PROTEGE_FLAG_PROFILE_PERF;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_PROFILE_PERF;
+                    }
+                    else if ( strcmp(line, "perf_record") == 0 ) {
+                        int duration;
+
+                        if ( get_integer_value(opt_value, 0, 86400, &duration) == 0 )
+                            list->perf_record_duration = duration;
+                    }
+                    else if ( strcmp(line, "metrics_interval") == 0 ) {
+                        int interval;
+
+                        if ( get_integer_value(opt_value, 0, 3600000, &interval) == 0
+                                && (interval == 0 || interval >= 100) )
+                            list->metrics_interval = interval;
+                    }
+                    else if ( strcmp(line, "plugin_sizing") == 0 ) {
+                        list->flags &= ~(PROTEGE_FLAG_PLUGIN_SIZING | PROTEGE_FLAG_PLUGIN_LIMITS);
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_PLUGIN_SIZING;
+                        else if ( strcmp(opt_value, "limits") == 0 )
+                            list->flags |= PROTEGE_FLAG_PLUGIN_SIZING | PROTEGE_FLAG_PLUGIN_LIMITS;
+                    }
+                    else if ( strcmp(line, "fast_exit") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_FAST_EXIT;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_FAST_EXIT;
+                    }
+                    else if ( strcmp(line, "java2d_pipeline") == 0 )
+                        (void) get_java2d_pipeline_value(opt_value, &list->java2d_pipeline);
+                    else if ( strcmp(line, "session_report") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_SESSION_REPORT;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_SESSION_REPORT;
+                    }
+                    else if ( strcmp(line, "font_cache") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_FONT_CACHE;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_FONT_CACHE;
+                    }
+                    else if ( strcmp(line, "bundle_index") == 0 ) {
+                        if ( strcmp(opt_value, "yes") == 0 )
+                            list->flags |= PROTEGE_FLAG_BUNDLE_INDEX;
+                        else
+                            list->flags &= ~PROTEGE_FLAG_BUNDLE_INDEX;
+                    }
+                    else if ( strcmp(line, "startup_timeout") == 0 ) {
+                        int timeout;
+
+                        if ( get_integer_value(opt_value, 0, 3600, &timeout) == 0 )
+                            list->startup_timeout = timeout;
+                    }
+                    else if ( strcmp(line, "ui_hang_threshold") == 0 ) {
+                        int threshold;
+
+                        if ( get_integer_value(opt_value, 0, 3600, &threshold) == 0 )
+                            list->hang_threshold = threshold;
+                    }
+                    else if ( strcmp(line, "startup_trace") == 0 ) {
+                        int duration;
+
+                        if ( get_integer_value(opt_value, 0, 600, &duration) == 0 )
+                            list->startup_trace = duration;
+                    }
+                    else if ( strcmp(line, "ontology_preload") == 0 ) {
+                        list->flags &= ~(PROTEGE_FLAG_PRELOAD | PROTEGE_FLAG_DECOMPRESS);
+                        if ( strcmp(opt_value, "readahead") == 0 )
+                            list->flags |= PROTEGE_FLAG_PRELOAD;
+                        else if ( strcmp(opt_value, "decompress") == 0 )
+                            list->flags |= PROTEGE_FLAG_PRELOAD | PROTEGE_FLAG_DECOMPRESS;
+                    }
+                    else if ( strcmp(line, "scratch_dir") == 0 ) {
+                        if ( list->scratch_dir )
+                            free(list->scratch_dir);
+                        list->scratch_dir = NULL;
+                        if ( strcmp(opt_value, "none") == 0 )
+                            list->flags &= ~PROTEGE_FLAG_SCRATCH_DIR;
+                        else {
+                            list->flags |= PROTEGE_FLAG_SCRATCH_DIR;
+                            list->scratch_dir = xstrdup(opt_value);
+                        }
                     }
 
                     if ( opt_string )
@@ -473,12 +1231,64 @@ get_option_list(const char *app_dir, struct option_list *list)
         ;
 #endif
 
-    /* Try setting a better default value for -Xmx. */
+#if !defined(PROTEGE_WIN32)
+    set_heap_dump_options(list);
+
+    if ( list->flags & PROTEGE_FLAG_PLUGIN_SIZING )
+        set_class_space_options(list, app_dir);
+
+    if ( list->flags & PROTEGE_FLAG_BUNDLE_INDEX )
+        set_bundle_index_option(list, app_dir);
+#endif
+
+    /* Try setting a better default value for -Xmx; after the sizing of
+     * the metaspace and code cache, which are accounted for. */
     set_default_max_heap(list);
 
+    /* Never override a temporary directory chosen by the user. */
+    if ( find_option(list, "-Djava.io.tmpdir=") )
+        list->flags &= ~PROTEGE_FLAG_SCRATCH_DIR;
+
+    if ( list->flags & PROTEGE_FLAG_IDLE_MEMORY_RETURN )
+        set_idle_memory_options(list);
+
+    /* Resolve the splash screen image. Like the standard java launcher,
+     * never show a splash screen in headless mode. */
+    if ( (splash = list->splash ? list->splash : DEFAULT_SPLASH_IMAGE)[0] != '\0'
+            && ! find_option(list, "-Djava.awt.headless=true") )
+        splash = try_pathname("%s/%s", app_dir, splash);
+    else
+        splash = NULL;
+    if ( list->splash )
+        free(list->splash);
+    list->splash = splash;
+
 #if defined(PROTEGE_LINUX)
+    /* Under the supervisor, the JVM must exit on OutOfMemoryError
+     * so that it can be restarted with a larger heap. The message
+     * telling what ran out goes to the standard output by default,
+     * whereas the supervisor only reads the error output. */
+    if ( list->flags & PROTEGE_FLAG_SUPERVISOR
+            && ! find_option(list, "-XX:-ExitOnOutOfMemoryError") ) {
+        set_default_option(list, "-XX:+ExitOnOutOfMemoryError",
+                           "-XX:+ExitOnOutOfMemoryError");
+        set_default_option(list, "-XX:+DisplayVMOutputToStderr",
+                           "-XX:+DisplayVMOutputToStderr");
+    }
+
+    set_processor_options(list);
+
+    if ( list->flags & PROTEGE_FLAG_PROFILE_PERF )
+        set_profile_options(list);
+
     if ( list->flags & PROTEGE_FLAG_UI_AUTO_SCALING )
         set_ui_scaling(list);
+
+    if ( list->flags & PROTEGE_FLAG_FONT_CACHE )
+        set_font_options(list);
+
+    if ( list->java2d_pipeline != PROTEGE_JAVA2D_DEFAULT )
+        set_java2d_options(list);
 #endif
 }
 
@@ -504,4 +1314,71 @@ free_option_list(struct option_list *list)
 
     if ( list->java_home )
         free(list->java_home);
+
+    if ( list->splash )
+        free(list->splash);
+
+    if ( list->heap_dump_dir )
+        free(list->heap_dump_dir);
+
+    if ( list->scratch_dir )
+        free(list->scratch_dir);
+
+    free_resource_settings(&list->resources);
+
+    list->allocated = list->count = 0;
+    list->options = NULL;
+    list->java_home = list->splash = list->heap_dump_dir = NULL;
+    list->scratch_dir = NULL;
+}
+
+/**
+ * Get the maximal heap size set in the list of options.
+ *
+ * @param list The options list.
+ *
+ * @return The maximal heap size in bytes, or 0 if the list does not
+ *         contain any -Xmx option.
+ */
+size_t
+get_max_heap_size(struct option_list *list)
+{
+    const char *option;
+
+    if ( (option = find_option(list, "-Xmx")) )
+        return get_memory_amount(option + 4);
+
+    return 0;
+}
+
+/**
+ * Set the maximal heap size, overriding any previous -Xmx option.
+ *
+ * @param list The options list.
+ * @param size The new maximal heap size in bytes; it will be rounded
+ *             down to the megabyte.
+ */
+void
+set_max_heap_size(struct option_list *list, size_t size)
+{
+    char *option = NULL;
+
+    (void) xasprintf(&option, "-Xmx%zuM", size / (1024 * 1024));
+    append_option(list, option);
+}
+
+/**
+ * Set the directory where Java writes its temporary files, overriding
+ * any previous java.io.tmpdir property.
+ *
+ * @param list The options list.
+ * @param path The pathname to the directory.
+ */
+void
+set_temporary_directory(struct option_list *list, const char *path)
+{
+    char *option = NULL;
+
+    (void) xasprintf(&option, "-Djava.io.tmpdir=%s", path);
+    append_option(list, option);
 }
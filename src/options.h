@@ -33,7 +33,30 @@
 
 #include <stdlib.h>
 
+#include "resources.h"
+
 #define PROTEGE_FLAG_UI_AUTO_SCALING	0x01
+#define PROTEGE_FLAG_SUPERVISOR		0x02
+#define PROTEGE_FLAG_HEAP_DUMPS		0x04
+#define PROTEGE_FLAG_IDLE_MEMORY_RETURN	0x08
+#define PROTEGE_FLAG_PROFILE_PERF	0x10
+#define PROTEGE_FLAG_PIN_PERFORMANCE	0x20
+#define PROTEGE_FLAG_SCRATCH_DIR	0x40
+#define PROTEGE_FLAG_PRELOAD		0x80
+#define PROTEGE_FLAG_DECOMPRESS		0x100
+#define PROTEGE_FLAG_PLUGIN_SIZING	0x200
+#define PROTEGE_FLAG_BUNDLE_INDEX	0x400
+#define PROTEGE_FLAG_FAST_EXIT		0x800
+#define PROTEGE_FLAG_FONT_CACHE		0x1000
+#define PROTEGE_FLAG_SESSION_REPORT	0x2000
+#define PROTEGE_FLAG_PLUGIN_LIMITS	0x4000
+
+/* Rendering pipelines for Java2D. */
+#define PROTEGE_JAVA2D_DEFAULT		0   /* Leave it to Java. */
+#define PROTEGE_JAVA2D_AUTO		1   /* Choose from the display. */
+#define PROTEGE_JAVA2D_XRENDER		2
+#define PROTEGE_JAVA2D_OPENGL		3
+#define PROTEGE_JAVA2D_SOFTWARE		4
 
 /*
  * Hold a list of options for the launcher.
@@ -46,19 +69,73 @@ struct option_list {
     char      **options;    /* Actual list of option strings. */
     char       *java_home;  /* Additional option specifying a custom
                                location for the JRE to use. */
+    char       *splash;     /* Image to show as a splash screen, or
+                               NULL for no splash screen. */
     unsigned    flags;      /* Misc additional options. */
+    struct resource_settings
+                resources;  /* Settings to apply to the process. */
+    size_t      supervisor_max_heap;
+                            /* Largest heap size the supervisor may
+                               use, in bytes (0 for the default). */
+    int         supervisor_restart_code;
+                            /* Exit code requesting a restart. */
+    char       *heap_dump_dir;
+                            /* Directory for managed heap dumps, or
+                               NULL if heap dumps are not managed. */
+    unsigned    heap_dump_count;
+                            /* Number of heap dumps to keep. */
+    size_t      heap_dump_quota;
+                            /* Maximal size of all heap dumps, in
+                               bytes (0 for no limit). */
+    unsigned    metrics_interval;
+                            /* Sampling interval for live metrics, in
+                               milliseconds (0 to disable). */
+    unsigned    idle_memory_delay;
+                            /* Minutes of inactivity after which
+                               memory is returned to the system. */
+    unsigned    perf_record_duration;
+                            /* Duration of the perf recording, in
+                               seconds (0 for no recording). */
+    unsigned    startup_timeout;
+                            /* Time allowed for Java to start, in
+                               seconds (0 for no limit). */
+    unsigned    hang_threshold;
+                            /* Time after which the user interface is
+                               considered blocked, in seconds (0 to
+                               disable the detection). */
+    unsigned    startup_trace;
+                            /* Duration of the startup trace, in
+                               seconds (0 for no trace). */
+    char       *scratch_dir;
+                            /* Preferred location for temporary files,
+                               or NULL to let the launcher choose. */
+    unsigned    java2d_pipeline;
+                            /* Rendering pipeline for Java2D, one of
+                               the PROTEGE_JAVA2D_* values. */
 };
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+char *
+find_configuration_file(const char *app_dir);
+
 void
 get_option_list(const char *app_dir, struct option_list *list);
 
 void
 free_option_list(struct option_list *list);
 
+size_t
+get_max_heap_size(struct option_list *list);
+
+void
+set_max_heap_size(struct option_list *list, size_t size);
+
+void
+set_temporary_directory(struct option_list *list, const char *path);
+
 #ifdef __cplusplus
 }
 #endif
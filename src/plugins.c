@@ -0,0 +1,673 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "plugins.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <inttypes.h>
+#include <ctype.h>
+#include <err.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <xmem.h>
+
+#include "util.h"
+#include "zip.h"
+
+/* Directories scanned, relative to the application directory. */
+static const char *plugin_dirs[] = {
+    "bundles",
+    "plugins",
+    NULL
+};
+
+#define PLUGINS_CACHE_FILE      "plugins"
+#define BUNDLE_INDEX_PREFIX     "bundles-"
+
+/* Maximal number of threads scanning the jars. */
+#define MAX_SCAN_THREADS        8
+
+/* Manifests are small, do not bother with anything larger. */
+#define MAX_MANIFEST_SIZE       (1024 * 1024)
+
+/* Maximal number of installations remembered in the cache. */
+#define PLUGINS_CACHE_ENTRIES   8
+
+/* Jars embedded in a bundle cannot be inspected without inflating
+ * them; we assume their classes compress by that factor, and have
+ * that average size. */
+#define EMBEDDED_JAR_RATIO      2
+#define AVERAGE_CLASS_SIZE      3072
+
+/* 64-bit FNV-1a hash. */
+#define FNV_OFFSET_BASIS        0xcbf29ce484222325ULL
+#define FNV_PRIME               0x100000001b3ULL
+
+static uint64_t
+hash_bytes(uint64_t hash, const void *data, size_t len)
+{
+    const unsigned char *p = data;
+
+    while ( len-- ) {
+        hash ^= *p++;
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Check whether a file name looks like a jar.
+ */
+static int
+is_jar(const char *name)
+{
+    size_t len = strlen(name);
+
+    return len > 4 && strcmp(name + len - 4, ".jar") == 0;
+}
+
+/*
+ * Call a function on each jar of the plugin directories.
+ */
+static void
+foreach_jar(const char *app_dir, void (*callback)(const char *, const struct stat *, void *),
+            void *data)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct stat st;
+    char *path = NULL;
+    size_t n;
+
+    for ( n = 0; plugin_dirs[n]; n++ ) {
+        (void) xasprintf(&path, "%s/%s", app_dir, plugin_dirs[n]);
+        if ( (dir = opendir(path)) ) {
+            free(path);
+            while ( (entry = readdir(dir)) ) {
+                if ( ! is_jar(entry->d_name) )
+                    continue;
+
+                path = NULL;
+                (void) xasprintf(&path, "%s/%s/%s", app_dir, plugin_dirs[n], entry->d_name);
+                if ( stat(path, &st) == 0 && S_ISREG(st.st_mode) )
+                    callback(path, &st, data);
+                free(path);
+            }
+            closedir(dir);
+        }
+        else
+            free(path);
+        path = NULL;
+    }
+}
+
+/*
+ * Add a jar to the fingerprint of the installation. The fingerprint
+ * must not depend on the order in which the jars are found, so the
+ * hashes of all jars are summed.
+ */
+static void
+add_to_fingerprint(const char *path, const struct stat *st, void *data)
+{
+    uint64_t *fingerprint = data, hash = FNV_OFFSET_BASIS;
+    int64_t size = st->st_size, mtime = st->st_mtime;
+
+    hash = hash_bytes(hash, path, strlen(path));
+    hash = hash_bytes(hash, &size, sizeof(size));
+    hash = hash_bytes(hash, &mtime, sizeof(mtime));
+    *fingerprint += hash;
+}
+
+/*
+ * Compute a fingerprint of the jars of an installation, which changes
+ * whenever a jar is added, removed, or modified.
+ *
+ * Returns the fingerprint, or 0 if there are no jars at all.
+ */
+static uint64_t
+get_fingerprint(const char *app_dir)
+{
+    uint64_t fingerprint = 0;
+
+    foreach_jar(app_dir, add_to_fingerprint, &fingerprint);
+
+    return fingerprint;
+}
+
+/*
+ * Count the classes of a jar, from its central directory.
+ */
+static void
+add_to_stats(const char *path, const struct stat *st, void *data)
+{
+    struct plugin_stats *stats = data;
+    struct zip_archive zip;
+    struct zip_entry entry;
+    size_t position = 0;
+
+    (void) st;
+
+    if ( zip_open(path, &zip) == -1 )
+        return;
+
+    stats->jars += 1;
+    while ( zip_next_entry(&zip, &position, &entry) == 1 ) {
+        if ( zip_has_suffix(&entry, ".class") ) {
+            stats->classes += 1;
+            stats->bytecode += entry.size;
+        }
+        else if ( zip_has_suffix(&entry, ".jar") ) {
+            stats->bytecode += entry.size * EMBEDDED_JAR_RATIO;
+            stats->classes += entry.size * EMBEDDED_JAR_RATIO / AVERAGE_CLASS_SIZE;
+        }
+    }
+
+    zip_close(&zip);
+}
+
+/*
+ * Get the pathname to the plugins cache file.
+ */
+static char *
+get_plugins_cache_file(void)
+{
+    char *dir, *path = NULL;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) xasprintf(&path, "%s/" PLUGINS_CACHE_FILE, dir);
+        free(dir);
+    }
+
+    return path;
+}
+
+/*
+ * Look for cached statistics for the installation with the specified
+ * fingerprint.
+ */
+static int
+get_stats_from_cache(uint64_t fingerprint, struct plugin_stats *stats)
+{
+    char *path, line[512];
+    FILE *f;
+    uint64_t key, classes, bytecode;
+    unsigned jars;
+    int ret = -1;
+
+    if ( ! (path = get_plugins_cache_file()) )
+        return -1;
+
+    if ( (f = fopen(path, "r")) ) {
+        while ( ! feof(f) && ret == -1 ) {
+            if ( get_line(f, line, sizeof(line)) > 0
+                    && sscanf(line, "%" SCNx64 " %u %" SCNu64 " %" SCNu64,
+                              &key, &jars, &classes, &bytecode) == 4
+                    && key == fingerprint ) {
+                stats->jars = jars;
+                stats->classes = classes;
+                stats->bytecode = bytecode;
+                ret = 0;
+            }
+        }
+        fclose(f);
+    }
+    free(path);
+
+    return ret;
+}
+
+/*
+ * Store the statistics of an installation in the cache. The cache is
+ * rewritten with the new entry first, followed by the most recent
+ * entries for other installations.
+ */
+static void
+store_stats_in_cache(uint64_t fingerprint, const struct plugin_stats *stats)
+{
+    char *path, *tmp_path = NULL, *dir, line[512];
+    FILE *in, *out;
+    uint64_t key;
+    int n = 1;
+
+    if ( ! (path = get_plugins_cache_file()) )
+        return;
+
+    if ( (dir = get_cache_directory()) ) {
+        (void) create_directory(dir);
+        free(dir);
+    }
+
+    (void) xasprintf(&tmp_path, "%s.%ld", path, (long) getpid());
+    if ( (out = fopen(tmp_path, "w")) ) {
+        fprintf(out, "%016" PRIx64 " %u %" PRIu64 " %" PRIu64 "\n", fingerprint,
+                stats->jars, stats->classes, stats->bytecode);
+
+        if ( (in = fopen(path, "r")) ) {
+            while ( ! feof(in) && n < PLUGINS_CACHE_ENTRIES ) {
+                if ( get_line(in, line, sizeof(line)) > 0
+                        && sscanf(line, "%" SCNx64, &key) == 1 && key != fingerprint ) {
+                    fprintf(out, "%s\n", line);
+                    n += 1;
+                }
+            }
+            fclose(in);
+        }
+
+        if ( fclose(out) == 0 )
+            (void) rename(tmp_path, path);
+        else
+            (void) unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    free(path);
+}
+
+/**
+ * Count the classes provided by the bundles and plugins of a Protégé
+ * installation, from the central directories of the jars. The result
+ * is cached, and only computed again when a jar is added, removed, or
+ * modified.
+ *
+ * @param app_dir The directory where Protégé is installed.
+ * @param stats   A structure to fill with the results.
+ *
+ * @return 0 if successful, or -1 if no jars have been found.
+ */
+int
+get_plugin_stats(const char *app_dir, struct plugin_stats *stats)
+{
+    uint64_t fingerprint;
+
+    memset(stats, 0, sizeof(struct plugin_stats));
+
+    if ( (fingerprint = get_fingerprint(app_dir)) == 0 )
+        return -1;
+
+    if ( get_stats_from_cache(fingerprint, stats) == 0 )
+        return 0;
+
+    foreach_jar(app_dir, add_to_stats, stats);
+    if ( stats->jars == 0 )
+        return -1;
+
+    store_stats_in_cache(fingerprint, stats);
+    return 0;
+}
+
+/*
+ * A bundle found in the plugin directories.
+ */
+struct bundle {
+    char   *path;
+    char   *name;       /* Bundle-SymbolicName, without attributes. */
+    char   *version;    /* Bundle-Version. */
+    char   *requires;   /* Require-Bundle. */
+    char   *imports;    /* Import-Package. */
+    int     shadowed;   /* Whether a more recent version exists. */
+};
+
+/*
+ * A list of jars, shared between the scanning threads.
+ */
+struct bundle_scan {
+    struct bundle  *bundles;
+    size_t          count;
+    size_t          allocated;
+    size_t          next;       /* Next jar to scan. */
+};
+
+/*
+ * Get the value of a header in the main section of a manifest, with
+ * continuation lines joined. Tabs are replaced by spaces, so that the
+ * value can be written in the tab-separated index.
+ *
+ * Returns a newly allocated buffer containing the value, or NULL if
+ * the header is not present.
+ */
+static char *
+get_manifest_header(const char *manifest, const char *name)
+{
+    const char *line = manifest, *end;
+    size_t len = strlen(name), n = 0;
+    char *value = NULL, *p;
+
+    while ( *line && *line != '\r' && *line != '\n' ) {
+        end = line + strcspn(line, "\r\n");
+
+        if ( value && *line == ' ' ) {
+            /* Continuation of the value. */
+            value = xrealloc(value, n + (end - line));
+            memcpy(value + n, line + 1, end - line - 1);
+            n += end - line - 1;
+        }
+        else if ( value )
+            break;
+        else if ( strncasecmp(line, name, len) == 0 && line[len] == ':' ) {
+            line += len + 1;
+            while ( line < end && *line == ' ' )
+                line++;
+            value = xmalloc(end - line + 1);
+            memcpy(value, line, end - line);
+            n = end - line;
+        }
+
+        line = end;
+        if ( *line == '\r' )
+            line++;
+        if ( *line == '\n' )
+            line++;
+    }
+
+    if ( value ) {
+        value[n] = '\0';
+        for ( p = value; (p = strchr(p, '\t')); )
+            *p = ' ';
+    }
+
+    return value;
+}
+
+/*
+ * Read the manifest of a bundle.
+ */
+static void
+scan_bundle(struct bundle *bundle)
+{
+    struct zip_archive zip;
+    struct zip_entry entry;
+    char *manifest, *p;
+
+    if ( zip_open(bundle->path, &zip) == -1 )
+        return;
+
+    if ( zip_find_entry(&zip, "META-INF/MANIFEST.MF", &entry) == 0
+            && (manifest = zip_extract_entry(&zip, &entry, MAX_MANIFEST_SIZE)) ) {
+        if ( (bundle->name = get_manifest_header(manifest, "Bundle-SymbolicName")) ) {
+            if ( (p = strchr(bundle->name, ';')) )
+                *p = '\0';
+            for ( p = bundle->name + strlen(bundle->name);
+                    p > bundle->name && isspace((unsigned char) p[-1]); )
+                *--p = '\0';
+
+            if ( ! (bundle->version = get_manifest_header(manifest, "Bundle-Version")) )
+                bundle->version = xstrdup("0.0.0");
+            bundle->requires = get_manifest_header(manifest, "Require-Bundle");
+            bundle->imports = get_manifest_header(manifest, "Import-Package");
+        }
+        free(manifest);
+    }
+
+    zip_close(&zip);
+}
+
+/*
+ * Main function of the scanning threads. Each thread takes the next
+ * jar that no other thread has taken yet.
+ */
+static void *
+scan_main(void *arg)
+{
+    struct bundle_scan *scan = arg;
+    size_t n;
+
+    while ( (n = __atomic_fetch_add(&scan->next, 1, __ATOMIC_RELAXED)) < scan->count )
+        scan_bundle(&scan->bundles[n]);
+
+    return NULL;
+}
+
+/*
+ * Add a jar to the list of jars to scan.
+ */
+static void
+add_to_scan(const char *path, const struct stat *st, void *data)
+{
+    struct bundle_scan *scan = data;
+
+    (void) st;
+
+    if ( scan->count >= scan->allocated ) {
+        scan->allocated = scan->allocated ? scan->allocated * 2 : 64;
+        scan->bundles = xrealloc(scan->bundles, scan->allocated * sizeof(struct bundle));
+    }
+
+    memset(&scan->bundles[scan->count], 0, sizeof(struct bundle));
+    scan->bundles[scan->count++].path = xstrdup(path);
+}
+
+/*
+ * Compare two OSGi versions (major.minor.micro.qualifier).
+ */
+static int
+compare_versions(const char *a, const char *b)
+{
+    unsigned long va, vb;
+    char *end_a, *end_b;
+    int n;
+
+    for ( n = 0; n < 3; n++ ) {
+        va = strtoul(a, &end_a, 10);
+        vb = strtoul(b, &end_b, 10);
+        if ( va != vb )
+            return va < vb ? -1 : 1;
+
+        a = *end_a == '.' ? end_a + 1 : end_a;
+        b = *end_b == '.' ? end_b + 1 : end_b;
+    }
+
+    return strcmp(a, b);
+}
+
+/*
+ * Mark the bundles for which a more recent version is installed. The
+ * first bundle found wins between identical versions.
+ */
+static void
+mark_shadowed_bundles(struct bundle_scan *scan)
+{
+    size_t i, j;
+    struct bundle *a, *b;
+
+    for ( i = 0; i < scan->count; i++ ) {
+        a = &scan->bundles[i];
+        for ( j = i + 1; a->name && j < scan->count; j++ ) {
+            b = &scan->bundles[j];
+            if ( ! b->name || b->shadowed || strcmp(a->name, b->name) != 0 )
+                continue;
+
+            if ( compare_versions(a->version, b->version) >= 0 )
+                b->shadowed = 1;
+            else {
+                a->shadowed = 1;
+                break;
+            }
+        }
+    }
+}
+
+/*
+ * Write the index of the bundles. The first line records the
+ * fingerprint of the installation; each following line describes one
+ * bundle, with tab-separated fields: symbolic name, version, state
+ * (active or shadowed), pathname, Require-Bundle, and Import-Package.
+ */
+static int
+write_bundle_index(const char *path, uint64_t fingerprint, struct bundle_scan *scan)
+{
+    char *tmp_path = NULL;
+    FILE *f;
+    size_t n;
+    struct bundle *b;
+    int ret = -1;
+
+    (void) xasprintf(&tmp_path, "%s.%ld", path, (long) getpid());
+    if ( (f = fopen(tmp_path, "w")) ) {
+        fprintf(f, "# fingerprint %016" PRIx64 "\n", fingerprint);
+        for ( n = 0; n < scan->count; n++ ) {
+            b = &scan->bundles[n];
+            if ( b->name )
+                fprintf(f, "%s\t%s\t%s\t%s\t%s\t%s\n", b->name, b->version,
+                        b->shadowed ? "shadowed" : "active", b->path,
+                        b->requires ? b->requires : "", b->imports ? b->imports : "");
+        }
+
+        if ( fclose(f) == 0 && rename(tmp_path, path) == 0 )
+            ret = 0;
+        else
+            (void) unlink(tmp_path);
+    }
+    free(tmp_path);
+
+    return ret;
+}
+
+/*
+ * Check whether an existing index has been built for the installation
+ * with the specified fingerprint.
+ */
+static int
+is_index_current(const char *path, uint64_t fingerprint)
+{
+    FILE *f;
+    char line[128];
+    uint64_t value;
+    int ret = 0;
+
+    if ( (f = fopen(path, "r")) ) {
+        if ( get_line(f, line, sizeof(line)) > 0
+                && sscanf(line, "# fingerprint %" SCNx64, &value) == 1
+                && value == fingerprint )
+            ret = 1;
+        fclose(f);
+    }
+
+    return ret;
+}
+
+/*
+ * Read the manifests of all the jars, with several threads.
+ */
+static void
+scan_bundles(struct bundle_scan *scan)
+{
+    pthread_t threads[MAX_SCAN_THREADS];
+    long n, nthreads;
+
+    nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+    if ( nthreads > MAX_SCAN_THREADS )
+        nthreads = MAX_SCAN_THREADS;
+    if ( nthreads > (long) scan->count )
+        nthreads = scan->count;
+
+    for ( n = 0; n < nthreads; n++ )
+        if ( pthread_create(&threads[n], NULL, scan_main, scan) != 0 )
+            break;
+    nthreads = n;
+
+    /* Do our share of the work, in case no thread could be started. */
+    (void) scan_main(scan);
+
+    for ( n = 0; n < nthreads; n++ )
+        (void) pthread_join(threads[n], NULL);
+}
+
+/**
+ * Get an index of the OSGi bundles of a Protégé installation, with
+ * their symbolic names, versions, and dependencies, read from the
+ * manifests of the jars in the bundles and plugins directories. Older
+ * versions of bundles installed several times are marked as shadowed.
+ * The index is kept in the cache directory, and only rebuilt when a
+ * jar is added, removed, or modified.
+ *
+ * @param app_dir The directory where Protégé is installed.
+ *
+ * @return A newly allocated buffer containing the pathname to the
+ *         index, or NULL if the index cannot be built.
+ */
+char *
+get_bundle_index(const char *app_dir)
+{
+    char *dir, *path = NULL;
+    uint64_t fingerprint;
+    struct bundle_scan scan;
+    size_t n;
+
+    if ( (fingerprint = get_fingerprint(app_dir)) == 0 || ! (dir = get_cache_directory()) )
+        return NULL;
+
+    (void) create_directory(dir);
+    (void) xasprintf(&path, "%s/" BUNDLE_INDEX_PREFIX "%016" PRIx64, dir,
+                     hash_bytes(FNV_OFFSET_BASIS, app_dir, strlen(app_dir)));
+    free(dir);
+
+    if ( is_index_current(path, fingerprint) )
+        return path;
+
+    memset(&scan, 0, sizeof(scan));
+    foreach_jar(app_dir, add_to_scan, &scan);
+    scan_bundles(&scan);
+    mark_shadowed_bundles(&scan);
+
+    for ( n = 0; n < scan.count; n++ )
+        if ( scan.bundles[n].shadowed )
+            warnx("Bundle %s is shadowed by a more recent version", scan.bundles[n].path);
+
+    if ( write_bundle_index(path, fingerprint, &scan) == -1 ) {
+        free(path);
+        path = NULL;
+    }
+
+    for ( n = 0; n < scan.count; n++ ) {
+        free(scan.bundles[n].path);
+        free(scan.bundles[n].name);
+        free(scan.bundles[n].version);
+        free(scan.bundles[n].requires);
+        free(scan.bundles[n].imports);
+    }
+    free(scan.bundles);
+
+    return path;
+}
+
+#endif
@@ -0,0 +1,677 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "preload.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <err.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#if defined(HAVE_ZLIB_H)
+#include <zlib.h>
+#endif
+
+#if defined(HAVE_LZMA_H)
+#include <lzma.h>
+#endif
+
+#if defined(HAVE_ZSTD_H)
+#include <zstd.h>
+#endif
+
+#include <xmem.h>
+
+#include "java.h"
+#include "util.h"
+
+/* Maximal number of ontologies to preload. */
+#define MAX_PRELOADS        16
+
+/* Name of the XML catalog that Protégé looks for next to an ontology. */
+#define CATALOG_NAME        "catalog-v001.xml"
+
+/* Catalogs are small, do not bother with anything larger. */
+#define MAX_CATALOG_SIZE    (4 * 1024 * 1024)
+
+#define TEMP_SUFFIX         ".tmp"
+#define COPY_BUFFER_SIZE    (256 * 1024)
+
+enum compression {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_XZ,
+    COMPRESSION_ZSTD
+};
+
+/*
+ * An ontology named on the command line.
+ */
+struct preload {
+    char      **arg;        /* Argument naming the ontology. */
+    char       *copy;       /* Decompressed copy, or NULL. */
+    unsigned    index;
+    pthread_t   thread;
+};
+
+/*
+ * State of the preloading.
+ */
+static struct {
+    int             decompress;     /* Whether to decompress ontologies,
+                                       or only read them. */
+    unsigned        count;
+    struct preload  files[MAX_PRELOADS];
+} preloads;
+
+/*
+ * Check whether a string ends with the given suffix.
+ */
+static int
+has_suffix(const char *s, const char *suffix)
+{
+    size_t len = strlen(s), suffix_len = strlen(suffix);
+
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+/*
+ * Read a file and throw away its contents, so that it is in the page
+ * cache by the time Java needs it.
+ */
+static void
+read_ahead(const char *path)
+{
+    char *buffer;
+    int fd;
+
+    if ( (fd = open(path, O_RDONLY)) == -1 )
+        return;
+
+#if defined(PROTEGE_LINUX)
+    (void) posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    buffer = xmalloc(COPY_BUFFER_SIZE);
+    while ( read(fd, buffer, COPY_BUFFER_SIZE) > 0 )
+        ;
+
+    free(buffer);
+    close(fd);
+}
+
+/*
+ * Find out how a file is compressed, from its name. Formats that the
+ * launcher has not been built to support are reported as uncompressed.
+ *
+ * Returns the compression method, and set *len to the length of the
+ * name without the compression suffix.
+ */
+static enum compression
+get_compression(const char *name, size_t *len)
+{
+    enum compression method = COMPRESSION_NONE;
+    size_t suffix_len = 0;
+
+#if defined(HAVE_ZLIB_H)
+    if ( has_suffix(name, ".gz") ) {
+        method = COMPRESSION_GZIP;
+        suffix_len = 3;
+    }
+#endif
+#if defined(HAVE_LZMA_H)
+    if ( has_suffix(name, ".xz") ) {
+        method = COMPRESSION_XZ;
+        suffix_len = 3;
+    }
+#endif
+#if defined(HAVE_ZSTD_H)
+    if ( has_suffix(name, ".zst") ) {
+        method = COMPRESSION_ZSTD;
+        suffix_len = 4;
+    }
+#endif
+
+    *len = strlen(name) - suffix_len;
+    return method;
+}
+
+#if defined(HAVE_ZLIB_H)
+
+/*
+ * Decompress a gzip file. Deflate streams cannot be decompressed in
+ * parallel.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+decompress_gzip(const char *source, FILE *out)
+{
+    gzFile in;
+    char *buffer;
+    int n, ret = 0;
+
+    if ( ! (in = gzopen(source, "rb")) )
+        return -1;
+
+    (void) gzbuffer(in, COPY_BUFFER_SIZE);
+    buffer = xmalloc(COPY_BUFFER_SIZE);
+    while ( ret == 0 && (n = gzread(in, buffer, COPY_BUFFER_SIZE)) > 0 )
+        if ( fwrite(buffer, 1, n, out) != (size_t) n )
+            ret = -1;
+    if ( n < 0 )
+        ret = -1;
+
+    free(buffer);
+    gzclose(in);
+
+    return ret;
+}
+
+#endif
+
+#if defined(HAVE_LZMA_H)
+
+/*
+ * Decompress a xz file, with one thread per CPU if the file has been
+ * compressed in multi-threaded mode (i.e., in several blocks).
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+decompress_xz(const char *source, FILE *out)
+{
+    FILE *in;
+    lzma_stream strm = LZMA_STREAM_INIT;
+    lzma_action action = LZMA_RUN;
+    lzma_ret status;
+    uint8_t *in_buf, *out_buf;
+    int ret = 0;
+#if defined(HAVE_LZMA_STREAM_DECODER_MT)
+    lzma_mt mt;
+    long ncpus;
+#endif
+
+    if ( ! (in = fopen(source, "rb")) )
+        return -1;
+
+#if defined(HAVE_LZMA_STREAM_DECODER_MT)
+    memset(&mt, 0, sizeof(mt));
+    mt.flags = LZMA_CONCATENATED;
+    mt.threads = (ncpus = sysconf(_SC_NPROCESSORS_ONLN)) > 0 ? ncpus : 1;
+    mt.memlimit_threading = lzma_physmem() / 4;
+    mt.memlimit_stop = UINT64_MAX;
+    status = lzma_stream_decoder_mt(&strm, &mt);
+#else
+    status = lzma_stream_decoder(&strm, UINT64_MAX, LZMA_CONCATENATED);
+#endif
+    if ( status != LZMA_OK ) {
+        fclose(in);
+        return -1;
+    }
+
+    in_buf = xmalloc(COPY_BUFFER_SIZE);
+    out_buf = xmalloc(COPY_BUFFER_SIZE);
+    strm.next_out = out_buf;
+    strm.avail_out = COPY_BUFFER_SIZE;
+
+    while ( ret == 0 ) {
+        if ( strm.avail_in == 0 && action == LZMA_RUN ) {
+            strm.next_in = in_buf;
+            strm.avail_in = fread(in_buf, 1, COPY_BUFFER_SIZE, in);
+            if ( ferror(in) )
+                ret = -1;
+            else if ( feof(in) )
+                action = LZMA_FINISH;
+        }
+
+        status = lzma_code(&strm, action);
+
+        if ( strm.avail_out == 0 || status == LZMA_STREAM_END ) {
+            size_t n = COPY_BUFFER_SIZE - strm.avail_out;
+
+            if ( fwrite(out_buf, 1, n, out) != n )
+                ret = -1;
+            strm.next_out = out_buf;
+            strm.avail_out = COPY_BUFFER_SIZE;
+        }
+
+        if ( status == LZMA_STREAM_END )
+            break;
+        else if ( status != LZMA_OK )
+            ret = -1;
+    }
+
+    lzma_end(&strm);
+    free(in_buf);
+    free(out_buf);
+    fclose(in);
+
+    return ret;
+}
+
+#endif
+
+#if defined(HAVE_ZSTD_H)
+
+/*
+ * Decompress a zstd file. Zstandard frames are decompressed on a
+ * single thread.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+decompress_zstd(const char *source, FILE *out)
+{
+    FILE *in;
+    ZSTD_DStream *strm;
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    size_t in_size, out_size, n, status = 0;
+    void *in_buf, *out_buf;
+    int ret = 0;
+
+    if ( ! (in = fopen(source, "rb")) )
+        return -1;
+
+    if ( ! (strm = ZSTD_createDStream()) ) {
+        fclose(in);
+        return -1;
+    }
+    (void) ZSTD_initDStream(strm);
+
+    in_buf = xmalloc(in_size = ZSTD_DStreamInSize());
+    out_buf = xmalloc(out_size = ZSTD_DStreamOutSize());
+
+    while ( ret == 0 && (n = fread(in_buf, 1, in_size, in)) > 0 ) {
+        input.src = in_buf;
+        input.size = n;
+        input.pos = 0;
+
+        while ( ret == 0 && input.pos < input.size ) {
+            output.dst = out_buf;
+            output.size = out_size;
+            output.pos = 0;
+
+            status = ZSTD_decompressStream(strm, &output, &input);
+            if ( ZSTD_isError(status) )
+                ret = -1;
+            else if ( fwrite(out_buf, 1, output.pos, out) != output.pos )
+                ret = -1;
+        }
+    }
+    /* A non-zero status at the end means a truncated frame. */
+    if ( ferror(in) || status != 0 )
+        ret = -1;
+
+    free(in_buf);
+    free(out_buf);
+    ZSTD_freeDStream(strm);
+    fclose(in);
+
+    return ret;
+}
+
+#endif
+
+/*
+ * Decompress a file. The data is first written to a temporary file,
+ * which is only renamed once the decompression is complete.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+decompress(const char *source, enum compression method, const char *target)
+{
+    char *tmp_path = NULL;
+    FILE *out;
+    int ret = -1;
+
+    (void) xasprintf(&tmp_path, "%s.%ld" TEMP_SUFFIX, target, (long) getpid());
+    if ( ! (out = fopen(tmp_path, "wb")) ) {
+        free(tmp_path);
+        return -1;
+    }
+
+    switch ( method ) {
+#if defined(HAVE_ZLIB_H)
+    case COMPRESSION_GZIP:
+        ret = decompress_gzip(source, out);
+        break;
+#endif
+#if defined(HAVE_LZMA_H)
+    case COMPRESSION_XZ:
+        ret = decompress_xz(source, out);
+        break;
+#endif
+#if defined(HAVE_ZSTD_H)
+    case COMPRESSION_ZSTD:
+        ret = decompress_zstd(source, out);
+        break;
+#endif
+    default:
+        break;
+    }
+
+    if ( fclose(out) != 0 )
+        ret = -1;
+
+    if ( ret == 0 && rename(tmp_path, target) == -1 )
+        ret = -1;
+
+    if ( ret == -1 ) {
+        warnx("Cannot decompress %s", source);
+        (void) unlink(tmp_path);
+    }
+
+    free(tmp_path);
+    return ret;
+}
+
+/*
+ * Read a whole catalog file into memory.
+ *
+ * Returns a newly allocated, NUL-terminated buffer, or NULL if the
+ * file cannot be read.
+ */
+static char *
+read_catalog(const char *path)
+{
+    FILE *f;
+    struct stat st;
+    char *contents = NULL;
+
+    if ( stat(path, &st) == -1 || st.st_size > MAX_CATALOG_SIZE )
+        return NULL;
+
+    if ( (f = fopen(path, "r")) ) {
+        contents = xmalloc(st.st_size + 1);
+        contents[fread(contents, 1, st.st_size, f)] = '\0';
+        fclose(f);
+    }
+
+    return contents;
+}
+
+/*
+ * Convert the value of a uri attribute in a catalog into a local
+ * pathname.
+ *
+ * Returns a newly allocated buffer containing the pathname, or NULL
+ * if the URI does not point to a local file.
+ */
+static char *
+get_local_path(const char *dir, const char *uri, size_t len)
+{
+    char *path = NULL, *p;
+    size_t i;
+
+    if ( len > 7 && strncmp(uri, "file://", 7) == 0 ) {
+        uri += 7;
+        len -= 7;
+    }
+    else if ( len > 5 && strncmp(uri, "file:", 5) == 0 ) {
+        uri += 5;
+        len -= 5;
+    }
+    else if ( memchr(uri, ':', len) )
+        return NULL;    /* Some other scheme. */
+
+    if ( uri[0] == '/' )
+        (void) xasprintf(&path, "%.*s", (int) len, uri);
+    else
+        (void) xasprintf(&path, "%s/%.*s", dir, (int) len, uri);
+
+    /* Decode percent-encoded characters. */
+    for ( i = 0, p = path; path[i]; p++ ) {
+        if ( path[i] == '%' && isxdigit((unsigned char) path[i + 1])
+                && isxdigit((unsigned char) path[i + 2]) ) {
+            char hex[3] = { path[i + 1], path[i + 2], '\0' };
+
+            *p = (char) strtol(hex, NULL, 16);
+            i += 3;
+        }
+        else
+            *p = path[i++];
+    }
+    *p = '\0';
+
+    return path;
+}
+
+/*
+ * Read ahead the local files listed in the uri attributes of a catalog.
+ */
+static void
+read_catalog_entries(const char *dir, const char *catalog)
+{
+    const char *p = catalog, *value, *end;
+    char *path;
+    char quote;
+
+    while ( (p = strstr(p, "<uri")) ) {
+        p += 4;
+        if ( ! isspace((unsigned char) *p) )
+            continue;   /* Another element, such as <uriSuffix>. */
+
+        end = strchr(p, '>');
+        while ( (value = strstr(p, "uri=")) && (! end || value < end) ) {
+            p = value + 4;
+            if ( ! isspace((unsigned char) value[-1]) || (*p != '"' && *p != '\'') )
+                continue;
+
+            quote = *p++;
+            if ( ! (value = strchr(p, quote)) )
+                return;
+
+            if ( (path = get_local_path(dir, p, value - p)) ) {
+                read_ahead(path);
+                free(path);
+            }
+            p = value + 1;
+            break;
+        }
+    }
+}
+
+/*
+ * Give the decompressed copy of an ontology the modification time of
+ * the original, which tells on the next launches that the copy can be
+ * reused as is.
+ */
+static void
+mark_copy(const char *target, const struct stat *source_st)
+{
+    struct timeval times[2];
+
+    times[0].tv_sec = times[1].tv_sec = source_st->st_mtime;
+    times[0].tv_usec = times[1].tv_usec = 0;
+    (void) utimes(target, times);
+}
+
+/*
+ * Decompress an ontology next to the original, unless that has
+ * already been done by a previous launch. A file that already exists
+ * at that location and has been modified since (typically by saving
+ * the ontology from Protégé) is never overwritten.
+ *
+ * Returns 0 if the copy is usable, otherwise -1.
+ */
+static int
+make_copy(const char *source, enum compression method, const char *target)
+{
+    struct stat source_st, target_st;
+
+    if ( stat(source, &source_st) == -1 )
+        return -1;
+
+    if ( stat(target, &target_st) == 0 ) {
+        if ( target_st.st_mtime != source_st.st_mtime ) {
+            warnx("%s already exists and differs from %s, not decompressing", target, source);
+            return -1;
+        }
+        read_ahead(target);
+        return 0;
+    }
+
+    if ( decompress(source, method, target) == -1 )
+        return -1;
+
+    mark_copy(target, &source_st);
+    return 0;
+}
+
+/*
+ * Body of a preloading thread. Decompresses or reads ahead one
+ * ontology, then reads ahead the local imports listed in the catalog
+ * next to it.
+ */
+static void *
+preload_main(void *arg)
+{
+    struct preload *preload = arg;
+    const char *source = *preload->arg, *name;
+    char *dir, *target = NULL, *catalog_path = NULL, *catalog;
+    enum compression method;
+    size_t len;
+
+    set_thread_name("protege-preload");
+
+    if ( ! (dir = realpath(source, NULL)) )
+        return NULL;
+    *strrchr(dir, '/') = '\0';
+    name = (name = strrchr(source, '/')) ? name + 1 : source;
+
+    /* The copy goes next to the original, so that it survives the
+     * session (Protégé saves the ontology to the copy) and the same
+     * catalog applies to it. */
+    method = get_compression(name, &len);
+    if ( method != COMPRESSION_NONE && preloads.decompress && access(dir, W_OK) == 0 ) {
+        (void) xasprintf(&target, "%s/%.*s", dir, (int) len, name);
+        if ( make_copy(source, method, target) == 0 ) {
+            preload->copy = target;
+            target = NULL;
+        }
+        else
+            read_ahead(source);
+    }
+    else
+        read_ahead(source);
+
+    (void) xasprintf(&catalog_path, "%s/" CATALOG_NAME, dir);
+    if ( (catalog = read_catalog(catalog_path)) ) {
+        read_catalog_entries(dir, catalog);
+        free(catalog);
+    }
+
+    free(catalog_path);
+    free(target);
+    free(dir);
+
+    return NULL;
+}
+
+/*
+ * Called once the virtual machine has been created: waits for the
+ * preloading threads, and makes the arguments point to the
+ * decompressed copies of the ontologies, telling the user that changes
+ * will be saved to the copies.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    unsigned n;
+
+    (void) jvm;
+    (void) env;
+    (void) data;
+
+    for ( n = 0; n < preloads.count; n++ ) {
+        (void) pthread_join(preloads.files[n].thread, NULL);
+        if ( preloads.files[n].copy ) {
+            warnx("Opening %s (decompressed from %s); changes will be saved there",
+                  preloads.files[n].copy, *preloads.files[n].arg);
+            *preloads.files[n].arg = preloads.files[n].copy;
+        }
+    }
+}
+
+/**
+ * Start reading the ontologies named on the command line in the
+ * background, while the virtual machine is being created. Compressed
+ * ontologies (gzip, xz, or zstd, depending on the libraries available
+ * at build time) may be decompressed next to the originals, in which
+ * case the arguments are replaced with the decompressed copies before
+ * the main class is started.
+ *
+ * @param args       The NULL-terminated list of arguments to be passed
+ *                   to Protégé; must stay valid until Java has started.
+ * @param decompress Whether to decompress compressed ontologies, or
+ *                   only read them ahead.
+ */
+void
+preload_ontologies(char **args, int decompress)
+{
+    struct stat st;
+    struct preload *preload;
+
+    preloads.decompress = decompress;
+
+    for ( ; *args && preloads.count < MAX_PRELOADS; args++ ) {
+        if ( (*args)[0] == '-' || stat(*args, &st) == -1 || ! S_ISREG(st.st_mode) )
+            continue;
+
+        preload = &preloads.files[preloads.count];
+        preload->arg = args;
+        preload->copy = NULL;
+        preload->index = preloads.count;
+
+        if ( pthread_create(&preload->thread, NULL, preload_main, preload) == 0 )
+            preloads.count += 1;
+    }
+
+    if ( preloads.count > 0 )
+        add_java_callback(on_java_created, NULL);
+}
+
+#endif
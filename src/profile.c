@@ -0,0 +1,245 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "profile.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdio.h>
+#include <string.h>
+#include <err.h>
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <xmem.h>
+
+#include "java.h"
+#include "jmx.h"
+#include "util.h"
+
+/* How often to refresh the perf map, in seconds. */
+#define PERF_MAP_INTERVAL   10
+
+/* Where the JVM writes its perf map, and where perf looks for it. */
+#define PERF_MAP_FORMAT     "/tmp/perf-%ld.map"
+
+/*
+ * State of the profiling session.
+ */
+static struct {
+    unsigned        duration;   /* Duration of the recording, in
+                                   seconds (0 for no recording). */
+    pid_t           owner;      /* Profiled process. */
+    pid_t           perf_pid;   /* Process running perf record, or 0. */
+    char           *data_file;  /* Where perf writes its data. */
+    char           *map_file;   /* Where to copy the perf map. */
+} profile;
+
+/*
+ * Copy the perf map of the virtual machine next to the perf data, so
+ * that the recording can be analysed after the session has ended.
+ */
+static void
+copy_perf_map(void)
+{
+    char *source = NULL, buffer[8192];
+    FILE *in, *out;
+    size_t n;
+
+    (void) xasprintf(&source, PERF_MAP_FORMAT, (long) profile.owner);
+    if ( (in = fopen(source, "r")) ) {
+        if ( (out = fopen(profile.map_file, "w")) ) {
+            while ( (n = fread(buffer, 1, sizeof(buffer), in)) > 0 )
+                (void) fwrite(buffer, 1, n, out);
+            if ( fclose(out) != 0 )
+                warn("Cannot write %s", profile.map_file);
+        }
+        fclose(in);
+    }
+    free(source);
+}
+
+/*
+ * Start recording the virtual machine with perf, in a child process.
+ */
+static void
+start_perf_record(void)
+{
+    char *dir, pid[16], duration[16];
+
+    if ( ! (dir = get_log_directory()) )
+        return;
+
+    (void) create_directory(dir);
+    (void) xasprintf(&profile.data_file, "%s/perf-%ld.data", dir, (long) profile.owner);
+    (void) xasprintf(&profile.map_file, "%s/perf-%ld.map", dir, (long) profile.owner);
+    free(dir);
+
+    (void) snprintf(pid, sizeof(pid), "%ld", (long) profile.owner);
+    (void) snprintf(duration, sizeof(duration), "%u", profile.duration);
+
+    if ( (profile.perf_pid = fork()) == 0 ) {
+        (void) execlp("perf", "perf", "record", "--call-graph", "fp", "-p", pid,
+                      "-o", profile.data_file, "--", "sleep", duration, (char *) NULL);
+        _exit(127);
+    }
+    else if ( profile.perf_pid == -1 ) {
+        warn("Cannot start perf");
+        profile.perf_pid = 0;
+    }
+}
+
+/*
+ * Wrap up the recording once perf has terminated.
+ */
+static void
+finish_perf_record(int status)
+{
+    profile.perf_pid = 0;
+
+    if ( WIFEXITED(status) && WEXITSTATUS(status) == 127 )
+        warnx("Cannot execute perf");
+    else {
+        copy_perf_map();
+        warnx("Profile written to %s", profile.data_file);
+    }
+}
+
+/*
+ * Stop the recording if Protégé exits before its end.
+ */
+static void
+stop_perf_record(void)
+{
+    int status;
+
+    if ( getpid() != profile.owner || ! profile.perf_pid )
+        return;
+
+    /* perf writes its data when interrupted. By now the JVM has
+     * written the final perf map (DumpPerfMapAtExit). */
+    (void) kill(profile.perf_pid, SIGINT);
+    if ( waitpid(profile.perf_pid, &status, 0) == profile.perf_pid )
+        finish_perf_record(status);
+}
+
+/*
+ * Main function of the profiling thread. It regularly asks the JVM to
+ * update its perf map (the map is otherwise only written when the JVM
+ * exits, which is too late for perf top), and watches the perf process.
+ */
+static void *
+profile_main(void *arg)
+{
+    JavaVM *jvm = arg;
+    JNIEnv *env;
+    JavaVMAttachArgs attach_args;
+    int can_refresh = 1, status;
+    unsigned elapsed = 0;
+
+    attach_args.version = JNI_VERSION_1_2;
+    attach_args.name = "protege-perfmap";
+    attach_args.group = NULL;
+
+    set_thread_name(attach_args.name);
+
+    if ( (*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **) &env, &attach_args) != JNI_OK )
+        return NULL;
+
+    while ( can_refresh || profile.perf_pid ) {
+        if ( can_refresh && elapsed % PERF_MAP_INTERVAL == 0 )
+            /* Compiler.perfmap is only available since Java 17. */
+            can_refresh = run_diagnostic_command(env, "compilerPerfmap", NULL, NULL) == 0;
+
+        if ( profile.perf_pid
+                && waitpid(profile.perf_pid, &status, WNOHANG) == profile.perf_pid ) {
+            if ( can_refresh )
+                (void) run_diagnostic_command(env, "compilerPerfmap", NULL, NULL);
+            finish_perf_record(status);
+        }
+
+        sleep(1);
+        elapsed += 1;
+    }
+
+    (*jvm)->DetachCurrentThread(jvm);
+    return NULL;
+}
+
+/*
+ * Called once the virtual machine has been created.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    (void) data;
+
+    (void) init_jmx(env);
+
+    if ( profile.duration )
+        start_perf_record();
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, profile_main, jvm) != 0 )
+        warn("Cannot start profiling thread");
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Prepare the profiling of the virtual machine with perf. Once the
+ * virtual machine has been created, its perf map is kept up to date,
+ * and if requested, perf record is started to record the virtual
+ * machine for the specified duration. The recording and a copy of the
+ * perf map are written in the log directory.
+ *
+ * @param duration The duration of the recording in seconds, or 0 to
+ *                 only maintain the perf map.
+ */
+void
+start_perf_profiling(unsigned duration)
+{
+    profile.duration = duration;
+    profile.owner = getpid();
+
+    add_exit_handler(stop_perf_record);
+    add_java_callback(on_java_created, NULL);
+}
+
+#endif /* !PROTEGE_LINUX */
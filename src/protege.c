@@ -33,6 +33,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <err.h>
 #include <unistd.h>
@@ -40,6 +41,22 @@
 #include "util.h"
 #include "java.h"
 #include "options.h"
+#include "translate.h"
+#include "fallback.h"
+#include "metrics.h"
+#include "idle.h"
+#include "profile.h"
+#include "scratch.h"
+#include "preload.h"
+#include "watchdog.h"
+#include "trace.h"
+#include "fastexit.h"
+#include "diagnose.h"
+#include "fonts.h"
+#include "report.h"
+#include "interactive.h"
+#include "supervisor.h"
+#include "heapdump.h"
 
 #if defined(PROTEGE_WIN32)
 #include <windows.h>
@@ -47,22 +64,74 @@
 #endif
 
 static char *app_dir = NULL;
+static char *java_home = NULL;
 struct option_list opt_list;
+static struct jre_info jre_info;
+static char **vm_options = NULL;
 
 static void
 cleanup(void)
 {
+#if !defined(PROTEGE_WIN32)
+    char *dump;
+
+    if ( opt_list.heap_dump_dir && (dump = get_heap_dump(opt_list.heap_dump_dir, getpid())) ) {
+        warnx("Java ran out of memory, heap dump written to %s", dump);
+        free(dump);
+    }
+#endif
+
     if ( app_dir )
         free(app_dir);
 
+    if ( java_home )
+        free(java_home);
+
+    if ( vm_options )
+        free_translated_options(vm_options);
+
+    free_jre_info(&jre_info);
+
     free_option_list(&opt_list);
 }
 
+#if !defined(PROTEGE_WIN32)
+/*
+ * Resolve the JRE and the Java options as for a normal launch, and
+ * print them along with the characteristics of the system, instead of
+ * starting Java.
+ */
+static int
+diagnose(int json)
+{
+    void *jre;
+    int ret;
+
+    if ( opt_list.java_home )
+        ret = load_jre(opt_list.java_home, 0, &jre, &java_home);
+    else
+        ret = load_jre(app_dir, 1, &jre, &java_home);
+    if ( ret != 0 )
+        errx(EXIT_FAILURE, "Cannot load JRE: %s", get_java_error(ret));
+
+    (void) get_jre_info(java_home, &jre_info);
+    init_fallback(NULL, &jre_info);
+
+    vm_options = translate_options((const char **)opt_list.options, &jre_info);
+    filter_vm_options(vm_options);
+
+    return print_diagnosis(app_dir, java_home, &jre_info, vm_options, &opt_list, json);
+}
+#endif
+
 int
 main(int argc, char **argv)
 {
     void* jre;
     int ret;
+#if !defined(PROTEGE_WIN32)
+    const char *scratch_dir = NULL;
+#endif
 
 #if defined(PROTEGE_WIN32)
     /* If the launcher was started from a terminal, let's make sure
@@ -74,6 +143,14 @@ main(int argc, char **argv)
 #endif
 
     setprogname("protege");
+
+#if !defined(PROTEGE_WIN32)
+    /* Viewer modes, do not start Java. */
+    if ( argc > 1 && strcmp(argv[1], "--top") == 0 )
+        return run_metrics_viewer(argc > 2 ? argv[2] : NULL);
+    if ( argc > 1 && strcmp(argv[1], "--trace-report") == 0 )
+        return run_trace_report(argc > 2 ? argv[2] : NULL);
+#endif
     (void) atexit(cleanup);
 
     if ( ! (app_dir = get_application_directory()) )
@@ -84,18 +161,120 @@ main(int argc, char **argv)
 
     get_option_list(app_dir, &opt_list);
 
+#if !defined(PROTEGE_WIN32)
+    /* Diagnosis mode, does not start Java either. */
+    if ( argc > 1 && strcmp(argv[1], "--diagnose") == 0 )
+        return diagnose(argc > 2 && strcmp(argv[2], "--json") == 0);
+
+    /* The JVM only writes heap dumps into an existing directory. */
+    if ( opt_list.heap_dump_dir && create_directory(opt_list.heap_dump_dir) == -1 )
+        warn("Cannot create heap dump directory %s", opt_list.heap_dump_dir);
+#endif
+
+#if defined(PROTEGE_LINUX)
+    /* Only returns in the supervised process. */
+    if ( opt_list.flags & PROTEGE_FLAG_SUPERVISOR && ! getenv(SUPERVISOR_ENV) )
+        run_supervisor(app_dir, &opt_list);
+#endif
+
+    /* Must be done before any thread is started. */
+    apply_resource_settings(&opt_list.resources);
+
+#if !defined(PROTEGE_WIN32)
+    /* Deal with heap dumps left by previous sessions while Protégé is
+     * running (under the supervisor, this is done by the supervisor). */
+    if ( opt_list.heap_dump_dir && ! getenv(SUPERVISOR_ENV) )
+        start_heap_dump_manager(opt_list.heap_dump_dir, opt_list.heap_dump_count,
+                                opt_list.heap_dump_quota);
+#endif
+
     if ( opt_list.java_home )
-        ret = load_jre(opt_list.java_home, 0, &jre);
+        ret = load_jre(opt_list.java_home, 0, &jre, &java_home);
     else
-        ret = load_jre(app_dir, 1, &jre);
+        ret = load_jre(app_dir, 1, &jre, &java_home);
     if ( ret != 0 )
         errx(EXIT_FAILURE, "Cannot load JRE: %s", get_java_error(ret));
 
+    /* Show the splash screen as early as possible. */
+    if ( opt_list.splash )
+        (void) show_splash_screen(java_home, opt_list.splash);
+
+    /* Adapt the options to the JRE we are about to use. */
+    (void) get_jre_info(java_home, &jre_info);
+
+#if !defined(PROTEGE_WIN32)
+    /* Be ready to try again if the options prevent Java from starting. */
+    init_fallback(argv, &jre_info);
+
+    /* Must be done after init_fallback, so that the directory is
+     * removed before the launcher is re-executed from atexit. */
+    if ( opt_list.flags & PROTEGE_FLAG_SCRATCH_DIR
+            && (scratch_dir = create_scratch_directory(opt_list.scratch_dir,
+                                                       get_max_heap_size(&opt_list))) )
+        set_temporary_directory(&opt_list, scratch_dir);
+
+    /* Read the ontologies while the virtual machine is being created. */
+    if ( opt_list.flags & PROTEGE_FLAG_PRELOAD && argc > 1 )
+        preload_ontologies(&argv[1], opt_list.flags & PROTEGE_FLAG_DECOMPRESS);
+#endif
+
+    vm_options = translate_options((const char **)opt_list.options, &jre_info);
+
+#if !defined(PROTEGE_WIN32)
+    filter_vm_options(vm_options);
+
+    if ( opt_list.metrics_interval )
+        (void) start_metrics_sampler(opt_list.metrics_interval);
+
+    if ( opt_list.startup_trace )
+        start_startup_trace(opt_list.startup_trace);
+
+    if ( (opt_list.flags & PROTEGE_FLAG_SESSION_REPORT || getenv(SESSION_REPORT_ENV))
+            && start_session_report(getenv(SESSION_REPORT_ENV)) == 0 ) {
+        add_report_value("max_heap_mb", get_max_heap_size(&opt_list) / (1024 * 1024));
+#if defined(PROTEGE_LINUX)
+        start_interactive_watch();
+#endif
+    }
+
+    /* The fast exit loses the exit code, which the supervisor needs to
+     * tell whether Protégé asked to be restarted. */
+    if ( opt_list.flags & PROTEGE_FLAG_FAST_EXIT && ! getenv(SUPERVISOR_ENV) )
+        enable_fast_exit();
+#endif
+
+#if defined(PROTEGE_LINUX)
+    if ( opt_list.flags & PROTEGE_FLAG_IDLE_MEMORY_RETURN )
+        start_idle_monitor(opt_list.idle_memory_delay);
+
+    if ( opt_list.flags & PROTEGE_FLAG_PROFILE_PERF )
+        start_perf_profiling(opt_list.perf_record_duration);
+
+    if ( opt_list.flags & PROTEGE_FLAG_FONT_CACHE )
+        update_font_configuration();
+
+    if ( opt_list.startup_timeout || opt_list.hang_threshold )
+        start_watchdog(opt_list.startup_timeout, opt_list.hang_threshold);
+#endif
+
     if ( (ret = start_java(jre,
-                           (const char **)opt_list.options,
+                           (const char **)vm_options,
                            "org/protege/osgi/framework/Launcher",
-                           argc > 1 ? (const char **)&(argv[1]) : NULL)) != 0 )
+                           argc > 1 ? (const char **)&(argv[1]) : NULL)) != 0 ) {
+        close_splash_screen();
+#if !defined(PROTEGE_WIN32)
+        if ( ret == JAVA_CREATE_VM_ERROR ) {
+            remove_scratch_directory();
+            retry_launch();
+        }
+#endif
         errx(EXIT_FAILURE, "Cannot start Java: %s", get_java_error(ret));
+    }
+
+#if !defined(PROTEGE_WIN32)
+    /* The virtual machine has been destroyed, its files are no longer needed. */
+    remove_scratch_directory();
+#endif
 
     return EXIT_SUCCESS;
 }
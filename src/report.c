@@ -0,0 +1,273 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "report.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/resource.h>
+
+#include <err.h>
+#include <xmem.h>
+
+#include "util.h"
+#include "java.h"
+
+/* Largest number of values in a report. */
+#define MAX_REPORT_VALUES   32
+
+/*
+ * State of the session report.
+ */
+static struct {
+    char           *path;
+    pid_t           owner;      /* Process that started the report. */
+    time_t          start_time;
+    uint64_t        origin;     /* Start of the process, in ms on the
+                                   monotonic clock. */
+    pthread_mutex_t lock;
+    size_t          count;
+    struct {
+        char       *key;
+        long long   value;
+    }               values[MAX_REPORT_VALUES];
+} report = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+/*
+ * Get the time on the monotonic clock, in milliseconds. On GNU/Linux,
+ * that clock includes the time spent suspended, as the start time of
+ * the process does.
+ */
+static uint64_t
+get_clock(void)
+{
+    struct timespec ts;
+
+#if defined(PROTEGE_LINUX)
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/*
+ * Get the time the process was started, on the same clock as
+ * get_clock(). Only GNU/Linux tells us; elsewhere, the current time is
+ * the best approximation.
+ */
+static uint64_t
+get_process_start(void)
+{
+#if defined(PROTEGE_LINUX)
+    FILE *f;
+    char line[1024], *p;
+    unsigned long long start;
+    long ticks = sysconf(_SC_CLK_TCK);
+    int ok = 0;
+
+    if ( (f = fopen("/proc/self/stat", "r")) ) {
+        /* The name may contain spaces and parentheses, so we rely on
+         * the last closing parenthesis to find the following fields. */
+        if ( get_line(f, line, sizeof(line)) > 0 && (p = strrchr(line, ')'))
+                && sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u "
+                          "%*u %*u %*d %*d %*d %*d %*d %*d %llu", &start) == 1 )
+            ok = 1;
+        fclose(f);
+    }
+
+    if ( ok && ticks > 0 )
+        return start * 1000 / ticks;
+#endif
+
+    return get_clock();
+}
+
+/*
+ * Called once the virtual machine has been created.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    (void) jvm;
+    (void) env;
+    (void) data;
+
+    add_report_value("time_to_jvm_ms", get_session_time());
+}
+
+/**
+ * Prepare a report of the session, to be written when the launcher
+ * exits. Besides the values added by other parts of the launcher, the
+ * report contains the duration of the session, the CPU time used, and
+ * the peak memory usage.
+ *
+ * @param path The file to write the report to, or NULL (or an empty
+ *             string) to write it to session-<pid>.json in the log
+ *             directory.
+ * @return 0 if successful, or -1 if the report cannot be written.
+ */
+int
+start_session_report(const char *path)
+{
+    char *dir;
+
+    if ( path && *path )
+        report.path = xstrdup(path);
+    else {
+        if ( ! (dir = get_log_directory()) )
+            return -1;
+
+        (void) create_directory(dir);
+        (void) xasprintf(&report.path, "%s/session-%ld.json", dir, (long) getpid());
+        free(dir);
+    }
+
+    report.owner = getpid();
+    report.start_time = time(NULL);
+    report.origin = get_process_start();
+    add_exit_handler(write_session_report);
+    add_java_callback(on_java_created, NULL);
+
+    return 0;
+}
+
+/**
+ * Get the time elapsed since the start of the process (or, where that
+ * is not known, since the start of the session report).
+ *
+ * @return The elapsed time, in milliseconds.
+ */
+uint64_t
+get_session_time(void)
+{
+    uint64_t now = get_clock();
+
+    return now > report.origin ? now - report.origin : 0;
+}
+
+/**
+ * Write the session report as it currently stands. This is done
+ * automatically when the launcher exits, but can be done earlier so
+ * that the values collected so far can be read while Protégé is still
+ * running. This function is thread-safe; processes forked from the
+ * launcher do not write the report.
+ */
+void
+write_session_report(void)
+{
+    FILE *f;
+    struct rusage usage;
+    long long peak_rss = 0, cpu_time = 0;
+    char *tmp_path = NULL;
+    size_t i;
+
+    if ( ! report.path || getpid() != report.owner )
+        return;
+
+    if ( getrusage(RUSAGE_SELF, &usage) == 0 ) {
+        cpu_time = (long long) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+            + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+#if defined(PROTEGE_MACOS)
+        peak_rss = usage.ru_maxrss / 1024;
+#else
+        peak_rss = usage.ru_maxrss;
+#endif
+    }
+
+    pthread_mutex_lock(&report.lock);
+
+    /* Readers must never see a partially written report. */
+    (void) xasprintf(&tmp_path, "%s.%ld", report.path, (long) report.owner);
+    if ( (f = fopen(tmp_path, "w")) ) {
+        fprintf(f, "{\n");
+        fprintf(f, "  \"pid\": %ld,\n", (long) report.owner);
+        fprintf(f, "  \"start_time\": %lld,\n", (long long) report.start_time);
+        fprintf(f, "  \"duration_ms\": %llu,\n",
+                (unsigned long long) get_session_time());
+        fprintf(f, "  \"cpu_time_ms\": %lld,\n", cpu_time);
+        fprintf(f, "  \"peak_rss_kb\": %lld", peak_rss);
+        for ( i = 0; i < report.count; i++ )
+            fprintf(f, ",\n  \"%s\": %lld", report.values[i].key, report.values[i].value);
+        fprintf(f, "\n}\n");
+
+        if ( fclose(f) != 0 || rename(tmp_path, report.path) != 0 ) {
+            warn("Cannot write session report %s", report.path);
+            (void) unlink(tmp_path);
+        }
+    }
+    else
+        warn("Cannot write session report %s", report.path);
+
+    pthread_mutex_unlock(&report.lock);
+    free(tmp_path);
+}
+
+/**
+ * Add a value to the session report. This function is thread-safe.
+ *
+ * @param key   The name of the value in the report.
+ * @param value The value; it replaces any previous value with the same
+ *              name.
+ */
+void
+add_report_value(const char *key, long long value)
+{
+    size_t i;
+
+    if ( ! report.path )
+        return;
+
+    pthread_mutex_lock(&report.lock);
+    for ( i = 0; i < report.count; i++ )
+        if ( strcmp(report.values[i].key, key) == 0 )
+            break;
+
+    if ( i < report.count )
+        report.values[i].value = value;
+    else if ( i < MAX_REPORT_VALUES ) {
+        report.values[i].key = xstrdup(key);
+        report.values[i].value = value;
+        report.count += 1;
+    }
+    pthread_mutex_unlock(&report.lock);
+}
+
+#endif
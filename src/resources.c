@@ -0,0 +1,260 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "resources.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <err.h>
+
+#include <xmem.h>
+
+#include "util.h"
+
+#if !defined(PROTEGE_WIN32)
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#if defined(PROTEGE_LINUX)
+#include <sched.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+/* Not exposed by the C library. */
+#define IOPRIO_WHO_PROCESS      1
+#define IOPRIO_CLASS_SHIFT      13
+#endif
+
+
+/**
+ * Initialize a resource settings structure, with all settings unset.
+ *
+ * @param settings The structure to initialize.
+ */
+void
+init_resource_settings(struct resource_settings *settings)
+{
+    settings->cpu_set = NULL;
+    settings->nice = RESOURCE_UNSET;
+    settings->io_class = RESOURCE_UNSET;
+    settings->io_level = 0;
+    settings->oom_score_adj = RESOURCE_UNSET;
+    settings->max_open_files = RESOURCE_UNSET;
+    settings->max_locked_memory = RESOURCE_UNSET;
+}
+
+/**
+ * Set the I/O priority from a configuration value. The value is the
+ * name of a scheduling class ("realtime", "best-effort", or "idle"),
+ * optionally followed by a colon and a priority level within the class
+ * (from 0, highest, to 7, lowest).
+ *
+ * @param settings The settings to update.
+ * @param value    The configuration value.
+ *
+ * @return 0 if successful, or -1 if the value is invalid.
+ */
+int
+set_io_priority_setting(struct resource_settings *settings, const char *value)
+{
+    const char *level;
+    size_t len;
+    int io_class, io_level = 4;
+
+    len = (level = strchr(value, ':')) ? (size_t)(level - value) : strlen(value);
+
+    if ( len == 8 && strncmp(value, "realtime", len) == 0 )
+        io_class = RESOURCE_IO_CLASS_RT;
+    else if ( len == 11 && strncmp(value, "best-effort", len) == 0 )
+        io_class = RESOURCE_IO_CLASS_BE;
+    else if ( len == 4 && strncmp(value, "idle", len) == 0 )
+        io_class = RESOURCE_IO_CLASS_IDLE;
+    else
+        return -1;
+
+    if ( level && sscanf(level + 1, "%d", &io_level) != 1 )
+        return -1;
+
+    if ( io_level < 0 || io_level > 7 )
+        return -1;
+
+    settings->io_class = io_class;
+    settings->io_level = io_class == RESOURCE_IO_CLASS_IDLE ? 0 : io_level;
+
+    return 0;
+}
+
+/**
+ * Get the number of CPUs the launcher will be allowed to run on once
+ * the resource settings have been applied. This is the intersection of
+ * the configured CPU set with the CPUs we are currently allowed to run
+ * on (which may already have been restricted by our parent).
+ *
+ * @param settings The resource settings.
+ *
+ * @return The number of CPUs, or 0 if no CPU set has been configured
+ *         or if it could not be determined.
+ */
+int
+get_resource_cpu_count(struct resource_settings *settings)
+{
+    int count = 0;
+
+#if defined(PROTEGE_LINUX)
+    cpu_set_t wanted, current, result;
+
+    if ( settings->cpu_set && parse_cpu_list(settings->cpu_set, &wanted) == 0
+            && sched_getaffinity(0, sizeof(current), &current) == 0 ) {
+        CPU_AND(&result, &wanted, &current);
+        count = CPU_COUNT(&result);
+    }
+#endif
+
+    return count;
+}
+
+#if !defined(PROTEGE_WIN32)
+/*
+ * Set both the soft and hard values of a resource limit. If we cannot
+ * raise the hard limit, we try to set the soft limit alone as close as
+ * possible to the desired value.
+ */
+static void
+set_resource_limit(int resource, const char *name, long long value)
+{
+    struct rlimit limit;
+    rlim_t wanted;
+
+    wanted = value == -1 ? RLIM_INFINITY : (rlim_t) value;
+    if ( getrlimit(resource, &limit) == -1 ) {
+        warn("Cannot get %s limit", name);
+        return;
+    }
+
+    if ( limit.rlim_max != RLIM_INFINITY
+            && (wanted == RLIM_INFINITY || wanted > limit.rlim_max) ) {
+        struct rlimit raised = { wanted, wanted };
+
+        if ( setrlimit(resource, &raised) == 0 )
+            return;
+
+        warnx("Cannot raise %s limit above %llu", name,
+              (unsigned long long) limit.rlim_max);
+        wanted = limit.rlim_max;
+    }
+
+    limit.rlim_cur = wanted;
+    if ( setrlimit(resource, &limit) == -1 )
+        warn("Cannot set %s limit", name);
+}
+#endif
+
+/**
+ * Apply the resource settings to the current process. This must be
+ * called from the main thread before any other thread is started, so
+ * that all the threads of the Java virtual machine inherit the
+ * settings.
+ *
+ * Failing to apply a setting is not fatal: a warning is printed, and
+ * we carry on with the remaining settings.
+ *
+ * @param settings The resource settings to apply.
+ */
+void
+apply_resource_settings(struct resource_settings *settings)
+{
+#if defined(PROTEGE_LINUX)
+    if ( settings->cpu_set ) {
+        cpu_set_t wanted, current;
+
+        if ( parse_cpu_list(settings->cpu_set, &wanted) == -1 )
+            warnx("Invalid CPU set: %s", settings->cpu_set);
+        else {
+            /* Never extend the set of CPUs we were given. */
+            if ( sched_getaffinity(0, sizeof(current), &current) == 0 )
+                CPU_AND(&wanted, &wanted, &current);
+
+            if ( CPU_COUNT(&wanted) == 0 )
+                warnx("No allowed CPU in CPU set: %s", settings->cpu_set);
+            else if ( sched_setaffinity(0, sizeof(wanted), &wanted) == -1 )
+                warn("Cannot set CPU affinity");
+        }
+    }
+
+    if ( settings->io_class != RESOURCE_UNSET ) {
+        if ( syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                     settings->io_class << IOPRIO_CLASS_SHIFT | settings->io_level) == -1 )
+            warn("Cannot set I/O priority");
+    }
+
+    if ( settings->oom_score_adj != RESOURCE_UNSET ) {
+        FILE *f;
+
+        if ( ! (f = fopen("/proc/self/oom_score_adj", "w")) )
+            warn("Cannot set OOM score adjustment");
+        else {
+            fprintf(f, "%d\n", settings->oom_score_adj);
+            if ( fclose(f) == EOF )
+                warn("Cannot set OOM score adjustment");
+        }
+    }
+#endif
+
+#if !defined(PROTEGE_WIN32)
+    if ( settings->nice != RESOURCE_UNSET ) {
+        if ( setpriority(PRIO_PROCESS, 0, settings->nice) == -1 )
+            warn("Cannot set nice level");
+    }
+
+    if ( settings->max_open_files != RESOURCE_UNSET )
+        set_resource_limit(RLIMIT_NOFILE, "open files", settings->max_open_files);
+
+    if ( settings->max_locked_memory != RESOURCE_UNSET )
+        set_resource_limit(RLIMIT_MEMLOCK, "locked memory", settings->max_locked_memory);
+#endif
+}
+
+/**
+ * Free the resource settings.
+ *
+ * @param settings The settings to free.
+ */
+void
+free_resource_settings(struct resource_settings *settings)
+{
+    if ( settings->cpu_set )
+        free(settings->cpu_set);
+    settings->cpu_set = NULL;
+}
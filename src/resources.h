@@ -0,0 +1,81 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_RESOURCES_H
+#define ICP20261018_RESOURCES_H
+
+/*
+ * Special value for settings that have not been explicitly set.
+ */
+#define RESOURCE_UNSET          -99999
+
+#define RESOURCE_IO_CLASS_RT    1
+#define RESOURCE_IO_CLASS_BE    2
+#define RESOURCE_IO_CLASS_IDLE  3
+
+/*
+ * Hold the process resource settings from the configuration file.
+ */
+struct resource_settings {
+    char       *cpu_set;            /* List of allowed CPUs. */
+    int         nice;               /* Nice level. */
+    int         io_class;           /* I/O scheduling class. */
+    int         io_level;           /* I/O priority within the class. */
+    int         oom_score_adj;      /* Adjustment to the OOM score. */
+    long long   max_open_files;     /* Limit on open file descriptors;
+                                       -1 for no limit. */
+    long long   max_locked_memory;  /* Limit on locked memory (bytes);
+                                       -1 for no limit. */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void
+init_resource_settings(struct resource_settings *settings);
+
+int
+set_io_priority_setting(struct resource_settings *settings, const char *value);
+
+int
+get_resource_cpu_count(struct resource_settings *settings);
+
+void
+apply_resource_settings(struct resource_settings *settings);
+
+void
+free_resource_settings(struct resource_settings *settings);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_RESOURCES_H */
@@ -0,0 +1,317 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "scratch.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <err.h>
+#include <dirent.h>
+#include <ftw.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+
+#if defined(PROTEGE_LINUX)
+#include <sys/vfs.h>
+#include <linux/magic.h>
+#endif
+
+#include <xmem.h>
+
+#include "util.h"
+
+/* Maximal number of candidate directories. */
+#define MAX_CANDIDATES      5
+
+/* Memory kept for what Java uses outside of the heap (metaspace, code
+ * cache, thread stacks), for the system, and for other processes. */
+#define NON_HEAP_HEADROOM   ((size_t) 1024 * 1024 * 1024)
+
+/*
+ * A directory where the scratch directory could be created.
+ */
+struct candidate {
+    const char         *path;
+    unsigned long long  available;  /* Free space, in bytes. */
+    int                 ram_backed; /* Whether the filesystem lives in
+                                       memory (tmpfs or ramfs). */
+};
+
+/*
+ * The scratch directory of the current session.
+ */
+static struct {
+    pid_t   owner;      /* Process that created the directory. */
+    char   *path;
+} scratch;
+
+/*
+ * Fill the list of directories where the scratch directory could be
+ * created, in order of preference. Some items may be NULL.
+ */
+static void
+get_candidate_paths(const char *preferred, const char *paths[MAX_CANDIDATES])
+{
+    paths[0] = preferred;
+    paths[1] = getenv("XDG_RUNTIME_DIR");
+    paths[2] = "/dev/shm";
+    paths[3] = "/var/tmp";
+    paths[4] = "/tmp";
+}
+
+/*
+ * Check whether a directory could host the scratch directory, and get
+ * the free space and type of its filesystem.
+ *
+ * Returns 0 if the directory is usable, otherwise -1.
+ */
+static int
+check_candidate(const char *path, struct candidate *candidate)
+{
+    struct statvfs vfs;
+#if defined(PROTEGE_LINUX)
+    struct statfs fs;
+#endif
+
+    if ( ! path || path[0] != '/' || access(path, W_OK | X_OK) == -1 )
+        return -1;
+
+    if ( statvfs(path, &vfs) == -1 || vfs.f_flag & ST_RDONLY )
+        return -1;
+
+    candidate->path = path;
+    candidate->available = (unsigned long long) vfs.f_bavail * vfs.f_frsize;
+    candidate->ram_backed = 0;
+
+#if defined(PROTEGE_LINUX)
+    if ( statfs(path, &fs) == 0
+            && (fs.f_type == TMPFS_MAGIC || fs.f_type == RAMFS_MAGIC) )
+        candidate->ram_backed = 1;
+#endif
+
+    return 0;
+}
+
+/*
+ * Check whether a candidate directory has room for the temporary files
+ * of a session. Java programs typically spill to disk what they cannot
+ * keep in the heap, so we expect up to one heap's worth of files.
+ */
+static int
+has_room(const struct candidate *candidate, size_t heap_size)
+{
+    return candidate->available >= heap_size;
+}
+
+/*
+ * Check whether the temporary files of a session can be kept in memory.
+ * On a memory-backed filesystem, those files compete with the heap and
+ * everything else for physical memory, so they must fit in what is
+ * actually available once the heap and the rest of Java have been
+ * accounted for.
+ */
+static int
+fits_in_memory(size_t heap_size)
+{
+    size_t avail_mem;
+
+    if ( (avail_mem = get_available_memory()) < heap_size + NON_HEAP_HEADROOM )
+        return 0;
+
+    return avail_mem - heap_size - NON_HEAP_HEADROOM >= heap_size;
+}
+
+/*
+ * Pick the directory where to create the scratch directory. A directory
+ * explicitly configured by the user is always preferred if it is large
+ * enough; otherwise memory-backed filesystems are preferred over disks,
+ * but only if enough memory is available.
+ *
+ * Returns the selected directory, or NULL if no candidate is suitable.
+ */
+static const char *
+select_base_directory(const char *preferred, size_t heap_size)
+{
+    struct candidate candidates[MAX_CANDIDATES];
+    const char *paths[MAX_CANDIDATES];
+    size_t n, count = 0;
+
+    get_candidate_paths(preferred, paths);
+
+    for ( n = 0; n < MAX_CANDIDATES; n++ )
+        if ( check_candidate(paths[n], &candidates[count]) == 0 )
+            count += 1;
+
+    if ( preferred && count > 0 && candidates[0].path == preferred
+            && has_room(&candidates[0], heap_size) )
+        return preferred;
+
+    if ( fits_in_memory(heap_size) )
+        for ( n = 0; n < count; n++ )
+            if ( candidates[n].ram_backed && has_room(&candidates[n], heap_size) )
+                return candidates[n].path;
+
+    for ( n = 0; n < count; n++ )
+        if ( ! candidates[n].ram_backed && has_room(&candidates[n], heap_size) )
+            return candidates[n].path;
+
+    return NULL;
+}
+
+/* Callback for nftw, to remove every file in the scratch directory. */
+static int
+remove_file(const char *path, const struct stat *sb, int type, struct FTW *ftw)
+{
+    (void) sb;
+    (void) type;
+    (void) ftw;
+
+    if ( remove(path) == -1 )
+        warn("Cannot remove %s", path);
+
+    return 0;
+}
+
+/*
+ * Remove the scratch directories left over in a directory by sessions
+ * that did not exit cleanly (e.g., killed or crashed), that is, the
+ * directories belonging to the current user and named after a process
+ * that no longer exists.
+ */
+static void
+remove_stale_directories(const char *base)
+{
+    DIR *d;
+    struct dirent *entry;
+    struct stat st;
+    char *path;
+    long pid;
+    int len;
+
+    if ( ! (d = opendir(base)) )
+        return;
+
+    while ( (entry = readdir(d)) ) {
+        len = 0;
+        if ( sscanf(entry->d_name, "protege-%ld-%n", &pid, &len) != 1 || len == 0
+                || strlen(entry->d_name + len) != 6 || pid <= 0 )
+            continue;
+
+        if ( kill(pid, 0) == 0 || errno != ESRCH )
+            continue;
+
+        path = NULL;
+        (void) xasprintf(&path, "%s/%s", base, entry->d_name);
+        if ( lstat(path, &st) == 0 && S_ISDIR(st.st_mode) && st.st_uid == getuid() )
+            (void) nftw(path, remove_file, 16, FTW_DEPTH | FTW_PHYS);
+        free(path);
+    }
+
+    closedir(d);
+}
+
+/**
+ * Create a private directory for the temporary files of the current
+ * session, on the fastest filesystem that has room for them. Candidate
+ * locations are the preferred directory, $XDG_RUNTIME_DIR, /dev/shm,
+ * /var/tmp, and /tmp. The directory is automatically removed when the
+ * launcher exits; directories left over in those locations by previous
+ * sessions that did not exit cleanly are removed first.
+ *
+ * @param preferred A directory configured by the user, or NULL.
+ * @param heap_size The maximal heap size of the virtual machine, in
+ *                  bytes (0 if unknown).
+ *
+ * @return The pathname of the new directory (the caller must not free
+ *         it), or NULL if no suitable location has been found.
+ */
+const char *
+create_scratch_directory(const char *preferred, size_t heap_size)
+{
+    const char *base, *paths[MAX_CANDIDATES];
+    char *path = NULL;
+    size_t n;
+
+    if ( scratch.path )
+        return scratch.path;
+
+    get_candidate_paths(preferred, paths);
+    for ( n = 0; n < MAX_CANDIDATES; n++ )
+        if ( paths[n] && paths[n][0] == '/' )
+            remove_stale_directories(paths[n]);
+
+    /* The JVM defaults to a quarter of the physical memory. */
+    if ( heap_size == 0 )
+        heap_size = get_physical_memory() / 4;
+
+    if ( ! (base = select_base_directory(preferred, heap_size)) )
+        return NULL;
+
+    (void) xasprintf(&path, "%s/protege-%ld-XXXXXX", base, (long) getpid());
+    if ( ! mkdtemp(path) ) {
+        warn("Cannot create temporary directory in %s", base);
+        free(path);
+        return NULL;
+    }
+
+    scratch.owner = getpid();
+    scratch.path = path;
+    add_exit_handler(remove_scratch_directory);
+
+    return scratch.path;
+}
+
+/**
+ * Remove the scratch directory and everything it contains. This does
+ * nothing if called from another process than the one which created
+ * the directory.
+ */
+void
+remove_scratch_directory(void)
+{
+    if ( ! scratch.path || getpid() != scratch.owner )
+        return;
+
+    (void) nftw(scratch.path, remove_file, 16, FTW_DEPTH | FTW_PHYS);
+
+    free(scratch.path);
+    scratch.path = NULL;
+}
+
+#endif
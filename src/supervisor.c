@@ -0,0 +1,340 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "supervisor.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <err.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "util.h"
+#include "heapdump.h"
+
+/* Factor by which the heap is grown after an OutOfMemoryError. */
+#define HEAP_GROWTH_FACTOR  1.5
+
+/* Longest of the messages below. */
+#define MAX_MESSAGE_LENGTH      32
+
+/* Largest number of successive restarts with the same heap, after
+ * Java ran out of something else than heap. */
+#define MAX_SAME_HEAP_RESTARTS  3
+
+/*
+ * Messages printed by Java (with -XX:+ExitOnOutOfMemoryError) when the
+ * heap is exhausted, as opposed to the metaspace, direct buffers, or
+ * native threads.
+ */
+static const char *heap_exhausted_messages[] = {
+    "Java heap space",
+    "GC overhead limit exceeded",
+    NULL
+};
+
+static volatile sig_atomic_t child_pid = 0;
+
+/*
+ * Forward a termination signal to the supervised process.
+ */
+static void
+forward_signal(int sig)
+{
+    if ( child_pid > 0 )
+        (void) kill(child_pid, sig);
+}
+
+/*
+ * Install the signal handlers of the supervisor. Signals that are
+ * typically sent to a single process are forwarded to the supervised
+ * process; SIGINT is ignored, since when it comes from the terminal it
+ * is sent to the supervised process as well.
+ */
+static void
+set_signal_handlers(void)
+{
+    struct sigaction sa;
+
+    sa.sa_handler = forward_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    (void) sigaction(SIGTERM, &sa, NULL);
+    (void) sigaction(SIGHUP, &sa, NULL);
+
+    sa.sa_handler = SIG_IGN;
+    (void) sigaction(SIGINT, &sa, NULL);
+}
+
+/*
+ * Restore the default signal handlers in the supervised process.
+ */
+static void
+reset_signal_handlers(void)
+{
+    struct sigaction sa;
+
+    sa.sa_handler = SIG_DFL;
+    sa.sa_flags = 0;
+    sigemptyset(&sa.sa_mask);
+    (void) sigaction(SIGTERM, &sa, NULL);
+    (void) sigaction(SIGHUP, &sa, NULL);
+    (void) sigaction(SIGINT, &sa, NULL);
+}
+
+/*
+ * Get the heap size the Java virtual machine will use, in bytes.
+ */
+static size_t
+get_heap_size(struct option_list *list)
+{
+    size_t heap_size;
+
+    /* Without -Xmx, the JVM uses a quarter of the physical memory. */
+    if ( (heap_size = get_max_heap_size(list)) == 0 )
+        heap_size = get_physical_memory() / 4;
+
+    return heap_size;
+}
+
+/*
+ * Copy what is available on the error output of the supervised process
+ * to our own error output, looking for the messages Java prints when
+ * the heap is exhausted (Java is told to print them on its error output
+ * rather than on its standard output). The last bytes read are kept at
+ * the start of the buffer, so that a message split between two reads
+ * is found.
+ *
+ * Returns 0 at the end of the output, otherwise 1.
+ */
+static int
+relay_child_output(int fd, char *buffer, size_t len, size_t *kept, int *heap_exhausted)
+{
+    ssize_t n;
+    size_t keep = MAX_MESSAGE_LENGTH, i;
+
+    while ( (n = read(fd, buffer + *kept, len - *kept - 1)) > 0 ) {
+        (void) write(STDERR_FILENO, buffer + *kept, n);
+
+        buffer[*kept + n] = '\0';
+        for ( i = 0; heap_exhausted_messages[i]; i++ )
+            if ( strstr(buffer, heap_exhausted_messages[i]) )
+                *heap_exhausted = 1;
+
+        *kept += n;
+        if ( *kept > keep ) {
+            memmove(buffer, buffer + *kept - keep, keep);
+            *kept = keep;
+        }
+    }
+
+    return n == 0 ? 0 : 1;
+}
+
+/*
+ * Wait for the supervised process to terminate, relaying its error
+ * output in the meantime.
+ *
+ * Returns the exit code of the supervised process; if the process was
+ * killed by a signal, returns 128 plus the signal number, as shells do.
+ * Sets *heap_exhausted if Java reported that it ran out of heap.
+ */
+static int
+wait_for_child(pid_t pid, int fd, int *heap_exhausted)
+{
+    struct pollfd pfd;
+    char buffer[4096];
+    size_t kept = 0;
+    pid_t ret;
+    int status;
+
+    *heap_exhausted = 0;
+    (void) fcntl(fd, F_SETFL, O_NONBLOCK);
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+
+    /* Processes started by Java may keep the output open after it has
+     * exited, so we cannot just read until the end of the output. */
+    while ( (ret = waitpid(pid, &status, WNOHANG)) != pid ) {
+        if ( ret == -1 && errno != EINTR )
+            err(EXIT_FAILURE, "Cannot wait for Java process");
+
+        if ( pfd.fd != -1
+                && relay_child_output(fd, buffer, sizeof(buffer), &kept, heap_exhausted) == 0 )
+            pfd.fd = -1;    /* Let poll() merely wait. */
+
+        (void) poll(&pfd, 1, 200);
+    }
+    child_pid = 0;
+
+    if ( pfd.fd != -1 )
+        (void) relay_child_output(fd, buffer, sizeof(buffer), &kept, heap_exhausted);
+    close(fd);
+
+    if ( WIFSIGNALED(status) )
+        return 128 + WTERMSIG(status);
+
+    return WEXITSTATUS(status);
+}
+
+/**
+ * Supervise the execution of Protégé. This function forks, and only
+ * ever returns in the child process, which should then proceed with
+ * starting the Java virtual machine as usual. The parent waits for the
+ * child to terminate and relaunches it as needed:
+ *
+ * - if the Java virtual machine ran out of heap, it is relaunched
+ *   with a larger heap, up to the maximal heap size allowed for the
+ *   supervisor (by default, 80% of the physical memory);
+ * - if it ran out of another kind of memory (metaspace, direct
+ *   buffers, native threads), it is relaunched with the same heap, a
+ *   few times at most;
+ * - if Protégé requested to be restarted (by exiting with the restart
+ *   exit code), it is relaunched after reloading the options, so that
+ *   any change made to the configuration takes effect.
+ *
+ * Otherwise, the parent exits with the exit code of the child.
+ *
+ * @param app_dir The directory where Protégé is installed.
+ * @param list    The list of options; it will be reloaded if a restart
+ *                is requested.
+ */
+void
+run_supervisor(const char *app_dir, struct option_list *list)
+{
+    pid_t pid;
+    int code, fds[2], heap_exhausted, same_heap_restarts = 0;
+    size_t heap_size = 0, max_heap_size, new_heap_size;
+
+    set_signal_handlers();
+
+    while ( 1 ) {
+        /* The error output of the supervised process goes through us,
+         * to tell why Java ran out of memory. */
+        if ( pipe2(fds, O_CLOEXEC) == -1 )
+            err(EXIT_FAILURE, "Cannot create pipe");
+
+        if ( (pid = fork()) == -1 )
+            err(EXIT_FAILURE, "Cannot fork");
+
+        if ( pid == 0 ) {
+            reset_signal_handlers();
+            if ( dup2(fds[1], STDERR_FILENO) == -1 )
+                err(EXIT_FAILURE, "Cannot redirect error output");
+            close(fds[0]);
+            close(fds[1]);
+            (void) setenv(SUPERVISOR_ENV, "1", 1);
+
+            if ( heap_size )
+                set_max_heap_size(list, heap_size);
+
+            return;
+        }
+
+        child_pid = pid;
+        close(fds[1]);
+
+        /* Deal with heap dumps left by previous runs while the new
+         * run is starting. */
+        if ( list->heap_dump_dir )
+            start_heap_dump_manager(list->heap_dump_dir, list->heap_dump_count,
+                                    list->heap_dump_quota);
+
+        code = wait_for_child(pid, fds[0], &heap_exhausted);
+
+        if ( code == SUPERVISOR_OOM_CODE && ! heap_exhausted ) {
+            /* A larger heap would not help, and would leave less
+             * memory for what actually ran out. */
+            if ( ++same_heap_restarts > MAX_SAME_HEAP_RESTARTS )
+                errx(EXIT_FAILURE, "Java ran out of memory (not heap) %d times in a row, "
+                     "giving up", MAX_SAME_HEAP_RESTARTS + 1);
+
+            warnx("Java ran out of memory (not heap), restarting with the same heap");
+        }
+        else if ( code == SUPERVISOR_OOM_CODE ) {
+            char *dump = NULL;
+
+            same_heap_restarts = 0;
+
+            if ( ! heap_size )
+                heap_size = get_heap_size(list);
+
+            max_heap_size = list->supervisor_max_heap;
+            if ( max_heap_size == 0 )
+                max_heap_size = get_physical_memory() * .8;
+
+            new_heap_size = heap_size * HEAP_GROWTH_FACTOR;
+            if ( new_heap_size > max_heap_size )
+                new_heap_size = max_heap_size;
+
+            /* Round up to the next megabyte. */
+            new_heap_size = (new_heap_size + 1024 * 1024 - 1) & ~((size_t)1024 * 1024 - 1);
+
+            if ( list->heap_dump_dir )
+                dump = get_heap_dump(list->heap_dump_dir, pid);
+
+            if ( new_heap_size <= heap_size )
+                errx(EXIT_FAILURE, "Java ran out of memory with the largest "
+                     "allowed heap size (%zuM)%s%s", heap_size / (1024 * 1024),
+                     dump ? ", heap dump written to " : "", dump ? dump : "");
+
+            if ( dump ) {
+                warnx("Java ran out of memory (heap dump written to %s), "
+                      "restarting with a %zuM heap", dump, new_heap_size / (1024 * 1024));
+                free(dump);
+            }
+            else
+                warnx("Java ran out of memory, restarting with a %zuM heap",
+                      new_heap_size / (1024 * 1024));
+            heap_size = new_heap_size;
+        }
+        else if ( code == list->supervisor_restart_code ) {
+            same_heap_restarts = 0;
+            free_option_list(list);
+            get_option_list(app_dir, list);
+            heap_size = 0;
+        }
+        else
+            exit(code);
+    }
+}
+
+#endif /* !PROTEGE_LINUX */
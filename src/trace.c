@@ -0,0 +1,1001 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "trace.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <err.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <jvmti.h>
+
+#include <xmem.h>
+
+#include "java.h"
+#include "util.h"
+
+#define BYTE_ORDER_MARK     0x01020304
+
+/* Longest name written in a record; longer names are truncated. */
+#define MAX_NAME_LEN        400
+
+#define NANOSECONDS         1000000000LL
+
+/*
+ * State of the trace.
+ */
+static struct {
+    jvmtiEnv       *jvmti;
+    pthread_mutex_t lock;
+    FILE           *out;        /* NULL once the trace is complete. */
+    char           *path;
+    pid_t           owner;
+    struct timespec start;
+    unsigned        duration;   /* In seconds. */
+    uint32_t        next_loader;
+    uint32_t        next_thread;
+} trace = { NULL, PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, { 0, 0 }, 0, 0, 0 };
+
+/* Identifier of the calling thread in the trace. */
+static __thread uint32_t thread_id;
+
+/*
+ * A record being prepared.
+ */
+struct record {
+    unsigned char   data[MAX_NAME_LEN + 64];
+    size_t          len;
+};
+
+/*
+ * The events recorded, and the capability each of them requires (the
+ * events without a matching member in jvmtiCapabilities are always
+ * available).
+ */
+static const jvmtiEvent trace_events[] = {
+    JVMTI_EVENT_CLASS_FILE_LOAD_HOOK,
+    JVMTI_EVENT_CLASS_LOAD,
+    JVMTI_EVENT_CLASS_PREPARE,
+    JVMTI_EVENT_COMPILED_METHOD_LOAD,
+    JVMTI_EVENT_GARBAGE_COLLECTION_START,
+    JVMTI_EVENT_GARBAGE_COLLECTION_FINISH
+};
+
+#define N_TRACE_EVENTS  (sizeof(trace_events) / sizeof(trace_events[0]))
+
+#define HASH_BASIS          0x811c9dc5
+
+static uint32_t
+hash_update(uint32_t hash, const char *s)
+{
+    while ( *s ) {
+        hash ^= (unsigned char) *s++;
+        hash *= 0x01000193;
+    }
+
+    return hash;
+}
+
+static uint32_t
+hash_string(const char *s)
+{
+    return hash_update(HASH_BASIS, s);
+}
+
+static void
+put_bytes(struct record *record, const void *data, size_t len)
+{
+    if ( record->len + len <= sizeof(record->data) ) {
+        memcpy(record->data + record->len, data, len);
+        record->len += len;
+    }
+}
+
+static void
+put_u32(struct record *record, uint32_t value)
+{
+    put_bytes(record, &value, sizeof(value));
+}
+
+static void
+put_string(struct record *record, const char *s)
+{
+    uint16_t len = strlen(s) > MAX_NAME_LEN ? MAX_NAME_LEN : strlen(s);
+
+    put_bytes(record, &len, sizeof(len));
+    put_bytes(record, s, len);
+}
+
+/*
+ * Start a new record of the specified type, timestamped now.
+ */
+static void
+begin_record(struct record *record, unsigned char type)
+{
+    struct timespec now;
+    uint64_t timestamp;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    timestamp = (now.tv_sec - trace.start.tv_sec) * NANOSECONDS
+        + (now.tv_nsec - trace.start.tv_nsec);
+
+    record->len = 0;
+    put_bytes(record, &type, 1);
+    put_bytes(record, &timestamp, sizeof(timestamp));
+}
+
+/*
+ * Append a complete record to the trace. Records are written in one
+ * go under the lock, so that they never interleave.
+ */
+static void
+commit_record(struct record *record)
+{
+    pthread_mutex_lock(&trace.lock);
+    if ( trace.out )
+        (void) fwrite(record->data, 1, record->len, trace.out);
+    pthread_mutex_unlock(&trace.lock);
+}
+
+/*
+ * Get the identifier of the calling thread, assigning a new one on the
+ * first call.
+ */
+static uint32_t
+get_thread_id(void)
+{
+    if ( thread_id == 0 )
+        thread_id = __atomic_add_fetch(&trace.next_thread, 1, __ATOMIC_RELAXED);
+
+    return thread_id;
+}
+
+/*
+ * Get a descriptive name for a class loader. For the class loaders of
+ * the Felix framework, this is the symbolic name of the bundle, found
+ * by walking the private fields of the framework (without running any
+ * Java code, which would not be safe while a class is being loaded);
+ * for other class loaders, this is the name of their class.
+ */
+static char *
+get_loader_name(jvmtiEnv *jvmti, JNIEnv *env, jobject loader)
+{
+    static const char *fields[][2] = {
+        { "m_wiring",       "Lorg/apache/felix/framework/BundleWiringImpl;" },
+        { "m_revision",     "Lorg/apache/felix/framework/BundleRevisionImpl;" },
+        { "m_symbolicName", "Ljava/lang/String;" }
+    };
+    jobject object = loader;
+    jfieldID field;
+    const char *value;
+    char *name = NULL, *signature;
+    size_t n;
+
+    if ( (*env)->PushLocalFrame(env, 16) != JNI_OK )
+        return NULL;
+
+    for ( n = 0; object && n < 3; n++ ) {
+        if ( (field = (*env)->GetFieldID(env, (*env)->GetObjectClass(env, object),
+                                         fields[n][0], fields[n][1])) )
+            object = (*env)->GetObjectField(env, object, field);
+        else
+            object = NULL;
+    }
+
+    if ( (*env)->ExceptionCheck(env) ) {
+        (*env)->ExceptionClear(env);
+        object = NULL;
+    }
+
+    if ( object && (value = (*env)->GetStringUTFChars(env, object, NULL)) ) {
+        name = xstrdup(value);
+        (*env)->ReleaseStringUTFChars(env, object, value);
+    }
+    else if ( (*jvmti)->GetClassSignature(jvmti, (*env)->GetObjectClass(env, loader),
+                                          &signature, NULL) == JVMTI_ERROR_NONE ) {
+        /* "Lcom/example/Loader;" -> "com.example.Loader" */
+        name = xstrdup(signature[0] == 'L' ? signature + 1 : signature);
+        for ( n = 0; name[n]; n++ )
+            if ( name[n] == '/' )
+                name[n] = '.';
+            else if ( name[n] == ';' )
+                name[n] = '\0';
+        (*jvmti)->Deallocate(jvmti, (unsigned char *) signature);
+    }
+
+    (void) (*env)->PopLocalFrame(env, NULL);
+
+    return name;
+}
+
+/*
+ * Get the identifier of a class loader. Class loaders are tagged with
+ * their identifier the first time they are seen, and their name is
+ * then written to the trace. The bootstrap class loader is 0.
+ */
+static uint32_t
+get_loader_id(jvmtiEnv *jvmti, JNIEnv *env, jobject loader)
+{
+    jlong tag = 0;
+    uint32_t id = 0;
+    struct record record;
+    char *name;
+
+    if ( ! loader )
+        return 0;
+
+    if ( (*jvmti)->GetTag(jvmti, loader, &tag) == JVMTI_ERROR_NONE && tag != 0 )
+        id = tag;
+    else {
+        id = __atomic_add_fetch(&trace.next_loader, 1, __ATOMIC_RELAXED);
+        (void) (*jvmti)->SetTag(jvmti, loader, id);
+
+        begin_record(&record, TRACE_LOADER);
+        put_u32(&record, id);
+        name = get_loader_name(jvmti, env, loader);
+        put_string(&record, name ? name : "?");
+        commit_record(&record);
+        free(name);
+    }
+
+    return id;
+}
+
+/*
+ * Record the loading or preparation of a class.
+ */
+static void
+record_class(jvmtiEnv *jvmti, JNIEnv *env, jclass klass, unsigned char type)
+{
+    struct record record;
+    char *signature;
+    jobject object;
+    uint32_t loader = 0;
+
+    if ( (*jvmti)->GetClassSignature(jvmti, klass, &signature, NULL) != JVMTI_ERROR_NONE )
+        return;
+
+    if ( (*jvmti)->GetClassLoader(jvmti, klass, &object) == JVMTI_ERROR_NONE && object ) {
+        loader = get_loader_id(jvmti, env, object);
+        (*env)->DeleteLocalRef(env, object);
+    }
+
+    begin_record(&record, type);
+    put_u32(&record, get_thread_id());
+    put_u32(&record, loader);
+    put_u32(&record, hash_string(signature));
+    if ( type == TRACE_CLASS_PREPARE )
+        put_string(&record, signature);
+    commit_record(&record);
+
+    (*jvmti)->Deallocate(jvmti, (unsigned char *) signature);
+}
+
+/*
+ * Record the start of the definition of a class, just before its
+ * bytes are parsed; the definition ends with the ClassLoad event.
+ */
+static void JNICALL
+on_class_file_load_hook(jvmtiEnv *jvmti, JNIEnv *env, jclass class_being_redefined,
+                        jobject loader, const char *name, jobject protection_domain,
+                        jint class_data_len, const unsigned char *class_data,
+                        jint *new_class_data_len, unsigned char **new_class_data)
+{
+    struct record record;
+    uint32_t loader_id;
+
+    (void) protection_domain;
+    (void) class_data_len;
+    (void) class_data;
+    (void) new_class_data_len;
+    (void) new_class_data;
+
+    if ( class_being_redefined || ! name )
+        return;
+
+    loader_id = get_loader_id(jvmti, env, loader);
+
+    begin_record(&record, TRACE_CLASS_DEFINE);
+    put_u32(&record, get_thread_id());
+    put_u32(&record, loader_id);
+    /* Same hash as the signature ("Lcom/example/Class;") of the class. */
+    put_u32(&record, hash_update(hash_update(hash_string("L"), name), ";"));
+    commit_record(&record);
+}
+
+static void JNICALL
+on_class_load(jvmtiEnv *jvmti, JNIEnv *env, jthread thread, jclass klass)
+{
+    (void) thread;
+
+    record_class(jvmti, env, klass, TRACE_CLASS_LOAD);
+}
+
+static void JNICALL
+on_class_prepare(jvmtiEnv *jvmti, JNIEnv *env, jthread thread, jclass klass)
+{
+    (void) thread;
+
+    record_class(jvmti, env, klass, TRACE_CLASS_PREPARE);
+}
+
+static void JNICALL
+on_compiled_method_load(jvmtiEnv *jvmti, jmethodID method, jint code_size,
+                        const void *code_addr, jint map_length,
+                        const jvmtiAddrLocationMap *map, const void *compile_info)
+{
+    struct record record;
+    jclass klass;
+    char *class_name = NULL, *method_name = NULL, *name = NULL;
+
+    (void) code_addr;
+    (void) map_length;
+    (void) map;
+    (void) compile_info;
+
+    if ( (*jvmti)->GetMethodName(jvmti, method, &method_name, NULL, NULL) != JVMTI_ERROR_NONE )
+        return;
+
+    if ( (*jvmti)->GetMethodDeclaringClass(jvmti, method, &klass) == JVMTI_ERROR_NONE )
+        (void) (*jvmti)->GetClassSignature(jvmti, klass, &class_name, NULL);
+
+    (void) xasprintf(&name, "%s%s", class_name ? class_name : "", method_name);
+
+    begin_record(&record, TRACE_COMPILED_METHOD);
+    put_u32(&record, code_size);
+    put_string(&record, name);
+    commit_record(&record);
+
+    free(name);
+    if ( class_name )
+        (*jvmti)->Deallocate(jvmti, (unsigned char *) class_name);
+    (*jvmti)->Deallocate(jvmti, (unsigned char *) method_name);
+}
+
+/*
+ * Garbage collection callbacks run with the world stopped, and must
+ * not call JNI or most JVMTI functions; writing a record is fine, as
+ * no Java thread can hold the lock while in the virtual machine.
+ */
+static void JNICALL
+on_gc_start(jvmtiEnv *jvmti)
+{
+    struct record record;
+
+    (void) jvmti;
+
+    begin_record(&record, TRACE_GC_START);
+    commit_record(&record);
+}
+
+static void JNICALL
+on_gc_finish(jvmtiEnv *jvmti)
+{
+    struct record record;
+
+    (void) jvmti;
+
+    begin_record(&record, TRACE_GC_FINISH);
+    commit_record(&record);
+}
+
+/*
+ * Complete the trace file. Called at the end of the traced period, or
+ * when the launcher exits, whichever comes first.
+ */
+static void
+finish_trace(void)
+{
+    struct record record;
+    int written = 0;
+
+    if ( getpid() != trace.owner )
+        return;
+
+    begin_record(&record, TRACE_END);
+
+    pthread_mutex_lock(&trace.lock);
+    if ( trace.out ) {
+        (void) fwrite(record.data, 1, record.len, trace.out);
+        written = fclose(trace.out) == 0;
+        trace.out = NULL;
+    }
+    pthread_mutex_unlock(&trace.lock);
+
+    if ( written )
+        warnx("Startup trace written to %s", trace.path);
+}
+
+/*
+ * Stop tracing at the end of the traced period, so that the rest of
+ * the session runs without any overhead.
+ */
+static void *
+timer_main(void *arg)
+{
+    size_t n;
+
+    (void) arg;
+
+    set_thread_name("protege-trace");
+
+    sleep(trace.duration);
+
+    for ( n = 0; n < N_TRACE_EVENTS; n++ )
+        (void) (*trace.jvmti)->SetEventNotificationMode(trace.jvmti, JVMTI_DISABLE,
+                                                        trace_events[n], NULL);
+    finish_trace();
+
+    return NULL;
+}
+
+/*
+ * Open the trace file in the log directory and write its header.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+open_trace(void)
+{
+    char *dir;
+    uint32_t bom = BYTE_ORDER_MARK;
+
+    if ( ! (dir = get_log_directory()) )
+        return -1;
+
+    (void) create_directory(dir);
+    (void) xasprintf(&trace.path, "%s/trace-%ld.bin", dir, (long) getpid());
+    free(dir);
+
+    if ( ! (trace.out = fopen(trace.path, "wb")) ) {
+        warn("Cannot create %s", trace.path);
+        return -1;
+    }
+
+    (void) fwrite(TRACE_MAGIC, 1, 8, trace.out);
+    (void) fwrite(&bom, sizeof(bom), 1, trace.out);
+
+    return 0;
+}
+
+/*
+ * Called once the virtual machine has been created: turns the launcher
+ * into a JVMTI agent, and enables the events.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    jvmtiCapabilities caps;
+    jvmtiEventCallbacks callbacks;
+    pthread_t thread;
+    pthread_attr_t attr;
+    size_t n;
+
+    (void) env;
+    (void) data;
+
+    if ( (*jvm)->GetEnv(jvm, (void **) &trace.jvmti, JVMTI_VERSION_1_2) != JNI_OK ) {
+        warnx("Cannot trace startup: JVMTI not available");
+        return;
+    }
+
+    memset(&caps, 0, sizeof(caps));
+    caps.can_tag_objects = 1;
+    if ( (*trace.jvmti)->AddCapabilities(trace.jvmti, &caps) != JVMTI_ERROR_NONE ) {
+        warnx("Cannot trace startup: cannot tag class loaders");
+        return;
+    }
+
+    /* Optional capabilities, events are simply not received if they
+     * cannot be obtained. */
+    memset(&caps, 0, sizeof(caps));
+    caps.can_generate_garbage_collection_events = 1;
+    (void) (*trace.jvmti)->AddCapabilities(trace.jvmti, &caps);
+    memset(&caps, 0, sizeof(caps));
+    caps.can_generate_compiled_method_load_events = 1;
+    (void) (*trace.jvmti)->AddCapabilities(trace.jvmti, &caps);
+
+    if ( open_trace() == -1 )
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &trace.start);
+    trace.owner = getpid();
+    add_exit_handler(finish_trace);
+
+    memset(&callbacks, 0, sizeof(callbacks));
+    callbacks.ClassFileLoadHook = on_class_file_load_hook;
+    callbacks.ClassLoad = on_class_load;
+    callbacks.ClassPrepare = on_class_prepare;
+    callbacks.CompiledMethodLoad = on_compiled_method_load;
+    callbacks.GarbageCollectionStart = on_gc_start;
+    callbacks.GarbageCollectionFinish = on_gc_finish;
+    (void) (*trace.jvmti)->SetEventCallbacks(trace.jvmti, &callbacks, sizeof(callbacks));
+
+    for ( n = 0; n < N_TRACE_EVENTS; n++ )
+        (void) (*trace.jvmti)->SetEventNotificationMode(trace.jvmti, JVMTI_ENABLE,
+                                                        trace_events[n], NULL);
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, timer_main, NULL) != 0 )
+        warn("Cannot start trace timer");
+    pthread_attr_destroy(&attr);
+}
+
+/**
+ * Record the class loading, compilation, and garbage collection
+ * activity of the virtual machine during the first seconds of the
+ * session, into a binary trace in the log directory. The launcher acts
+ * as a JVMTI agent from the moment the virtual machine is created, and
+ * stops receiving events at the end of the traced period.
+ *
+ * @param duration The duration of the trace, in seconds.
+ */
+void
+start_startup_trace(unsigned duration)
+{
+    trace.duration = duration;
+    add_java_callback(on_java_created, NULL);
+}
+
+/*
+ * Reading a trace.
+ */
+
+struct bundle_cost {
+    char       *name;
+    unsigned    classes;
+    uint64_t    exclusive;  /* Time spent defining its own classes. */
+    uint64_t    first;
+    uint64_t    last;
+};
+
+struct pending_define {
+    uint32_t    hash;
+    uint64_t    start;
+    uint64_t    nested;     /* Time spent defining other classes. */
+};
+
+struct thread_stack {
+    struct pending_define *defines;
+    size_t               depth;
+    size_t               size;
+};
+
+struct second_stats {
+    unsigned    classes;
+    unsigned    compiled;
+    unsigned    gcs;
+    uint64_t    gc_time;
+};
+
+struct trace_report {
+    struct bundle_cost  *bundles;
+    size_t               n_bundles;
+    size_t              *loaders;       /* Loader ID -> bundle index. */
+    size_t               n_loaders;
+    struct thread_stack *threads;
+    size_t               n_threads;
+    struct second_stats *seconds;
+    size_t               n_seconds;
+    uint64_t             gc_start;
+    unsigned             gcs;
+    uint64_t             gc_time;
+    uint64_t             gc_max;
+    unsigned             classes;
+    unsigned             compiled;
+    uint64_t             end;
+};
+
+/*
+ * Grow an array of elements of the specified size so that it contains
+ * at least the specified index, zeroing the new elements.
+ */
+static void *
+grow_array(void *array, size_t *count, size_t index, size_t size)
+{
+    size_t new_count;
+
+    if ( index < *count )
+        return array;
+
+    new_count = index + 1 > *count * 2 ? index + 1 : *count * 2;
+    array = xrealloc(array, new_count * size);
+    memset((char *) array + *count * size, 0, (new_count - *count) * size);
+    *count = new_count;
+
+    return array;
+}
+
+static size_t
+get_bundle(struct trace_report *report, const char *name)
+{
+    size_t n;
+
+    for ( n = 0; n < report->n_bundles; n++ )
+        if ( strcmp(report->bundles[n].name, name) == 0 )
+            return n;
+
+    report->bundles = xrealloc(report->bundles, (n + 1) * sizeof(struct bundle_cost));
+    memset(&report->bundles[n], 0, sizeof(struct bundle_cost));
+    report->bundles[n].name = xstrdup(name);
+    report->n_bundles += 1;
+
+    return n;
+}
+
+/*
+ * Get the bundle a class loader belongs to. Class loaders are grouped
+ * by name, so that the several class loaders a bundle may have over
+ * time (e.g. after a refresh) are counted together.
+ */
+static size_t
+get_loader_bundle(struct trace_report *report, uint32_t loader)
+{
+    char name[32];
+
+    report->loaders = grow_array(report->loaders, &report->n_loaders, loader, sizeof(size_t));
+    if ( report->loaders[loader] == 0 ) {
+        if ( loader == 0 )
+            report->loaders[loader] = get_bundle(report, "bootstrap") + 1;
+        else {
+            snprintf(name, sizeof(name), "loader #%lu", (unsigned long) loader);
+            report->loaders[loader] = get_bundle(report, name) + 1;
+        }
+    }
+
+    return report->loaders[loader] - 1;
+}
+
+static struct second_stats *
+get_second(struct trace_report *report, uint64_t timestamp)
+{
+    size_t second = timestamp / NANOSECONDS;
+
+    report->seconds = grow_array(report->seconds, &report->n_seconds, second,
+                                 sizeof(struct second_stats));
+
+    return &report->seconds[second];
+}
+
+static struct thread_stack *
+get_thread_stack(struct trace_report *report, uint32_t thread)
+{
+    report->threads = grow_array(report->threads, &report->n_threads, thread,
+                                 sizeof(struct thread_stack));
+
+    return &report->threads[thread];
+}
+
+/*
+ * Start the definition of a class. Definitions nest on a thread, as
+ * the superclass and interfaces of a class are loaded while it is
+ * being defined.
+ */
+static void
+define_class(struct trace_report *report, uint64_t timestamp, uint32_t thread, uint32_t hash)
+{
+    struct thread_stack *stack = get_thread_stack(report, thread);
+
+    if ( stack->depth == stack->size ) {
+        stack->size = stack->size ? stack->size * 2 : 16;
+        stack->defines = xrealloc(stack->defines,
+                                  stack->size * sizeof(struct pending_define));
+    }
+
+    stack->defines[stack->depth].hash = hash;
+    stack->defines[stack->depth].start = timestamp;
+    stack->defines[stack->depth].nested = 0;
+    stack->depth += 1;
+}
+
+/*
+ * Account for a loaded class. The time between the start of its
+ * definition and its loading, minus the time spent defining the
+ * classes it needed in the meantime on the same thread, is the time
+ * spent parsing and defining the class itself.
+ */
+static void
+load_class(struct trace_report *report, uint64_t timestamp, uint32_t thread,
+           uint32_t loader, uint32_t hash)
+{
+    struct thread_stack *stack = get_thread_stack(report, thread);
+    struct bundle_cost *bundle;
+    uint64_t elapsed;
+    size_t n;
+
+    for ( n = stack->depth; n > 0; n-- ) {
+        if ( stack->defines[n - 1].hash == hash ) {
+            /* Definitions left above that one never completed (e.g.
+             * failed with a ClassFormatError) and are discarded. */
+            stack->depth = n - 1;
+            elapsed = timestamp - stack->defines[n - 1].start;
+            n = get_loader_bundle(report, loader);
+            bundle = &report->bundles[n];
+            if ( elapsed > stack->defines[n - 1].nested )
+                bundle->exclusive += elapsed - stack->defines[n - 1].nested;
+            if ( stack->depth > 0 )
+                stack->defines[stack->depth - 1].nested += elapsed;
+            break;
+        }
+    }
+}
+
+/*
+ * Account for a prepared class, which is then ready to be used.
+ */
+static void
+prepare_class(struct trace_report *report, uint64_t timestamp, uint32_t loader)
+{
+    struct bundle_cost *bundle;
+    size_t n;
+
+    n = get_loader_bundle(report, loader);
+    bundle = &report->bundles[n];
+    if ( bundle->classes++ == 0 )
+        bundle->first = timestamp;
+    bundle->last = timestamp;
+
+    report->classes += 1;
+    get_second(report, timestamp)->classes += 1;
+}
+
+/*
+ * Read a string field of a record.
+ *
+ * Returns the position after the string, or NULL if the record is
+ * truncated.
+ */
+static const unsigned char *
+read_string(const unsigned char *p, const unsigned char *end, char *buffer)
+{
+    uint16_t len;
+
+    if ( end - p < 2 )
+        return NULL;
+    memcpy(&len, p, 2);
+    p += 2;
+
+    if ( len > MAX_NAME_LEN || end - p < len )
+        return NULL;
+    memcpy(buffer, p, len);
+    buffer[len] = '\0';
+
+    return p + len;
+}
+
+/*
+ * Process all the records of a trace.
+ *
+ * Returns 0 if successful, or -1 if the trace is invalid.
+ */
+static int
+read_records(struct trace_report *report, const unsigned char *p, const unsigned char *end)
+{
+    unsigned char type;
+    uint64_t timestamp;
+    uint32_t fields[3];
+    char name[MAX_NAME_LEN + 1];
+    struct second_stats *second;
+
+    while ( p < end ) {
+        if ( end - p < 9 )
+            return -1;
+        type = *p++;
+        memcpy(&timestamp, p, 8);
+        p += 8;
+        report->end = timestamp;
+
+        switch ( type ) {
+        case TRACE_LOADER:
+            if ( end - p < 4 )
+                return -1;
+            memcpy(fields, p, 4);
+            if ( ! (p = read_string(p + 4, end, name)) )
+                return -1;
+            report->loaders = grow_array(report->loaders, &report->n_loaders,
+                                         fields[0], sizeof(size_t));
+            report->loaders[fields[0]] = get_bundle(report, name) + 1;
+            break;
+
+        case TRACE_CLASS_DEFINE:
+        case TRACE_CLASS_LOAD:
+        case TRACE_CLASS_PREPARE:
+            if ( end - p < 12 )
+                return -1;
+            memcpy(fields, p, 12);
+            p += 12;
+            if ( type == TRACE_CLASS_DEFINE )
+                define_class(report, timestamp, fields[0], fields[2]);
+            else if ( type == TRACE_CLASS_LOAD )
+                load_class(report, timestamp, fields[0], fields[1], fields[2]);
+            else if ( ! (p = read_string(p, end, name)) )
+                return -1;
+            else
+                prepare_class(report, timestamp, fields[1]);
+            break;
+
+        case TRACE_GC_START:
+            report->gc_start = timestamp;
+            break;
+
+        case TRACE_GC_FINISH:
+            second = get_second(report, report->gc_start);
+            second->gcs += 1;
+            second->gc_time += timestamp - report->gc_start;
+            report->gcs += 1;
+            report->gc_time += timestamp - report->gc_start;
+            if ( timestamp - report->gc_start > report->gc_max )
+                report->gc_max = timestamp - report->gc_start;
+            break;
+
+        case TRACE_COMPILED_METHOD:
+            if ( end - p < 4 || ! (p = read_string(p + 4, end, name)) )
+                return -1;
+            report->compiled += 1;
+            get_second(report, timestamp)->compiled += 1;
+            break;
+
+        case TRACE_END:
+            return 0;
+
+        default:
+            return -1;
+        }
+    }
+
+    /* No end record, the session was probably killed during the trace;
+     * what was recorded until then is still usable. */
+    return 0;
+}
+
+static int
+compare_bundles(const void *a, const void *b)
+{
+    const struct bundle_cost *ba = a, *bb = b;
+
+    if ( ba->exclusive != bb->exclusive )
+        return ba->exclusive < bb->exclusive ? 1 : -1;
+    return strcmp(ba->name, bb->name);
+}
+
+#define MS(ns)  ((double) (ns) / 1000000.0)
+#define SEC(ns) ((double) (ns) / NANOSECONDS)
+
+static void
+print_report(struct trace_report *report)
+{
+    size_t n;
+    struct bundle_cost *bundle;
+
+    printf("Startup trace: %.1f s, %u classes, %u compiled methods, "
+           "%u collections (%.1f ms)\n\n", SEC(report->end), report->classes,
+           report->compiled, report->gcs, MS(report->gc_time));
+
+    printf("%6s %8s %9s %5s %8s\n", "TIME", "CLASSES", "COMPILED", "GCS", "GC(ms)");
+    for ( n = 0; n < report->n_seconds && n <= report->end / NANOSECONDS; n++ )
+        printf("%5lus %8u %9u %5u %8.1f\n", (unsigned long) n,
+               report->seconds[n].classes, report->seconds[n].compiled,
+               report->seconds[n].gcs, MS(report->seconds[n].gc_time));
+
+    qsort(report->bundles, report->n_bundles, sizeof(struct bundle_cost), compare_bundles);
+
+    printf("\n%8s %10s %8s %8s  %s\n", "CLASSES", "DEFINE(ms)", "FIRST(s)", "LAST(s)", "BUNDLE");
+    for ( n = 0; n < report->n_bundles; n++ ) {
+        bundle = &report->bundles[n];
+        if ( bundle->classes == 0 )
+            continue;
+        printf("%8u %10.1f %8.2f %8.2f  %s\n", bundle->classes, MS(bundle->exclusive),
+               SEC(bundle->first), SEC(bundle->last), bundle->name);
+    }
+
+    if ( report->gcs > 0 )
+        printf("\nGarbage collections: %u, %.1f ms in total, %.1f ms on average, "
+               "%.1f ms at most\n", report->gcs, MS(report->gc_time),
+               MS(report->gc_time) / report->gcs, MS(report->gc_max));
+}
+
+static void
+free_report(struct trace_report *report)
+{
+    size_t n;
+
+    for ( n = 0; n < report->n_bundles; n++ )
+        free(report->bundles[n].name);
+    for ( n = 0; n < report->n_threads; n++ )
+        free(report->threads[n].defines);
+    free(report->bundles);
+    free(report->loaders);
+    free(report->threads);
+    free(report->seconds);
+}
+
+/**
+ * Print a summary of a startup trace: a timeline of the activity of
+ * the virtual machine, second by second, and the time spent loading
+ * the classes of each bundle.
+ *
+ * @param path The trace file to read.
+ *
+ * @return The exit code for the launcher.
+ */
+int
+run_trace_report(const char *path)
+{
+    FILE *f;
+    struct stat st;
+    unsigned char *data;
+    uint32_t bom;
+    struct trace_report report;
+    int ret;
+
+    if ( ! path )
+        errx(EXIT_FAILURE, "Usage: protege --trace-report <file>");
+
+    if ( ! (f = fopen(path, "rb")) || fstat(fileno(f), &st) == -1 )
+        err(EXIT_FAILURE, "Cannot open %s", path);
+
+    data = xmalloc(st.st_size + 1);
+    if ( fread(data, 1, st.st_size, f) != (size_t) st.st_size )
+        err(EXIT_FAILURE, "Cannot read %s", path);
+    fclose(f);
+
+    if ( st.st_size < 12 || memcmp(data, TRACE_MAGIC, 8) != 0 )
+        errx(EXIT_FAILURE, "%s: Not a startup trace", path);
+
+    memcpy(&bom, data + 8, 4);
+    if ( bom != BYTE_ORDER_MARK )
+        errx(EXIT_FAILURE, "%s: Trace recorded on a machine with a different byte order", path);
+
+    memset(&report, 0, sizeof(report));
+    if ( (ret = read_records(&report, data + 12, data + st.st_size)) == -1 )
+        warnx("%s: Truncated or corrupted trace", path);
+
+    print_report(&report);
+
+    free_report(&report);
+    free(data);
+
+    return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+#endif
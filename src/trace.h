@@ -0,0 +1,71 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_TRACE_H
+#define ICP20261018_TRACE_H
+
+#define TRACE_MAGIC         "PROTTRC1"
+
+/*
+ * Types of the records of a startup trace. Each record starts with its
+ * type (one byte) and a timestamp (eight bytes, in nanoseconds since
+ * the start of the trace), followed by fields depending on the type.
+ * All integers are in the byte order of the machine that wrote the
+ * trace, as indicated by the byte order mark that follows the magic.
+ */
+enum trace_record_type {
+    TRACE_LOADER = 1,       /* u32 loader, u16 length, name */
+    TRACE_CLASS_LOAD,       /* u32 thread, u32 loader, u32 class hash */
+    TRACE_CLASS_PREPARE,    /* u32 thread, u32 loader, u32 class hash,
+                               u16 length, signature */
+    TRACE_GC_START,         /* no fields */
+    TRACE_GC_FINISH,        /* no fields */
+    TRACE_COMPILED_METHOD,  /* u32 code size, u16 length, name */
+    TRACE_END,              /* no fields */
+    TRACE_CLASS_DEFINE      /* u32 thread, u32 loader, u32 class hash */
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(PROTEGE_WIN32)
+void
+start_startup_trace(unsigned duration);
+
+int
+run_trace_report(const char *path);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_TRACE_H */
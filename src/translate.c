@@ -0,0 +1,262 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "translate.h"
+
+#include <string.h>
+
+#include <xmem.h>
+
+#define TRANSLATE_DROP                  1   /* Remove the option. */
+#define TRANSLATE_RENAME                2   /* Rename the flag, keeping
+                                               its value. */
+#define TRANSLATE_UNLOCK_EXPERIMENTAL   3   /* Keep the option, but
+                                               unlock experimental
+                                               options first. */
+#define TRANSLATE_UNLOCK_DIAGNOSTIC     4   /* Likewise, for diagnostic
+                                               options. */
+
+#define UNLOCK_EXPERIMENTAL_OPTION "-XX:+UnlockExperimentalVMOptions"
+#define UNLOCK_DIAGNOSTIC_OPTION "-XX:+UnlockDiagnosticVMOptions"
+
+/*
+ * A translation rule. Rules whose name starts with a dash apply to all
+ * options starting with that name; other rules apply to the -XX flag
+ * with that name, whatever its value.
+ */
+struct translation_rule {
+    const char *name;
+    unsigned    from;           /* First version the rule applies to. */
+    unsigned    until;          /* First version the rule no longer
+                                   applies to (0 for no limit). */
+    const char *implementor;    /* If not NULL, the rule only applies
+                                   to JREs from that vendor. */
+    int         action;
+    const char *replacement;    /* New name, for TRANSLATE_RENAME. */
+};
+
+/*
+ * The rules, in order of precedence: only the first rule matching a
+ * given option is applied.
+ */
+static const struct translation_rule rules[] = {
+    /* Module system options, only available since Java 9. */
+    { "--add-opens",                0, JRE_VERSION(9, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "--add-exports",              0, JRE_VERSION(9, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "--add-modules",              0, JRE_VERSION(9, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "--add-reads",                0, JRE_VERSION(9, 0, 0), NULL, TRANSLATE_DROP, NULL },
+
+    /* Options removed from recent versions. */
+    { "MaxPermSize", JRE_VERSION(8, 0, 0), 0, NULL, TRANSLATE_RENAME, "MaxMetaspaceSize" },
+    { "PermSize",    JRE_VERSION(8, 0, 0), 0, NULL, TRANSLATE_RENAME, "MetaspaceSize" },
+    { "UseParNewGC",                JRE_VERSION(10, 0, 0), 0, NULL, TRANSLATE_DROP, NULL },
+    { "UseCGroupMemoryLimitForHeap", JRE_VERSION(11, 0, 0), 0, NULL, TRANSLATE_DROP, NULL },
+    { "AggressiveOpts",             JRE_VERSION(12, 0, 0), 0, NULL, TRANSLATE_DROP, NULL },
+    { "UseConcMarkSweepGC",         JRE_VERSION(14, 0, 0), 0, NULL, TRANSLATE_DROP, NULL },
+
+    /* Container support, introduced in Java 10 and backported to 8u191. */
+    { "UseContainerSupport",   0, JRE_VERSION(8, 0, 191), NULL, TRANSLATE_DROP, NULL },
+    { "UseContainerSupport",   JRE_VERSION(9, 0, 0), JRE_VERSION(10, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "ActiveProcessorCount",  0, JRE_VERSION(8, 0, 191), NULL, TRANSLATE_DROP, NULL },
+    { "ActiveProcessorCount",  JRE_VERSION(9, 0, 0), JRE_VERSION(10, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "MaxRAMPercentage",      0, JRE_VERSION(8, 0, 191), NULL, TRANSLATE_DROP, NULL },
+    { "MaxRAMPercentage",      JRE_VERSION(9, 0, 0), JRE_VERSION(10, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "InitialRAMPercentage",  0, JRE_VERSION(8, 0, 191), NULL, TRANSLATE_DROP, NULL },
+    { "InitialRAMPercentage",  JRE_VERSION(9, 0, 0), JRE_VERSION(10, 0, 0), NULL, TRANSLATE_DROP, NULL },
+
+    { "ExitOnOutOfMemoryError",     0, JRE_VERSION(8, 0, 92), NULL, TRANSLATE_DROP, NULL },
+    { "CrashOnOutOfMemoryError",    0, JRE_VERSION(8, 0, 92), NULL, TRANSLATE_DROP, NULL },
+    { "PreserveFramePointer",       0, JRE_VERSION(8, 0, 60), NULL, TRANSLATE_DROP, NULL },
+
+    /* Garbage collectors. */
+    { "UseZGC",     0, JRE_VERSION(11, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "UseZGC",     JRE_VERSION(11, 0, 0), JRE_VERSION(15, 0, 0), NULL, TRANSLATE_UNLOCK_EXPERIMENTAL, NULL },
+    { "ZGenerational",              0, JRE_VERSION(21, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "UseShenandoahGC", 0, 0, "Oracle Corporation", TRANSLATE_DROP, NULL },
+    { "UseShenandoahGC", 0, JRE_VERSION(11, 0, 9), NULL, TRANSLATE_DROP, NULL },
+    { "UseShenandoahGC", JRE_VERSION(11, 0, 9), JRE_VERSION(15, 0, 0), NULL, TRANSLATE_UNLOCK_EXPERIMENTAL, NULL },
+    { "UseEpsilonGC",   0, JRE_VERSION(11, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "UseEpsilonGC",   JRE_VERSION(11, 0, 0), 0, NULL, TRANSLATE_UNLOCK_EXPERIMENTAL, NULL },
+    { "G1PeriodicGCInterval",       0, JRE_VERSION(12, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "SoftMaxHeapSize",            0, JRE_VERSION(13, 0, 0), NULL, TRANSLATE_DROP, NULL },
+
+    /* Class data sharing. */
+    { "ArchiveClassesAtExit",       0, JRE_VERSION(13, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "AutoCreateSharedArchive",    0, JRE_VERSION(19, 0, 0), NULL, TRANSLATE_DROP, NULL },
+
+    /* Profiling. */
+    { "DumpPerfMapAtExit",          0, JRE_VERSION(17, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "DumpPerfMapAtExit", JRE_VERSION(17, 0, 0), 0, NULL, TRANSLATE_UNLOCK_DIAGNOSTIC, NULL },
+
+    /* Miscellaneous. */
+    { "ShowCodeDetailsInExceptionMessages", 0, JRE_VERSION(14, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "UseCompactObjectHeaders",    0, JRE_VERSION(24, 0, 0), NULL, TRANSLATE_DROP, NULL },
+    { "UseCompactObjectHeaders", JRE_VERSION(24, 0, 0), JRE_VERSION(25, 0, 0), NULL, TRANSLATE_UNLOCK_EXPERIMENTAL, NULL },
+
+    { NULL, 0, 0, NULL, 0, NULL }
+};
+
+/*
+ * Find the first rule applying to an option for the given JRE.
+ *
+ * Returns the rule, or NULL if no rule applies.
+ */
+static const struct translation_rule *
+find_rule(const char *option, const struct jre_info *jre)
+{
+    const struct translation_rule *rule;
+    const char *flag = NULL;
+    size_t len = 0;
+
+    if ( strncmp(option, "-XX:", 4) == 0 ) {
+        flag = option + 4;
+        if ( *flag == '+' || *flag == '-' )
+            flag += 1;
+        len = strcspn(flag, "=");
+    }
+
+    for ( rule = rules; rule->name; rule++ ) {
+        if ( rule->name[0] == '-' ) {
+            if ( strncmp(option, rule->name, strlen(rule->name)) != 0 )
+                continue;
+        }
+        else if ( ! flag || strlen(rule->name) != len || strncmp(flag, rule->name, len) != 0 )
+            continue;
+
+        if ( jre->version < rule->from || (rule->until && jre->version >= rule->until) )
+            continue;
+
+        if ( rule->implementor && (! jre->implementor
+                                   || strcmp(jre->implementor, rule->implementor) != 0) )
+            continue;
+
+        return rule;
+    }
+
+    return NULL;
+}
+
+/**
+ * Translate a list of options for a given JRE.
+ *
+ * This removes the options that the JRE would not recognise (which
+ * would prevent the virtual machine from starting), renames options
+ * that have been replaced, and unlocks experimental or diagnostic
+ * options when needed. If the version of the JRE is unknown, options are kept as
+ * they are.
+ *
+ * @param options A NULL-terminated list of options.
+ * @param jre     The JRE the options are intended for.
+ *
+ * @return A newly allocated, NULL-terminated list of options, to be
+ *         freed with free_translated_options.
+ */
+char **
+translate_options(const char **options, const struct jre_info *jre)
+{
+    const struct translation_rule *rule;
+    const char *flag;
+    char **translated, *option;
+    size_t n, count;
+    int unlocked = 0, diagnostic_unlocked = 0;
+
+    for ( count = 0; options[count]; count++ ) ;
+
+    /* Each option may at worst become two options. */
+    translated = xmalloc((count * 2 + 1) * sizeof(char *));
+
+    for ( n = count = 0; options[n]; n++ ) {
+        option = NULL;
+
+        if ( strcmp(options[n], UNLOCK_EXPERIMENTAL_OPTION) == 0 )
+            unlocked = 1;
+        else if ( strcmp(options[n], UNLOCK_DIAGNOSTIC_OPTION) == 0 )
+            diagnostic_unlocked = 1;
+
+        if ( ! jre->version || ! (rule = find_rule(options[n], jre)) ) {
+            translated[count++] = xstrdup(options[n]);
+            continue;
+        }
+
+        switch ( rule->action ) {
+        case TRANSLATE_DROP:
+            break;
+
+        case TRANSLATE_RENAME:
+            /* Keep the sign of boolean flags, or the value. */
+            flag = options[n] + 4;
+            if ( *flag == '+' || *flag == '-' )
+                (void) xasprintf(&option, "-XX:%c%s", *flag, rule->replacement);
+            else
+                (void) xasprintf(&option, "-XX:%s%s", rule->replacement,
+                                 flag + strcspn(flag, "="));
+            translated[count++] = option;
+            break;
+
+        case TRANSLATE_UNLOCK_EXPERIMENTAL:
+            if ( ! unlocked ) {
+                translated[count++] = xstrdup(UNLOCK_EXPERIMENTAL_OPTION);
+                unlocked = 1;
+            }
+            translated[count++] = xstrdup(options[n]);
+            break;
+
+        case TRANSLATE_UNLOCK_DIAGNOSTIC:
+            if ( ! diagnostic_unlocked ) {
+                translated[count++] = xstrdup(UNLOCK_DIAGNOSTIC_OPTION);
+                diagnostic_unlocked = 1;
+            }
+            translated[count++] = xstrdup(options[n]);
+            break;
+        }
+    }
+    translated[count] = NULL;
+
+    return translated;
+}
+
+/**
+ * Free a list of options obtained from translate_options.
+ *
+ * @param options The list to free.
+ */
+void
+free_translated_options(char **options)
+{
+    size_t n;
+
+    for ( n = 0; options[n]; n++ )
+        free(options[n]);
+    free(options);
+}
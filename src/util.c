@@ -35,16 +35,22 @@
 #include "util.h"
 
 #include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
 #include <errno.h>
 
+#include <sys/stat.h>
+
 #include <xmem.h>
 
+#if !defined(PROTEGE_WIN32)
+#include <pthread.h>
+#endif
+
 #if defined(PROTEGE_LINUX)
 #include <unistd.h>
-#include <dlfcn.h>
 #include <sys/stat.h>
 #include <sys/sysinfo.h>
-#include <X11/Xlib.h>
 
 #elif defined(PROTEGE_MACOS)
 #include <mach-o/dyld.h>
@@ -251,49 +257,587 @@ get_physical_memory(void)
     return phys_mem;
 }
 
+/**
+ * Get the amount of physical memory that can be used without swapping,
+ * that is, the free memory plus what the system can reclaim from its
+ * caches.
+ *
+ * @return The available memory (in bytes), or 0 if we couldn't get
+ *         that information.
+ */
+size_t
+get_available_memory(void)
+{
+    size_t avail_mem = 0;
+
 #if defined(PROTEGE_LINUX)
+    FILE *f;
+    char line[256];
+    unsigned long long kb;
+
+    if ( (f = fopen("/proc/meminfo", "r")) ) {
+        while ( get_line(f, line, sizeof(line)) > 0 )
+            if ( sscanf(line, "MemAvailable: %llu kB", &kb) == 1 ) {
+                avail_mem = kb * 1024;
+                break;
+            }
+        fclose(f);
+    }
+#endif
+
+    return avail_mem;
+}
+
+/**
+ * Parse a memory amount, as expected by the memory-related Java options
+ * (e.g. "-Xss" or "-Xmx").
+ *
+ * @param value The value to parse: an integer, optionally followed by
+ *              a K, M, or G unit (case-insensitive).
+ *
+ * @return The amount in bytes, or 0 if the value is invalid.
+ */
+size_t
+get_memory_amount(const char *value)
+{
+    size_t amount;
+    char unit = '\0';
+
+    if ( sscanf(value, "%zu%c", &amount, &unit) < 1 )
+        return 0;
+
+    switch ( unit ) {
+    case 'g':
+    case 'G':
+        amount *= 1024;
+        /* Fall through. */
+    case 'm':
+    case 'M':
+        amount *= 1024;
+        /* Fall through. */
+    case 'k':
+    case 'K':
+        amount *= 1024;
+        /* Fall through. */
+    case '\0':
+        break;
+
+    default:
+        amount = 0;
+    }
+
+    return amount;
+}
+
+#if !defined(PROTEGE_WIN32)
 
 /**
- * Get the resolution of the screen in DPI.
+ * Create a directory, along with any missing parent directory (as with
+ * `mkdir -p`).
+ *
+ * @param path The directory to create.
  *
- * @param[out] hres The horizontal resolution.
- * @param[out] vres The vertical resolution.
- * @return 0 if successful, or -1 if we could not get the resolution.
+ * @return 0 if successful or if the directory already exists, or -1
+ *         if an error occured.
  */
 int
-get_screen_dpi(int *hres, int *vres)
+create_directory(const char *path)
 {
-    void *xlib;
-    int ret = -1;
-    double h, v;
-    Display *dpy;
-    Display * (*xOpenDisplay)(char *);
-    int (*xCloseDisplay)(Display *);
+    char *copy, *p;
+    int ret = 0;
+
+    copy = xstrdup(path);
+    for ( p = copy + 1; *p && ret == 0; p++ ) {
+        if ( *p == '/' ) {
+            *p = '\0';
+            if ( mkdir(copy, 0700) == -1 && errno != EEXIST )
+                ret = -1;
+            *p = '/';
+        }
+    }
+    free(copy);
 
-    xlib = dlopen("libX11.so.6", RTLD_LAZY);
-    if ( xlib ) {
-        xOpenDisplay = (Display * (*)(char *)) dlsym(xlib, "XOpenDisplay");
-        xCloseDisplay = (int (*)(Display *)) dlsym(xlib, "XCloseDisplay");
+    if ( ret == 0 && mkdir(path, 0700) == -1 && errno != EEXIST )
+        ret = -1;
 
-        if ( xOpenDisplay && xCloseDisplay ) {
-            dpy = xOpenDisplay(getenv("DISPLAY"));
+    return ret;
+}
 
-            if ( dpy ) {
-                h = ((((double) DisplayWidth (dpy, 0)) * 25.4) / ((double) DisplayWidthMM (dpy, 0)));
-                v = ((((double) DisplayHeight(dpy, 0)) * 25.4) / ((double) DisplayHeightMM(dpy, 0)));
-                xCloseDisplay(dpy);
+/**
+ * Get the directory where the launcher may cache data between
+ * sessions. The directory is not created.
+ *
+ * @return A newly allocated buffer containing the pathname to the
+ *         cache directory, or NULL if it could not be determined.
+ */
+char *
+get_cache_directory(void)
+{
+    char *dir = NULL, *base;
+
+#if defined(PROTEGE_MACOS)
+    if ( (base = getenv("HOME")) )
+        (void) xasprintf(&dir, "%s/Library/Caches/Protege", base);
+#else
+    if ( (base = getenv("XDG_CACHE_HOME")) && base[0] == '/' )
+        (void) xasprintf(&dir, "%s/protege", base);
+    else if ( (base = getenv("HOME")) )
+        (void) xasprintf(&dir, "%s/.cache/protege", base);
+#endif
 
-                *hres = (int) (h + 0.5);
-                *vres = (int) (v + 0.5);
+    return dir;
+}
 
-                ret = 0;
-            }
+/**
+ * Get a pathname to this executable, suitable to execute it again.
+ *
+ * @return A newly allocated buffer containing the pathname, or NULL if
+ *         an error occured.
+ */
+char *
+get_executable_path(void)
+{
+    char *buffer = NULL;
+
+#if defined(PROTEGE_LINUX)
+    /* Always refers to the running executable, even if the file has
+     * been moved or replaced since it was started. */
+    buffer = xstrdup("/proc/self/exe");
+
+#elif defined(PROTEGE_MACOS)
+    uint32_t buffer_len = 0;
+
+    (void) _NSGetExecutablePath(buffer, &buffer_len);
+    buffer = xmalloc(buffer_len);
+    if ( _NSGetExecutablePath(buffer, &buffer_len) != 0 ) {
+        free(buffer);
+        buffer = NULL;
+        errno = ENAMETOOLONG;
+    }
+
+#endif
+
+    return buffer;
+}
+
+/**
+ * Get the directory for the launcher's runtime files, such as sockets
+ * and shared memory files. This is $XDG_RUNTIME_DIR if set, otherwise
+ * the temporary directory.
+ *
+ * @return A newly allocated buffer containing the pathname.
+ */
+char *
+get_runtime_directory(void)
+{
+    const char *base;
+
+    if ( (base = getenv("XDG_RUNTIME_DIR")) && base[0] == '/' )
+        return xstrdup(base);
+
+    if ( (base = getenv("TMPDIR")) && base[0] == '/' )
+        return xstrdup(base);
+
+    return xstrdup("/tmp");
+}
+
+/**
+ * Get the directory where Protégé writes its logs.
+ *
+ * @return A newly allocated buffer containing the pathname, or NULL if
+ *         the home directory is unknown.
+ */
+char *
+get_log_directory(void)
+{
+    char *dir = NULL, *home;
+
+    if ( (home = getenv("HOME")) )
+        (void) xasprintf(&dir, "%s/.Protege/logs", home);
+
+    return dir;
+}
+
+/**
+ * Set the name of the calling thread, as shown by system tools such as
+ * top, ps, or perf.
+ *
+ * @param name The name of the thread (truncated to 15 characters on
+ *             GNU/Linux).
+ */
+void
+set_thread_name(const char *name)
+{
+#if defined(PROTEGE_LINUX)
+    char buffer[16];
+
+    (void) snprintf(buffer, sizeof(buffer), "%s", name);
+    (void) pthread_setname_np(pthread_self(), buffer);
+#elif defined(PROTEGE_MACOS)
+    (void) pthread_setname_np(name);
+#endif
+}
+
+#define MAX_EXIT_HANDLERS   16
+
+static void (*exit_handlers[MAX_EXIT_HANDLERS])(void);
+static size_t n_exit_handlers = 0;
+
+/**
+ * Register a function to be called when the launcher exits. The
+ * function is registered with atexit(3), and is also called by
+ * run_exit_handlers when the launcher exits without going through
+ * exit(3).
+ *
+ * @param handler The function to call.
+ */
+void
+add_exit_handler(void (*handler)(void))
+{
+    if ( n_exit_handlers < MAX_EXIT_HANDLERS )
+        exit_handlers[n_exit_handlers++] = handler;
+    (void) atexit(handler);
+}
+
+/**
+ * Call the functions registered with add_exit_handler, in the reverse
+ * order of their registration, as exit(3) would. Each function is
+ * called at most once by this function.
+ */
+void
+run_exit_handlers(void)
+{
+    while ( n_exit_handlers > 0 )
+        exit_handlers[--n_exit_handlers]();
+}
+
+#endif
+
+#if defined(PROTEGE_LINUX)
+
+/**
+ * Parse a list of CPUs, in the format used by the kernel and by
+ * taskset(1) (e.g. "0-3,8,10-11").
+ *
+ * @param[in] list The list to parse; it may end with a newline.
+ * @param[out] set The CPU set to fill.
+ *
+ * @return 0 if successful, or -1 if the list is invalid.
+ */
+int
+parse_cpu_list(const char *list, cpu_set_t *set)
+{
+    const char *p = list;
+    char *end;
+    long first, last;
+
+    CPU_ZERO(set);
+    while ( *p && *p != '\n' ) {
+        first = last = strtol(p, &end, 10);
+        if ( end == p || first < 0 )
+            return -1;
+
+        if ( *end == '-' ) {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if ( end == p || last < first )
+                return -1;
         }
 
-        dlclose(xlib);
+        if ( last >= CPU_SETSIZE )
+            return -1;
+
+        for ( ; first <= last; first++ )
+            CPU_SET(first, set);
+
+        p = end;
+        if ( *p == ',' )
+            p += 1;
+        else if ( *p && *p != '\n' )
+            return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Format a set of CPUs as a list, in the same format as the one
+ * expected by parse_cpu_list.
+ *
+ * @param set The CPU set to format.
+ *
+ * @return A newly allocated buffer containing the list.
+ */
+char *
+format_cpu_list(const cpu_set_t *set)
+{
+    char *list, *p;
+    int cpu, last;
+
+    /* Worst case: "n," for every possible CPU. */
+    p = list = xmalloc(CPU_SETSIZE * 6 + 1);
+    *p = '\0';
+
+    for ( cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+        if ( ! CPU_ISSET(cpu, set) )
+            continue;
+
+        for ( last = cpu; last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set); last++ ) ;
+
+        if ( last > cpu )
+            p += sprintf(p, "%s%d-%d", p == list ? "" : ",", cpu, last);
+        else
+            p += sprintf(p, "%s%d", p == list ? "" : ",", cpu);
+        cpu = last;
+    }
+
+    return list;
+}
+
+/*
+ * Read the first line of a sysfs file.
+ *
+ * Returns the length of the line, or -1 if the file cannot be read.
+ */
+static int
+read_sysfs(char *buffer, size_t len, const char *fmt, ...)
+{
+    char path[256];
+    va_list ap;
+    FILE *f;
+    int ret = -1;
+
+    va_start(ap, fmt);
+    (void) vsnprintf(path, sizeof(path), fmt, ap);
+    va_end(ap);
+
+    if ( (f = fopen(path, "r")) ) {
+        ret = get_line(f, buffer, len);
+        fclose(f);
     }
 
     return ret;
 }
 
+/**
+ * Get the memory limit of the control group of the process, which is
+ * the lowest limit set on the group or any of its ancestors (cgroup
+ * v2), or the limit of its memory controller group (cgroup v1).
+ *
+ * @return The limit in bytes, or 0 if there is no limit or if it
+ *         cannot be determined.
+ */
+size_t
+get_cgroup_memory_limit(void)
+{
+    FILE *f;
+    char line[PROTEGE_PATH_MAX], buffer[64], *path = NULL, *slash;
+    unsigned long long value, limit = 0;
+
+    if ( ! (f = fopen("/proc/self/cgroup", "r")) )
+        return 0;
+
+    while ( ! path && get_line(f, line, sizeof(line)) > 0 ) {
+        if ( strncmp(line, "0::/", 4) == 0 )
+            path = xstrdup(line + 3);
+        else if ( (slash = strstr(line, ":memory:/")) ) {
+            if ( read_sysfs(buffer, sizeof(buffer), "/sys/fs/cgroup/memory%s/memory.limit_in_bytes",
+                            strcmp(slash + 8, "/") == 0 ? "" : slash + 8) <= 0
+                    && read_sysfs(buffer, sizeof(buffer),
+                                  "/sys/fs/cgroup/memory/memory.limit_in_bytes") <= 0 )
+                break;
+            limit = strtoull(buffer, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+
+    /* With cgroup v2, walk up the hierarchy. In a container, the group
+     * of the process is the root of its cgroup namespace. */
+    while ( path ) {
+        if ( read_sysfs(buffer, sizeof(buffer), "/sys/fs/cgroup%s/memory.max",
+                        strcmp(path, "/") == 0 ? "" : path) > 0
+                && strncmp(buffer, "max", 3) != 0
+                && (value = strtoull(buffer, NULL, 10)) > 0
+                && (limit == 0 || value < limit) )
+            limit = value;
+
+        if ( strcmp(path, "/") == 0 ) {
+            free(path);
+            path = NULL;
+        }
+        else if ( (slash = strrchr(path, '/')) == path )
+            path[1] = '\0';
+        else
+            *slash = '\0';
+    }
+
+    /* Unlimited cgroup v1 groups report a huge value. */
+    if ( limit >= get_physical_memory() )
+        limit = 0;
+
+    return limit;
+}
+
+/*
+ * Find the performance cores of a hybrid Intel CPU, which the kernel
+ * exposes as two distinct PMUs for the two kinds of cores.
+ */
+static int
+get_hybrid_cores(cpu_set_t *performance)
+{
+    char buffer[1024];
+
+    if ( read_sysfs(buffer, sizeof(buffer), "/sys/devices/cpu_atom/cpus") <= 0
+            || read_sysfs(buffer, sizeof(buffer), "/sys/devices/cpu_core/cpus") <= 0 )
+        return -1;
+
+    return parse_cpu_list(buffer, performance);
+}
+
+/*
+ * Find the performance cores from the relative capacities of the CPUs,
+ * as exposed on ARM big.LITTLE-style systems. CPUs with more than half
+ * of the capacity of the biggest CPU are considered performance cores.
+ */
+static int
+get_big_cores(const cpu_set_t *available, cpu_set_t *performance)
+{
+    char buffer[32];
+    int cpu, capacity[CPU_SETSIZE], max = 0;
+
+    for ( cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+        capacity[cpu] = 0;
+        if ( CPU_ISSET(cpu, available)
+                && read_sysfs(buffer, sizeof(buffer),
+                              "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu) > 0 ) {
+            capacity[cpu] = atoi(buffer);
+            if ( capacity[cpu] > max )
+                max = capacity[cpu];
+        }
+    }
+
+    if ( max == 0 )
+        return -1;
+
+    CPU_ZERO(performance);
+    for ( cpu = 0; cpu < CPU_SETSIZE; cpu++ )
+        if ( capacity[cpu] * 2 > max )
+            CPU_SET(cpu, performance);
+
+    return 0;
+}
+
+/*
+ * Count the CPUs in a list read from a sysfs file.
+ *
+ * Returns the number of CPUs, or 0 if the file cannot be read.
+ */
+static int
+count_sysfs_cpus(const char *path)
+{
+    char buffer[1024];
+    cpu_set_t set;
+
+    if ( read_sysfs(buffer, sizeof(buffer), "%s", path) <= 0
+            || parse_cpu_list(buffer, &set) == -1 )
+        return 0;
+
+    return CPU_COUNT(&set);
+}
+
+/*
+ * Find the performance cores from the cache topology, for hybrid CPUs
+ * on kernels that do not expose distinct PMUs: efficiency cores share
+ * their L2 cache with other cores (in clusters of four), whereas the
+ * L2 cache of performance cores is private (only shared between the
+ * hardware threads of the core).
+ */
+static int
+get_private_cache_cores(const cpu_set_t *available, cpu_set_t *performance)
+{
+    char buffer[32], path[256];
+    int cpu, index, siblings, sharing, n_private = 0, n_shared = 0;
+
+    CPU_ZERO(performance);
+    for ( cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+        if ( ! CPU_ISSET(cpu, available) )
+            continue;
+
+        /* Find the L2 cache. */
+        for ( index = 0; ; index++ ) {
+            if ( read_sysfs(buffer, sizeof(buffer),
+                            "/sys/devices/system/cpu/cpu%d/cache/index%d/level",
+                            cpu, index) <= 0 )
+                return -1;
+            if ( atoi(buffer) == 2 )
+                break;
+        }
+
+        (void) snprintf(path, sizeof(path),
+                        "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+        siblings = count_sysfs_cpus(path);
+        (void) snprintf(path, sizeof(path),
+                        "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list",
+                        cpu, index);
+        sharing = count_sysfs_cpus(path);
+
+        if ( siblings == 0 || sharing == 0 )
+            return -1;
+
+        if ( sharing <= siblings ) {
+            CPU_SET(cpu, performance);
+            n_private += 1;
+        }
+        else
+            n_shared += 1;
+    }
+
+    /* If all cores are alike, this tells us nothing. */
+    return n_private > 0 && n_shared > 0 ? 0 : -1;
+}
+
+/**
+ * Get the topology of the CPUs available to the launcher, to find out
+ * whether they are all of the same kind or whether some of them are
+ * faster than the others (e.g. "performance" and "efficiency" cores on
+ * hybrid Intel CPUs, or "big" and "LITTLE" cores on ARM).
+ *
+ * @param[in] cpu_list  If not NULL, a list of CPUs (as expected by
+ *                      parse_cpu_list) the launcher will be restricted
+ *                      to.
+ * @param[out] topology The structure to fill.
+ *
+ * @return 0 if successful, or -1 if the available CPUs are unknown.
+ */
+int
+get_cpu_topology(const char *cpu_list, struct cpu_topology *topology)
+{
+    cpu_set_t wanted, big;
+    int n_available, n_performance;
+
+    if ( sched_getaffinity(0, sizeof(topology->available), &topology->available) == -1 )
+        return -1;
+
+    if ( cpu_list && parse_cpu_list(cpu_list, &wanted) == 0 )
+        CPU_AND(&topology->available, &topology->available, &wanted);
+
+    if ( get_hybrid_cores(&big) == -1
+            && get_big_cores(&topology->available, &big) == -1
+            && get_private_cache_cores(&topology->available, &big) == -1 )
+        CPU_ZERO(&big);
+
+    CPU_AND(&topology->performance, &topology->available, &big);
+
+    /* If none of the available CPUs is a performance core, they are all
+     * of the same (efficiency) kind. */
+    n_available = CPU_COUNT(&topology->available);
+    n_performance = CPU_COUNT(&topology->performance);
+    topology->heterogeneous = n_performance > 0 && n_performance < n_available;
+    if ( ! topology->heterogeneous )
+        CPU_OR(&topology->performance, &topology->performance, &topology->available);
+
+    return 0;
+}
+
 #endif /* !PROTEGE_LINUX */
@@ -34,8 +34,25 @@
 #include <stdlib.h>
 #include <stdio.h>
 
+#if defined(PROTEGE_LINUX)
+#include <sched.h>
+#endif
+
 #define PROTEGE_PATH_MAX 4096
 
+#if defined(PROTEGE_LINUX)
+/*
+ * Describe the CPUs available to the launcher.
+ */
+struct cpu_topology {
+    cpu_set_t   available;      /* CPUs we may run on. */
+    cpu_set_t   performance;    /* Subset of the available CPUs that
+                                   are performance cores. */
+    int         heterogeneous;  /* Non-zero if the available CPUs are
+                                   of different kinds. */
+};
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -49,9 +66,50 @@ get_line(FILE *f, char *buffer, size_t len);
 size_t
 get_physical_memory(void);
 
+size_t
+get_available_memory(void);
+
+size_t
+get_memory_amount(const char *value);
+
+#if !defined(PROTEGE_WIN32)
+int
+create_directory(const char *path);
+
+char *
+get_cache_directory(void);
+
+char *
+get_executable_path(void);
+
+char *
+get_runtime_directory(void);
+
+char *
+get_log_directory(void);
+
+void
+set_thread_name(const char *name);
+
+void
+add_exit_handler(void (*handler)(void));
+
+void
+run_exit_handlers(void);
+#endif
+
 #if defined(PROTEGE_LINUX)
 int
-get_screen_dpi(int *hres, int *vres);
+parse_cpu_list(const char *list, cpu_set_t *set);
+
+char *
+format_cpu_list(const cpu_set_t *set);
+
+int
+get_cpu_topology(const char *cpu_list, struct cpu_topology *topology);
+
+size_t
+get_cgroup_memory_limit(void);
 #endif
 
 #ifdef __cplusplus
@@ -0,0 +1,583 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "watchdog.h"
+
+#if defined(PROTEGE_LINUX)
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <err.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <xmem.h>
+
+#include "java.h"
+#include "jmx.h"
+#include "util.h"
+
+/* How often the watchdog checks the event dispatch thread, in seconds. */
+#define PROBE_INTERVAL      1
+
+/* Native name of the event dispatch thread (Java 9 and later name
+ * native threads after Java threads, truncated to 15 characters). */
+#define EDT_NAME_PREFIX     "AWT-EventQueue"
+
+/* Number of thread dumps to take when the user interface hangs, and
+ * the delay between them, in seconds. */
+#define HANG_DUMP_COUNT     3
+#define HANG_DUMP_INTERVAL  2
+
+/* Duration of the CPU profile of a slow startup, in seconds. */
+#define STARTUP_PROFILE_DURATION    2
+
+/*
+ * A snapshot of one thread of the launcher's process.
+ */
+struct thread_sample {
+    pid_t               tid;
+    char                name[16];
+    char                state;
+    unsigned long long  cpu_time;   /* User+system, in clock ticks. */
+    char                wchan[32];  /* Where the thread is waiting in
+                                       the kernel. */
+};
+
+/*
+ * State of the watchdog.
+ */
+static struct {
+    unsigned        startup_timeout;    /* In seconds, 0 to disable. */
+    unsigned        hang_threshold;     /* In seconds, 0 to disable. */
+    pthread_mutex_t lock;
+    pthread_cond_t  started;
+    JavaVM         *jvm;                /* Set once Java has started. */
+} watchdog = { 0, 0, PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, NULL };
+
+/*
+ * What the watchdog needs to probe the event dispatch thread.
+ */
+static struct {
+    jclass      event_queue;
+    jmethodID   invoke_later;
+    jclass      future_task;
+    jmethodID   future_task_init;
+    jmethodID   is_done;
+    jobject     noop;       /* A Runnable that does nothing. */
+} probe;
+
+/*
+ * Read the first line of a file of the /proc/self/task/<tid> directory.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+read_task_file(pid_t tid, const char *name, char *buffer, size_t len)
+{
+    char path[64];
+    FILE *f;
+    int ret = -1;
+
+    (void) snprintf(path, sizeof(path), "/proc/self/task/%ld/%s", (long) tid, name);
+    if ( (f = fopen(path, "r")) ) {
+        if ( get_line(f, buffer, len) >= 0 )
+            ret = 0;
+        fclose(f);
+    }
+
+    return ret;
+}
+
+/*
+ * Take a snapshot of all the threads of the process.
+ *
+ * Returns the number of threads, and set *samples to a newly allocated
+ * array of snapshots.
+ */
+static size_t
+sample_threads(struct thread_sample **samples)
+{
+    DIR *dir;
+    struct dirent *entry;
+    struct thread_sample *sample;
+    size_t n = 0, allocated = 64;
+    char line[512], *p;
+    unsigned long utime, stime;
+
+    *samples = xmalloc(allocated * sizeof(struct thread_sample));
+    if ( ! (dir = opendir("/proc/self/task")) )
+        return 0;
+
+    while ( (entry = readdir(dir)) ) {
+        if ( entry->d_name[0] == '.' )
+            continue;
+
+        if ( n >= allocated ) {
+            allocated *= 2;
+            *samples = xrealloc(*samples, allocated * sizeof(struct thread_sample));
+        }
+        sample = &(*samples)[n];
+        sample->tid = atoi(entry->d_name);
+
+        /* The name may contain spaces and parentheses, so we rely on
+         * the last closing parenthesis to find the following fields. */
+        if ( read_task_file(sample->tid, "stat", line, sizeof(line)) == -1
+                || ! (p = strrchr(line, ')'))
+                || sscanf(p + 2, "%c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu",
+                          &sample->state, &utime, &stime) != 3 )
+            continue;
+        sample->cpu_time = utime + stime;
+
+        if ( read_task_file(sample->tid, "comm", sample->name, sizeof(sample->name)) == -1 )
+            sample->name[0] = '\0';
+        if ( read_task_file(sample->tid, "wchan", sample->wchan, sizeof(sample->wchan)) == -1 )
+            sample->wchan[0] = '\0';
+
+        n += 1;
+    }
+    closedir(dir);
+
+    return n;
+}
+
+/*
+ * Write the CPU usage of each thread between two snapshots, busiest
+ * threads first.
+ */
+static void
+write_cpu_profile(FILE *f, struct thread_sample *before, size_t n_before,
+                  struct thread_sample *after, size_t n_after, double elapsed)
+{
+    size_t i, j, best;
+    unsigned long long *deltas, delta;
+    long ticks = sysconf(_SC_CLK_TCK);
+    struct thread_sample tmp;
+
+    deltas = xmalloc((n_after + 1) * sizeof(unsigned long long));
+    for ( i = 0; i < n_after; i++ ) {
+        deltas[i] = after[i].cpu_time;
+        for ( j = 0; j < n_before; j++ )
+            if ( before[j].tid == after[i].tid && before[j].cpu_time <= after[i].cpu_time )
+                deltas[i] = after[i].cpu_time - before[j].cpu_time;
+    }
+
+    /* Selection sort, there are only a few dozen threads. */
+    for ( i = 0; i < n_after; i++ ) {
+        for ( j = best = i; j < n_after; j++ )
+            if ( deltas[j] > deltas[best] )
+                best = j;
+        tmp = after[i], after[i] = after[best], after[best] = tmp;
+        delta = deltas[i], deltas[i] = deltas[best], deltas[best] = delta;
+    }
+
+    fprintf(f, "CPU usage per thread over %.1f seconds:\n\n", elapsed);
+    fprintf(f, "%8s  %-15s  %s  %6s  %s\n", "TID", "NAME", "S", "CPU%", "WCHAN");
+    for ( i = 0; i < n_after; i++ )
+        fprintf(f, "%8ld  %-15s  %c  %6.1f  %s\n", (long) after[i].tid, after[i].name,
+                after[i].state, deltas[i] * 100.0 / ticks / elapsed,
+                after[i].wchan[0] && strcmp(after[i].wchan, "0") != 0 ? after[i].wchan : "-");
+    fputc('\n', f);
+
+    free(deltas);
+}
+
+/*
+ * Open a new report file in the log directory.
+ *
+ * Returns the open file, and set *path to a newly allocated buffer
+ * containing its pathname; or NULL if the report cannot be created.
+ */
+static FILE *
+open_report(const char *kind, char **path)
+{
+    char *dir, stamp[32];
+    time_t now = time(NULL);
+    FILE *f;
+
+    if ( ! (dir = get_log_directory()) )
+        return NULL;
+
+    (void) create_directory(dir);
+    (void) strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&now));
+    *path = NULL;
+    (void) xasprintf(path, "%s/%s-%ld-%s.txt", dir, kind, (long) getpid(), stamp);
+    free(dir);
+
+    if ( ! (f = fopen(*path, "w")) ) {
+        warn("Cannot create %s", *path);
+        free(*path);
+    }
+
+    return f;
+}
+
+/*
+ * Write a timestamped header in a report.
+ */
+static void
+write_header(FILE *f, const char *title)
+{
+    char stamp[32];
+    time_t now = time(NULL);
+
+    (void) strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+    fprintf(f, "==== %s at %s ====\n\n", title, stamp);
+}
+
+/*
+ * Write the CPU usage of each thread since a previous snapshot.
+ */
+static void
+profile_threads(FILE *f, struct thread_sample *before, size_t n_before,
+                const struct timespec *start)
+{
+    struct thread_sample *after;
+    struct timespec now;
+    size_t n_after;
+    double elapsed;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+
+    n_after = sample_threads(&after);
+    write_cpu_profile(f, before, n_before, after, n_after, elapsed);
+    free(after);
+}
+
+/*
+ * Report a virtual machine that has not started after the configured
+ * time. As there is no virtual machine to ask yet, we can only tell
+ * what the threads of the process are doing.
+ */
+static void
+report_slow_startup(void)
+{
+    FILE *f;
+    char *path;
+    struct thread_sample *before;
+    size_t n_before;
+    struct timespec start;
+
+    if ( ! (f = open_report("startup", &path)) )
+        return;
+
+    write_header(f, "Startup not complete");
+    fprintf(f, "Java has not started after %u seconds.\n\n", watchdog.startup_timeout);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    n_before = sample_threads(&before);
+    sleep(STARTUP_PROFILE_DURATION);
+    profile_threads(f, before, n_before, &start);
+    free(before);
+
+    if ( fclose(f) == 0 )
+        warnx("Java has not started after %u seconds, report written to %s",
+              watchdog.startup_timeout, path);
+    free(path);
+}
+
+/*
+ * Report a hang of the event dispatch thread: several thread dumps,
+ * and the CPU usage of each thread between the first and the last
+ * dump, so that a busy event dispatch thread can be told apart from
+ * a blocked one.
+ */
+static void
+report_hang(JNIEnv *env, unsigned elapsed)
+{
+    FILE *f;
+    char *path, *dump;
+    struct thread_sample *before;
+    size_t n_before;
+    struct timespec start;
+    unsigned n;
+
+    if ( ! (f = open_report("hang", &path)) )
+        return;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    n_before = sample_threads(&before);
+    for ( n = 0; n < HANG_DUMP_COUNT; n++ ) {
+        if ( n > 0 )
+            sleep(HANG_DUMP_INTERVAL);
+
+        write_header(f, "Thread dump");
+        if ( run_diagnostic_command(env, "threadPrint", NULL, &dump) == 0 && dump ) {
+            fputs(dump, f);
+            fputc('\n', f);
+            free(dump);
+        }
+        else
+            fputs("Thread dump not available.\n\n", f);
+    }
+
+    write_header(f, "CPU profile");
+    profile_threads(f, before, n_before, &start);
+    free(before);
+
+    if ( fclose(f) == 0 )
+        warnx("The user interface has been blocked for %u seconds, report written to %s",
+              elapsed, path);
+    free(path);
+}
+
+/*
+ * Check whether the event dispatch thread has been started.
+ */
+static int
+has_event_dispatch_thread(void)
+{
+    struct thread_sample *samples;
+    size_t n, count;
+    int found = 0;
+
+    count = sample_threads(&samples);
+    for ( n = 0; n < count && ! found; n++ )
+        if ( strncmp(samples[n].name, EDT_NAME_PREFIX, strlen(EDT_NAME_PREFIX)) == 0 )
+            found = 1;
+    free(samples);
+
+    return found;
+}
+
+/*
+ * Look up the classes and methods needed to probe the event dispatch
+ * thread. This must only be done once AWT is running, so as not to
+ * initialise it ourselves.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+init_probe(JNIEnv *env)
+{
+    jclass thread_class;
+    jmethodID thread_init;
+
+    if ( (probe.event_queue = (*env)->FindClass(env, "java/awt/EventQueue"))
+            && (probe.invoke_later = (*env)->GetStaticMethodID(env, probe.event_queue,
+                    "invokeLater", "(Ljava/lang/Runnable;)V"))
+            && (probe.future_task = (*env)->FindClass(env, "java/util/concurrent/FutureTask"))
+            && (probe.future_task_init = (*env)->GetMethodID(env, probe.future_task,
+                    "<init>", "(Ljava/lang/Runnable;Ljava/lang/Object;)V"))
+            && (probe.is_done = (*env)->GetMethodID(env, probe.future_task, "isDone", "()Z"))
+            && (thread_class = (*env)->FindClass(env, "java/lang/Thread"))
+            && (thread_init = (*env)->GetMethodID(env, thread_class, "<init>", "()V"))
+            && (probe.noop = (*env)->NewObject(env, thread_class, thread_init)) ) {
+        /* A Thread that is never started is a Runnable doing nothing. */
+        probe.event_queue = (*env)->NewGlobalRef(env, probe.event_queue);
+        probe.future_task = (*env)->NewGlobalRef(env, probe.future_task);
+        probe.noop = (*env)->NewGlobalRef(env, probe.noop);
+        return 0;
+    }
+
+    (*env)->ExceptionClear(env);
+    return -1;
+}
+
+/*
+ * Post an empty task to the event queue.
+ *
+ * Returns a global reference to the task, or NULL if the task could
+ * not be posted.
+ */
+static jobject
+post_probe(JNIEnv *env)
+{
+    jobject task, ref = NULL;
+
+    if ( (task = (*env)->NewObject(env, probe.future_task, probe.future_task_init,
+                                   probe.noop, NULL)) ) {
+        (*env)->CallStaticVoidMethod(env, probe.event_queue, probe.invoke_later, task);
+        if ( ! (*env)->ExceptionCheck(env) )
+            ref = (*env)->NewGlobalRef(env, task);
+        (*env)->DeleteLocalRef(env, task);
+    }
+
+    if ( (*env)->ExceptionCheck(env) )
+        (*env)->ExceptionClear(env);
+
+    return ref;
+}
+
+/*
+ * Watch the event dispatch thread, by posting an empty task and
+ * checking that it is run in a timely manner.
+ */
+static void
+watch_event_dispatch_thread(JavaVM *jvm)
+{
+    JNIEnv *env;
+    JavaVMAttachArgs attach_args;
+    jobject task = NULL;
+    time_t posted = 0, now;
+    int reported = 0;
+
+    attach_args.version = JNI_VERSION_1_2;
+    attach_args.name = "protege-watch";
+    attach_args.group = NULL;
+
+    /* There is nothing to watch before the user interface is up. */
+    while ( ! has_event_dispatch_thread() )
+        sleep(PROBE_INTERVAL);
+
+    if ( (*jvm)->AttachCurrentThreadAsDaemon(jvm, (void **) &env, &attach_args) != JNI_OK )
+        return;
+
+    if ( init_probe(env) == -1 ) {
+        warnx("Cannot watch the user interface");
+        (*jvm)->DetachCurrentThread(jvm);
+        return;
+    }
+
+    for ( ;; ) {
+        now = time(NULL);
+
+        if ( ! task ) {
+            if ( ! (task = post_probe(env)) )
+                break;
+            posted = now;
+        }
+        else if ( (*env)->CallBooleanMethod(env, task, probe.is_done) ) {
+            if ( reported )
+                warnx("The user interface is responsive again after %ld seconds",
+                      (long) (now - posted));
+            reported = 0;
+            (*env)->DeleteGlobalRef(env, task);
+            task = NULL;
+        }
+        else if ( ! reported && now - posted >= watchdog.hang_threshold ) {
+            report_hang(env, now - posted);
+            reported = 1;
+        }
+
+        sleep(PROBE_INTERVAL);
+    }
+
+    (*jvm)->DetachCurrentThread(jvm);
+}
+
+/*
+ * Main function of the watchdog thread.
+ */
+static void *
+watchdog_main(void *arg)
+{
+    struct timespec deadline;
+    JavaVM *jvm;
+    int ret = 0;
+
+    (void) arg;
+
+    set_thread_name("protege-watch");
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += watchdog.startup_timeout;
+
+    pthread_mutex_lock(&watchdog.lock);
+    while ( ! watchdog.jvm && ret != ETIMEDOUT ) {
+        if ( watchdog.startup_timeout )
+            ret = pthread_cond_timedwait(&watchdog.started, &watchdog.lock, &deadline);
+        else
+            (void) pthread_cond_wait(&watchdog.started, &watchdog.lock);
+    }
+    pthread_mutex_unlock(&watchdog.lock);
+
+    if ( ret == ETIMEDOUT ) {
+        report_slow_startup();
+
+        /* Keep waiting, we may still have a user interface to watch. */
+        pthread_mutex_lock(&watchdog.lock);
+        while ( ! watchdog.jvm )
+            (void) pthread_cond_wait(&watchdog.started, &watchdog.lock);
+        pthread_mutex_unlock(&watchdog.lock);
+    }
+
+    jvm = watchdog.jvm;
+    if ( watchdog.hang_threshold )
+        watch_event_dispatch_thread(jvm);
+
+    return NULL;
+}
+
+/*
+ * Called once the virtual machine has been created, just before the
+ * main class is started.
+ */
+static void
+on_java_created(JavaVM *jvm, JNIEnv *env, void *data)
+{
+    (void) data;
+
+    if ( watchdog.hang_threshold )
+        (void) init_jmx(env);
+
+    pthread_mutex_lock(&watchdog.lock);
+    watchdog.jvm = jvm;
+    pthread_cond_signal(&watchdog.started);
+    pthread_mutex_unlock(&watchdog.lock);
+}
+
+/**
+ * Start a watchdog thread that reports a virtual machine that is slow
+ * to start, and an unresponsive user interface. Reports are written
+ * into the log directory.
+ *
+ * @param startup_timeout Time after which the virtual machine should
+ *                        have started, in seconds (0 to disable).
+ * @param hang_threshold  Time after which the event dispatch thread is
+ *                        considered blocked, in seconds (0 to disable).
+ */
+void
+start_watchdog(unsigned startup_timeout, unsigned hang_threshold)
+{
+    pthread_t thread;
+    pthread_attr_t attr;
+
+    watchdog.startup_timeout = startup_timeout;
+    watchdog.hang_threshold = hang_threshold;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if ( pthread_create(&thread, &attr, watchdog_main, NULL) != 0 )
+        warn("Cannot start watchdog");
+    else
+        add_java_callback(on_java_created, NULL);
+    pthread_attr_destroy(&attr);
+}
+
+#endif
@@ -0,0 +1,404 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "zip.h"
+
+#if !defined(PROTEGE_WIN32)
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(HAVE_ZLIB_H)
+#include <zlib.h>
+#endif
+
+#include <xmem.h>
+
+/* Signatures of the zip records. */
+#define EOCD_SIGNATURE          0x06054b50
+#define EOCD64_SIGNATURE        0x06064b50
+#define EOCD64_LOCATOR_SIGNATURE 0x07064b50
+#define CENTRAL_HEADER_SIGNATURE 0x02014b50
+#define LOCAL_HEADER_SIGNATURE  0x04034b50
+
+/* Sizes of the fixed parts of the zip records. */
+#define EOCD_SIZE               22
+#define EOCD64_SIZE             56
+#define EOCD64_LOCATOR_SIZE     20
+#define CENTRAL_HEADER_SIZE     46
+#define LOCAL_HEADER_SIZE       30
+
+/* The end of central directory record is followed by a comment of at
+ * most 65535 bytes. */
+#define MAX_COMMENT_SIZE        0xFFFF
+
+/* Tag of the zip64 extended information extra field. */
+#define ZIP64_EXTRA_TAG         0x0001
+
+static uint16_t
+get_u16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t
+get_u32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint64_t
+get_u64(const unsigned char *p)
+{
+    return get_u32(p) | ((uint64_t) get_u32(p + 4) << 32);
+}
+
+/*
+ * Find the end of central directory record, looking backwards from
+ * the end of the archive.
+ *
+ * Returns a pointer to the record, or NULL if the file is not a zip
+ * archive.
+ */
+static const unsigned char *
+find_end_record(const struct zip_archive *zip)
+{
+    const unsigned char *p, *lowest;
+
+    if ( zip->size < EOCD_SIZE )
+        return NULL;
+
+    lowest = zip->size > EOCD_SIZE + MAX_COMMENT_SIZE ?
+        zip->data + zip->size - EOCD_SIZE - MAX_COMMENT_SIZE : zip->data;
+
+    for ( p = zip->data + zip->size - EOCD_SIZE; p >= lowest; p-- )
+        if ( get_u32(p) == EOCD_SIGNATURE
+                && p + EOCD_SIZE + get_u16(p + 20) == zip->data + zip->size )
+            return p;
+
+    return NULL;
+}
+
+/*
+ * Locate the central directory, using the zip64 end of central
+ * directory record if the archive has one.
+ *
+ * Returns 0 if successful, otherwise -1.
+ */
+static int
+find_central_directory(struct zip_archive *zip)
+{
+    const unsigned char *eocd, *locator, *eocd64;
+    uint64_t offset, size;
+
+    if ( ! (eocd = find_end_record(zip)) )
+        return -1;
+
+    zip->count = get_u16(eocd + 10);
+    size = get_u32(eocd + 12);
+    offset = get_u32(eocd + 16);
+
+    if ( eocd - zip->data >= EOCD64_LOCATOR_SIZE
+            && get_u32((locator = eocd - EOCD64_LOCATOR_SIZE)) == EOCD64_LOCATOR_SIGNATURE ) {
+        offset = get_u64(locator + 8);
+        if ( offset > zip->size - EOCD64_SIZE )
+            return -1;
+
+        eocd64 = zip->data + offset;
+        if ( get_u32(eocd64) != EOCD64_SIGNATURE )
+            return -1;
+
+        zip->count = get_u64(eocd64 + 32);
+        size = get_u64(eocd64 + 40);
+        offset = get_u64(eocd64 + 48);
+    }
+
+    if ( offset > zip->size || size > zip->size - offset )
+        return -1;
+
+    zip->directory = zip->data + offset;
+    zip->directory_size = size;
+
+    return 0;
+}
+
+/**
+ * Map a zip archive in memory and locate its central directory.
+ *
+ * @param path The pathname to the archive.
+ * @param zip  A structure to fill; it must be released with zip_close.
+ *
+ * @return 0 if successful, or -1 if the file cannot be read or is not
+ *         a zip archive.
+ */
+int
+zip_open(const char *path, struct zip_archive *zip)
+{
+    int fd;
+    struct stat st;
+    void *data;
+
+    memset(zip, 0, sizeof(struct zip_archive));
+
+    if ( (fd = open(path, O_RDONLY)) == -1 )
+        return -1;
+
+    if ( fstat(fd, &st) == -1 || st.st_size == 0 ) {
+        close(fd);
+        return -1;
+    }
+
+    data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ( data == MAP_FAILED )
+        return -1;
+
+    zip->data = data;
+    zip->size = st.st_size;
+
+    if ( find_central_directory(zip) == -1 ) {
+        zip_close(zip);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Unmap a zip archive.
+ *
+ * @param zip The archive to close.
+ */
+void
+zip_close(struct zip_archive *zip)
+{
+    if ( zip->data )
+        (void) munmap((void *) zip->data, zip->size);
+
+    memset(zip, 0, sizeof(struct zip_archive));
+}
+
+/*
+ * Replace the sizes and offset of an entry with the values found in
+ * its zip64 extra field, for those that do not fit in 32 bits.
+ */
+static void
+read_zip64_extra(const unsigned char *extra, size_t len, struct zip_entry *entry)
+{
+    const unsigned char *end = extra + len, *p;
+    uint16_t tag, size;
+
+    while ( extra + 4 <= end ) {
+        tag = get_u16(extra);
+        size = get_u16(extra + 2);
+        p = extra + 4;
+        if ( p + size > end )
+            return;
+
+        if ( tag == ZIP64_EXTRA_TAG ) {
+            /* Fields are only present if the 32-bit value is saturated,
+             * and always in that order. */
+            if ( entry->size == 0xFFFFFFFF && p + 8 <= extra + 4 + size ) {
+                entry->size = get_u64(p);
+                p += 8;
+            }
+            if ( entry->compressed_size == 0xFFFFFFFF && p + 8 <= extra + 4 + size ) {
+                entry->compressed_size = get_u64(p);
+                p += 8;
+            }
+            if ( entry->offset == 0xFFFFFFFF && p + 8 <= extra + 4 + size )
+                entry->offset = get_u64(p);
+            return;
+        }
+
+        extra += 4 + size;
+    }
+}
+
+/**
+ * Read the next entry of the central directory.
+ *
+ * @param[in] zip          The archive.
+ * @param[in,out] position The position of the entry to read within the
+ *                         central directory; should initially be 0.
+ *                         Updated to point to the next entry.
+ * @param[out] entry       A structure to fill with the entry.
+ *
+ * @return 1 if an entry has been read, 0 if there are no more entries,
+ *         or -1 if the central directory is corrupted.
+ */
+int
+zip_next_entry(const struct zip_archive *zip, size_t *position, struct zip_entry *entry)
+{
+    const unsigned char *p;
+    size_t name_len, extra_len, comment_len, total;
+
+    if ( *position >= zip->directory_size )
+        return 0;
+
+    if ( zip->directory_size - *position < CENTRAL_HEADER_SIZE )
+        return -1;
+
+    p = zip->directory + *position;
+    if ( get_u32(p) != CENTRAL_HEADER_SIGNATURE )
+        return -1;
+
+    name_len = get_u16(p + 28);
+    extra_len = get_u16(p + 30);
+    comment_len = get_u16(p + 32);
+    total = CENTRAL_HEADER_SIZE + name_len + extra_len + comment_len;
+    if ( zip->directory_size - *position < total )
+        return -1;
+
+    entry->method = get_u16(p + 10);
+    entry->compressed_size = get_u32(p + 20);
+    entry->size = get_u32(p + 24);
+    entry->offset = get_u32(p + 42);
+    entry->name = (const char *) p + CENTRAL_HEADER_SIZE;
+    entry->name_len = name_len;
+
+    read_zip64_extra(p + CENTRAL_HEADER_SIZE + name_len, extra_len, entry);
+
+    *position += total;
+    return 1;
+}
+
+/**
+ * Check whether the name of an entry ends with the given suffix.
+ *
+ * @param entry  The entry to check.
+ * @param suffix The expected suffix.
+ *
+ * @return Non-zero if the name ends with the suffix, otherwise 0.
+ */
+int
+zip_has_suffix(const struct zip_entry *entry, const char *suffix)
+{
+    size_t len = strlen(suffix);
+
+    return entry->name_len >= len
+        && memcmp(entry->name + entry->name_len - len, suffix, len) == 0;
+}
+
+/**
+ * Find an entry by name.
+ *
+ * @param[in] zip    The archive.
+ * @param[in] name   The full name of the entry.
+ * @param[out] entry A structure to fill with the entry.
+ *
+ * @return 0 if the entry has been found, otherwise -1.
+ */
+int
+zip_find_entry(const struct zip_archive *zip, const char *name, struct zip_entry *entry)
+{
+    size_t position = 0, len = strlen(name);
+
+    while ( zip_next_entry(zip, &position, entry) == 1 )
+        if ( entry->name_len == len && memcmp(entry->name, name, len) == 0 )
+            return 0;
+
+    return -1;
+}
+
+/**
+ * Extract an entry into memory. Deflated entries can only be extracted
+ * if the launcher has been built with zlib.
+ *
+ * @param zip      The archive.
+ * @param entry    The entry to extract.
+ * @param max_size Refuse to extract entries larger than that.
+ *
+ * @return A newly allocated, NUL-terminated buffer containing the
+ *         data of the entry, or NULL if the entry cannot be extracted.
+ */
+char *
+zip_extract_entry(const struct zip_archive *zip, const struct zip_entry *entry,
+                  size_t max_size)
+{
+    const unsigned char *local, *data;
+    char *buffer;
+    uint64_t offset;
+
+    if ( entry->size > max_size || zip->size < LOCAL_HEADER_SIZE
+            || entry->offset > zip->size - LOCAL_HEADER_SIZE )
+        return NULL;
+
+    local = zip->data + entry->offset;
+    if ( get_u32(local) != LOCAL_HEADER_SIGNATURE )
+        return NULL;
+
+    /* The local header may have a different extra field than the
+     * central directory. */
+    offset = entry->offset + LOCAL_HEADER_SIZE + get_u16(local + 26) + get_u16(local + 28);
+    if ( offset > zip->size || entry->compressed_size > zip->size - offset )
+        return NULL;
+    data = zip->data + offset;
+
+    buffer = xmalloc(entry->size + 1);
+    buffer[entry->size] = '\0';
+
+    if ( entry->method == ZIP_METHOD_STORED && entry->compressed_size == entry->size ) {
+        memcpy(buffer, data, entry->size);
+        return buffer;
+    }
+
+#if defined(HAVE_ZLIB_H)
+    if ( entry->method == ZIP_METHOD_DEFLATED ) {
+        z_stream strm;
+        int ret;
+
+        memset(&strm, 0, sizeof(strm));
+        if ( inflateInit2(&strm, -MAX_WBITS) == Z_OK ) {
+            strm.next_in = (unsigned char *) data;
+            strm.avail_in = entry->compressed_size;
+            strm.next_out = (unsigned char *) buffer;
+            strm.avail_out = entry->size;
+
+            ret = inflate(&strm, Z_FINISH);
+            inflateEnd(&strm);
+            if ( ret == Z_STREAM_END && strm.total_out == entry->size )
+                return buffer;
+        }
+    }
+#endif
+
+    free(buffer);
+    return NULL;
+}
+
+#endif
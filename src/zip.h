@@ -0,0 +1,93 @@
+/*
+ * Protégé launcher
+ * Copyright (C) 2026 Damien Goutte-Gattat
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. The name of the author may not be used to endorse or promote
+ *    products derived from this software without specific prior written
+ *    permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR
+ * OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef ICP20261018_ZIP_H
+#define ICP20261018_ZIP_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * A zip archive mapped in memory.
+ */
+struct zip_archive {
+    const unsigned char    *data;
+    size_t                  size;
+    const unsigned char    *directory;      /* Central directory. */
+    size_t                  directory_size;
+    uint64_t                count;          /* Number of entries. */
+};
+
+/*
+ * An entry of the central directory. The name is not NUL-terminated,
+ * and points into the mapped archive.
+ */
+struct zip_entry {
+    const char *name;
+    size_t      name_len;
+    unsigned    method;             /* 0 (stored) or 8 (deflated). */
+    uint64_t    compressed_size;
+    uint64_t    size;               /* Uncompressed size. */
+    uint64_t    offset;             /* Offset of the local header. */
+};
+
+#define ZIP_METHOD_STORED   0
+#define ZIP_METHOD_DEFLATED 8
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(PROTEGE_WIN32)
+int
+zip_open(const char *path, struct zip_archive *zip);
+
+void
+zip_close(struct zip_archive *zip);
+
+int
+zip_next_entry(const struct zip_archive *zip, size_t *position, struct zip_entry *entry);
+
+int
+zip_has_suffix(const struct zip_entry *entry, const char *suffix);
+
+int
+zip_find_entry(const struct zip_archive *zip, const char *name, struct zip_entry *entry);
+
+char *
+zip_extract_entry(const struct zip_archive *zip, const struct zip_entry *entry,
+                  size_t max_size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* !ICP20261018_ZIP_H */